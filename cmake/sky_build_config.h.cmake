@@ -7,11 +7,17 @@
 #cmakedefine SKY_HAVE_ACCEPT4
 #cmakedefine SKY_HAVE_BUILTIN_BSWAP
 #cmakedefine SKY_HAVE_EPOLL
+#cmakedefine SKY_HAVE_IO_URING
 #cmakedefine SKY_HAVE_KQUEUE
 #cmakedefine SKY_HAVE_MALLOC
 #cmakedefine SKY_HAVE_ATOMIC
 
 #cmakedefine SKY_HAVE_EVENT_FD
+#cmakedefine SKY_HAVE_INOTIFY
+#cmakedefine SKY_HAVE_PTHREAD_AFFINITY
+
+/* Debug statistics */
+#cmakedefine SKY_HAVE_POOL_STATS
 
 /* Compiler builtins for specific CPU instruction support */
 #cmakedefine SKY_HAVE_BUILTIN_IA32_CRC32
@@ -26,6 +32,7 @@
 #cmakedefine SKY_HAVE_LIBUCONTEXT
 #cmakedefine SKY_HAVE_OPENSSL
 #cmakedefine SKY_HAVE_SSL
+#cmakedefine SKY_HAVE_ZLIB
 
 #endif
 
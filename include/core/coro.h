@@ -6,6 +6,7 @@
 #define SKY_CORO_H
 
 #include "types.h"
+#include "histogram.h"
 
 #if defined(__cplusplus)
 } /* extern "C" { */
@@ -48,6 +49,30 @@ sky_coro_t *sky_coro_new();
  */
 sky_coro_t *sky_coro_new_with_stack(sky_usize_t stack_size);
 
+/**
+ * 配置默认栈协程的复用池，每个线程独立缓存，需在创建协程前调用
+ * @param free_max  每个线程最多缓存的空闲协程数，0则不缓存
+ * @param trim_idle 空闲时是否通过MADV_DONTNEED归还栈内存
+ */
+void sky_coro_pool_config(sky_u32_t free_max, sky_bool_t trim_idle);
+
+/**
+ * 释放当前线程缓存的空闲协程，线程退出时会自动调用
+ */
+void sky_coro_pool_clean();
+
+/**
+ * 开启栈使用统计，新协程栈填充canary，销毁时统计最高水位，开启后栈回收(trim_idle)失效
+ * @param enable 是否开启
+ */
+void sky_coro_profile_enable(sky_bool_t enable);
+
+/**
+ * 获取所有线程汇总的栈使用统计，数值为每个协程栈使用的最高水位(字节)
+ * @param profile 统计结果，原有内容会被清空
+ */
+void sky_coro_profile_get(sky_histogram_t *profile);
+
 /**
  * 协程配置函数
  * @param coro 协程
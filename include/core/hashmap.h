@@ -0,0 +1,105 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#ifndef SKY_HASHMAP_H
+#define SKY_HASHMAP_H
+
+#include "types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct sky_hashmap_s sky_hashmap_t;
+typedef struct sky_hashmap_slot_s sky_hashmap_slot_t;
+
+/**
+ * 比较元素与查找的key是否相等
+ * @param item 表中元素
+ * @param key  查找的key
+ * @return 是否相等
+ */
+typedef sky_bool_t (*sky_hashmap_equals_pt)(const void *item, const void *key);
+
+/**
+ * 开放寻址哈希表(Swiss table)：控制字节按16个一组探测，支持SSE2时单条指令比较一组，
+ * 表中只保存元素指针与hash，hash由调用方计算，非线程安全
+ */
+struct sky_hashmap_s {
+    sky_u8_t *ctrl;
+    sky_hashmap_slot_t *slots;
+    sky_hashmap_equals_pt equals;
+    sky_usize_t mask;
+    sky_usize_t size;
+    sky_usize_t growth_left;
+};
+
+struct sky_hashmap_slot_s {
+    void *item;
+    sky_u64_t hash;
+};
+
+/**
+ * 初始化，不申请内存，首次插入时分配
+ * @param map    哈希表
+ * @param equals 比较函数
+ */
+void sky_hashmap_init(sky_hashmap_t *map, sky_hashmap_equals_pt equals);
+
+/**
+ * 释放哈希表内存，元素本身由调用方释放
+ * @param map 哈希表
+ */
+void sky_hashmap_destroy(sky_hashmap_t *map);
+
+/**
+ * 查找元素
+ * @param map  哈希表
+ * @param hash key的hash
+ * @param key  查找的key，传给比较函数
+ * @return 元素，不存在返回null
+ */
+void *sky_hashmap_get(const sky_hashmap_t *map, sky_u64_t hash, const void *key);
+
+/**
+ * 插入元素，调用方保证相同key不存在
+ * @param map  哈希表
+ * @param hash 元素key的hash
+ * @param item 元素
+ * @return 内存不足返回false
+ */
+sky_bool_t sky_hashmap_put(sky_hashmap_t *map, sky_u64_t hash, void *item);
+
+/**
+ * 按元素指针删除
+ * @param map  哈希表
+ * @param hash 元素key的hash
+ * @param item 元素
+ * @return 元素是否存在
+ */
+sky_bool_t sky_hashmap_del(sky_hashmap_t *map, sky_u64_t hash, const void *item);
+
+/**
+ * 遍历元素，遍历期间不能插入
+ * @param map  哈希表
+ * @param iter 遍历位置，初始为0
+ * @return 元素，结束返回null
+ */
+void *sky_hashmap_next(const sky_hashmap_t *map, sky_usize_t *iter);
+
+static sky_inline sky_usize_t
+sky_hashmap_size(const sky_hashmap_t *const map) {
+    return map->size;
+}
+
+static sky_inline sky_bool_t
+sky_hashmap_is_empty(const sky_hashmap_t *const map) {
+    return !map->size;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_HASHMAP_H
@@ -0,0 +1,113 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#ifndef SKY_HISTOGRAM_H
+#define SKY_HISTOGRAM_H
+
+#include "types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SKY_HISTOGRAM_SUB_BITS  6 // 每个2的幂区间细分 2^(SUB_BITS-1) 个桶，相对误差 <= 1/32
+#define SKY_HISTOGRAM_MAX_BITS  40 // 可区分的最大值 2^40，超出计入最后一个桶
+#define SKY_HISTOGRAM_SUB_N     (SKY_U32(1) << SKY_HISTOGRAM_SUB_BITS)
+#define SKY_HISTOGRAM_HALF_N    (SKY_HISTOGRAM_SUB_N >> 1)
+#define SKY_HISTOGRAM_BUCKET_N  \
+    (SKY_HISTOGRAM_SUB_N + (SKY_HISTOGRAM_MAX_BITS - SKY_HISTOGRAM_SUB_BITS) * SKY_HISTOGRAM_HALF_N)
+
+/**
+ * 对数线性分桶直方图(HDR)：小于 SUB_N 的值精确计数，之后每个2的幂区间等分为 HALF_N 个桶，
+ * 内存固定(约9KB)，记录为O(1)，数值单位由调用方决定。
+ * 单写者：记录只能在一个线程中进行，其他线程可同时读取或合并(sky_histogram_merge)
+ */
+typedef struct {
+    sky_u64_t count;
+    sky_u64_t sum;
+    sky_u64_t min;
+    sky_u64_t max;
+    sky_u64_t buckets[SKY_HISTOGRAM_BUCKET_N];
+} sky_histogram_t;
+
+void sky_histogram_init(sky_histogram_t *h);
+
+/**
+ * 合并，src 可以是其他线程正在记录的直方图
+ * @param dst 合并到的直方图
+ * @param src 被合并的直方图
+ */
+void sky_histogram_merge(sky_histogram_t *dst, const sky_histogram_t *src);
+
+/**
+ * 查询百分位值，返回值所在桶的上界(不超过记录的最大值)
+ * @param h       直方图
+ * @param percent 百分位，范围 [0, 100]
+ * @return 百分位值，无记录返回0
+ */
+sky_u64_t sky_histogram_percentile(const sky_histogram_t *h, sky_f64_t percent);
+
+/**
+ * @return 小于等于 value 的记录数，value 不在桶边界时按所在桶整体计入
+ */
+sky_u64_t sky_histogram_count_le(const sky_histogram_t *h, sky_u64_t value);
+
+static sky_inline sky_u32_t
+sky_histogram_index(const sky_u64_t value) {
+    if (value < SKY_HISTOGRAM_SUB_N) {
+        return (sky_u32_t) value;
+    }
+    const sky_u32_t shift = (sky_u32_t) (63 - __builtin_clzll(value)) - (SKY_HISTOGRAM_SUB_BITS - 1);
+    const sky_u32_t index = SKY_HISTOGRAM_SUB_N
+                            + (shift - 1) * SKY_HISTOGRAM_HALF_N
+                            + (sky_u32_t) (value >> shift) - SKY_HISTOGRAM_HALF_N;
+
+    return index < SKY_HISTOGRAM_BUCKET_N ? index : SKY_HISTOGRAM_BUCKET_N - 1;
+}
+
+static sky_inline void
+sky_histogram_record(sky_histogram_t *const h, const sky_u64_t value) {
+    const sky_u32_t index = sky_histogram_index(value);
+
+    __atomic_store_n(&h->buckets[index], h->buckets[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum, h->sum + value, __ATOMIC_RELAXED);
+    if (sky_unlikely(value < h->min)) {
+        __atomic_store_n(&h->min, value, __ATOMIC_RELAXED);
+    }
+    if (sky_unlikely(value > h->max)) {
+        __atomic_store_n(&h->max, value, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELEASE);
+}
+
+static sky_inline sky_u64_t
+sky_histogram_count(const sky_histogram_t *const h) {
+    return h->count;
+}
+
+static sky_inline sky_u64_t
+sky_histogram_sum(const sky_histogram_t *const h) {
+    return h->sum;
+}
+
+static sky_inline sky_u64_t
+sky_histogram_min(const sky_histogram_t *const h) {
+    return h->count ? h->min : 0;
+}
+
+static sky_inline sky_u64_t
+sky_histogram_max(const sky_histogram_t *const h) {
+    return h->max;
+}
+
+static sky_inline sky_f64_t
+sky_histogram_mean(const sky_histogram_t *const h) {
+    return h->count ? (sky_f64_t) h->sum / (sky_f64_t) h->count : 0;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_HISTOGRAM_H
@@ -5,24 +5,74 @@
 #ifndef SKY_LOG_H
 #define SKY_LOG_H
 
+#include "types.h"
 #include <stdio.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
+#define SKY_LOG_DEBUG SKY_U8(0)
+#define SKY_LOG_INFO  SKY_U8(1)
+#define SKY_LOG_WARN  SKY_U8(2)
+#define SKY_LOG_ERROR SKY_U8(3)
+
+typedef struct {
+    sky_u32_t ring_size; // 每个线程的环形缓冲大小，0则默认64KB
+    sky_i32_t fd; // 输出fd，0则使用stdout
+    sky_u8_t level;
+} sky_log_conf_t;
+
+/**
+ * 当前输出级别，低于该级别的日志直接跳过，不计算参数
+ */
+extern sky_u8_t sky_log_level;
+
+/**
+ * 初始化日志，需在第一次写日志前调用，未调用时首次写日志使用默认配置
+ * 日志以二进制记录写入线程独立的无锁环形缓冲，由后台线程格式化并输出，缓冲满时丢弃
+ * @param conf 配置，可为null
+ * @return 后台线程启动失败返回false，此时日志同步输出
+ */
+sky_bool_t sky_log_init(const sky_log_conf_t *conf);
+
+/**
+ * 写入一条日志，format 必须为常量字符串，%s 参数会被复制，单条记录上限4KB，超出部分截断
+ */
+void sky_log_write(sky_u8_t level, const char *file, sky_u32_t line, const char *format, ...)
+__attribute__((format(printf, 4, 5)));
+
+/**
+ * 阻塞至调用前写入的日志全部输出
+ */
+void sky_log_flush();
+
+/**
+ * @return 缓冲区满而丢弃的日志条数
+ */
+sky_u64_t sky_log_dropped();
+
+static sky_inline void
+sky_log_set_level(const sky_u8_t level) {
+    sky_log_level = level;
+}
+
+#define sky_log_print(_level, format, ...)                                      \
+    do {                                                                        \
+        if ((_level) >= sky_log_level) {                                        \
+            sky_log_write(_level, __FILE__, __LINE__, "" format, ##__VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+
 #ifdef NDEBUG
 #define sky_log_debug(format, ...)
-#define sky_log_info(format, ...)    printf("[INFO] (%s:%d) " format "\n",__FILE__, __LINE__, ##__VA_ARGS__)
-#define sky_log_warn(format, ...)    printf("[WARN] (%s:%d) " format "\n", __FILE__, __LINE__, ##__VA_ARGS__)
-#define sky_log_error(format, ...)   printf("[ERROR] (%s:%d) " format "\n",__FILE__, __LINE__, ##__VA_ARGS__)
 #else
-#define sky_log_debug(format, ...)    printf("[DEBUG] (%s:%d) " format "\n",__FILE__, __LINE__, ##__VA_ARGS__)
-#define sky_log_info(format, ...)    printf("\033[0;34m[INFO] (%s:%d) " format "\n\033[0m",__FILE__, __LINE__, ##__VA_ARGS__)
-#define sky_log_warn(format, ...)    printf("\033[0;32m[WARN] (%s:%d) " format "\n\033[0m", __FILE__, __LINE__, ##__VA_ARGS__)
-#define sky_log_error(format, ...)   printf("\033[0;31m[ERROR] (%s:%d) " format "\n\033[0m",__FILE__, __LINE__, ##__VA_ARGS__)
-
+#define sky_log_debug(format, ...)   sky_log_print(SKY_LOG_DEBUG, format, ##__VA_ARGS__)
 #endif
+#define sky_log_info(format, ...)    sky_log_print(SKY_LOG_INFO, format, ##__VA_ARGS__)
+#define sky_log_warn(format, ...)    sky_log_print(SKY_LOG_WARN, format, ##__VA_ARGS__)
+#define sky_log_error(format, ...)   sky_log_print(SKY_LOG_ERROR, format, ##__VA_ARGS__)
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
@@ -24,11 +24,39 @@ typedef struct {
     sky_isize_t failed;
 } sky_pool_data_t;
 
+#ifdef SKY_HAVE_POOL_STATS
+
+typedef struct {
+    sky_usize_t bytes; // 当前小块分配字节
+    sky_usize_t large_bytes; // 当前大块分配字节
+    sky_usize_t peak; // 小块与大块合计的峰值
+    sky_u32_t block_n; // 本周期使用的内存块数量，含首块
+    sky_u32_t large_n; // 大块分配次数
+    sky_u32_t failed_n; // 块空间不足跳过的次数
+} sky_pool_stats_t;
+
+typedef struct {
+    sky_u64_t create_n; // 创建数量
+    sky_u64_t destroy_n; // 销毁数量，与create_n之差即未释放的内存池
+    sky_u64_t cycle_n; // 使用周期数(destroy + reset)
+    sky_u64_t overflow_n; // 超出首块容量的周期数
+    sky_u64_t block_n; // 超出首块后使用的块数
+    sky_u64_t large_n; // 大块分配次数
+    sky_u64_t large_bytes; // 大块分配字节
+    sky_u64_t peak_total; // 每周期峰值之和，用于求平均
+    sky_u64_t peak_max; // 单周期最大峰值
+} sky_pool_stats_total_t;
+
+#endif
+
 struct sky_pool_s {
     sky_pool_data_t d;
     sky_usize_t max;
     sky_pool_t *current;
     sky_pool_large_t *large;
+#ifdef SKY_HAVE_POOL_STATS
+    sky_pool_stats_t stats;
+#endif
 };
 
 sky_pool_t *sky_pool_create(sky_usize_t size);
@@ -47,6 +75,26 @@ void *sky_prealloc(sky_pool_t *pool, void *ptr, sky_usize_t ptr_size, sky_usize_
 
 void sky_pfree(sky_pool_t *pool, const void *ptr, sky_usize_t size);
 
+#ifdef SKY_HAVE_POOL_STATS
+
+/**
+ * 获取所有线程内存池的汇总统计，统计在 destroy/reset 时计入
+ * @param total 统计结果
+ */
+void sky_pool_stats_total(sky_pool_stats_total_t *total);
+
+/**
+ * 输出汇总统计，用于评估 SKY_POOL_DEFAULT_SIZE 等配置及未释放的内存池
+ */
+void sky_pool_stats_dump();
+
+static sky_inline const sky_pool_stats_t *
+sky_pool_stats(const sky_pool_t *const pool) {
+    return &pool->stats;
+}
+
+#endif
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
@@ -0,0 +1,69 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#ifndef SKY_SLAB_H
+#define SKY_SLAB_H
+
+#include "types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct sky_slab_s sky_slab_t;
+typedef struct sky_slab_obj_s sky_slab_obj_t;
+typedef struct sky_slab_block_s sky_slab_block_t;
+
+/**
+ * 定长对象分配器，按块批量申请内存，释放的对象进入空闲链表复用，非线程安全，每个事件循环各自持有
+ */
+struct sky_slab_s {
+    sky_slab_obj_t *free;
+    sky_slab_block_t *block;
+    sky_usize_t size;
+    sky_u32_t block_n;
+};
+
+struct sky_slab_obj_s {
+    sky_slab_obj_t *next;
+};
+
+/**
+ * 初始化分配器
+ * @param slab    分配器
+ * @param size    对象大小
+ * @param block_n 每块包含的对象数，0则默认64
+ */
+void sky_slab_init(sky_slab_t *slab, sky_usize_t size, sky_u32_t block_n);
+
+/**
+ * 释放分配器所有内存，未归还的对象同时失效
+ * @param slab 分配器
+ */
+void sky_slab_destroy(sky_slab_t *slab);
+
+void *sky_slab_alloc_block(sky_slab_t *slab);
+
+static sky_inline void *
+sky_slab_alloc(sky_slab_t *const slab) {
+    sky_slab_obj_t *const obj = slab->free;
+    if (sky_likely(obj)) {
+        slab->free = obj->next;
+        return obj;
+    }
+    return sky_slab_alloc_block(slab);
+}
+
+static sky_inline void
+sky_slab_free(sky_slab_t *const slab, void *const ptr) {
+    sky_slab_obj_t *const obj = ptr;
+    obj->next = slab->free;
+    slab->free = obj;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_SLAB_H
@@ -25,7 +25,11 @@ sky_timer_wheel_t *sky_timer_wheel_create(sky_u64_t now);
 
 void sky_timer_wheel_destroy(sky_timer_wheel_t *ctx);
 
-void sky_timer_wheel_run(sky_timer_wheel_t *ctx, sky_u64_t now);
+/**
+ * 执行到期的定时器
+ * @return 触发的定时器个数
+ */
+sky_u32_t sky_timer_wheel_run(sky_timer_wheel_t *ctx, sky_u64_t now);
 
 void sky_timer_wheel_get_expired(sky_timer_wheel_t *ctx, sky_queue_t *result, sky_u64_t now);
 
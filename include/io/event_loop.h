@@ -13,11 +13,20 @@ extern "C" {
 #endif
 
 typedef struct sky_event_loop_s sky_event_loop_t;
+typedef struct sky_event_loop_task_s sky_event_loop_task_t;
+
+typedef void (*sky_event_loop_post_pt)(sky_event_loop_t *loop, void *data);
 
 struct sky_event_loop_s {
     sky_timer_wheel_t *timer_ctx;
     sky_selector_t *selector;
-    sky_i64_t now;
+    sky_i64_t now; // 墙上时间(秒)
+    sky_u64_t now_ms; // 单调时钟(毫秒)，定时器基于该时间
+    sky_u64_t now_us; // 本轮回调开始时的精确单调时钟(微秒)，用于耗时统计
+    sky_event_loop_task_t *post_tasks; // 跨线程投递的任务(MPSC，逆序)
+    sky_socket_t post_fd; // eventfd 或 pipe 写端
+    sky_ev_t post_ev; // 唤醒事件
+    sky_queue_t metrics_link; // 统计汇总链表
 };
 
 sky_event_loop_t *sky_event_loop_create();
@@ -26,6 +35,27 @@ void sky_event_loop_run(sky_event_loop_t *loop);
 
 void sky_event_loop_destroy(sky_event_loop_t *loop);
 
+/**
+ * 向事件循环投递任务，可在任意线程调用，任务在事件循环线程中按投递顺序执行
+ * @param loop 事件循环
+ * @param cb   回调
+ * @param data 回调参数
+ * @return 是否投递成功
+ */
+sky_bool_t sky_event_loop_post(sky_event_loop_t *loop, sky_event_loop_post_pt cb, void *data);
+
+/**
+ * 汇总当前所有事件循环的统计，可在任意线程调用
+ * @param out 汇总结果
+ * @return 事件循环个数
+ */
+sky_u32_t sky_event_loop_metrics_collect(sky_selector_metrics_t *out);
+
+/**
+ * 读取精确的单调时钟(微秒)，仅用于耗时统计，起点可使用 sky_event_now_us 避免重复读取
+ */
+sky_u64_t sky_event_clock_us();
+
 
 static sky_inline void
 sky_event_timeout_init(
@@ -42,7 +72,16 @@ sky_event_timeout_set(
         sky_timer_wheel_entry_t *const timer,
         const sky_u32_t timout
 ) {
-    sky_timer_wheel_link(timer, (sky_u64_t) (loop->now + timout));
+    sky_timer_wheel_link(timer, loop->now_ms + (sky_u64_t) timout * 1000);
+}
+
+static sky_inline void
+sky_event_timeout_set_ms(
+        sky_event_loop_t *const loop,
+        sky_timer_wheel_entry_t *const timer,
+        const sky_u32_t timout_ms
+) {
+    sky_timer_wheel_link(timer, loop->now_ms + timout_ms);
 }
 
 static sky_inline void
@@ -51,7 +90,16 @@ sky_event_timeout_expired(
         sky_timer_wheel_entry_t *const timer,
         const sky_u32_t timout
 ) {
-    sky_timer_wheel_expired(timer, (sky_u64_t) (loop->now + timout));
+    sky_timer_wheel_expired(timer, loop->now_ms + (sky_u64_t) timout * 1000);
+}
+
+static sky_inline void
+sky_event_timeout_expired_ms(
+        sky_event_loop_t *const loop,
+        sky_timer_wheel_entry_t *const timer,
+        const sky_u32_t timout_ms
+) {
+    sky_timer_wheel_expired(timer, loop->now_ms + timout_ms);
 }
 
 static sky_inline sky_selector_t *
@@ -59,11 +107,26 @@ sky_event_selector(sky_event_loop_t *const loop) {
     return loop->selector;
 }
 
+static sky_inline sky_selector_metrics_t *
+sky_event_loop_metrics(sky_event_loop_t *const loop) {
+    return sky_selector_metrics(loop->selector);
+}
+
 static sky_inline sky_i64_t
 sky_event_now(const sky_event_loop_t *const loop) {
     return loop->now;
 }
 
+static sky_inline sky_u64_t
+sky_event_now_ms(const sky_event_loop_t *const loop) {
+    return loop->now_ms;
+}
+
+static sky_inline sky_u64_t
+sky_event_now_us(const sky_event_loop_t *const loop) {
+    return loop->now_us;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
@@ -0,0 +1,49 @@
+//
+// Created by beliefsky on 2023/11/4.
+//
+
+#ifndef SKY_EVENT_LOOP_GROUP_H
+#define SKY_EVENT_LOOP_GROUP_H
+
+#include "event_loop.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct sky_event_loop_group_s sky_event_loop_group_t;
+
+/**
+ * 每个事件循环线程启动时回调，在该线程内创建 server/client 等对象
+ * @param loop  当前线程的事件循环
+ * @param index 事件循环序号
+ * @param data  自定义参数
+ */
+typedef void (*sky_event_loop_group_pt)(sky_event_loop_t *loop, sky_u32_t index, void *data);
+
+/**
+ * 创建事件循环组
+ * @param num 事件循环数量，0则使用cpu核数
+ * @return 事件循环组
+ */
+sky_event_loop_group_t *sky_event_loop_group_create(sky_u32_t num);
+
+/**
+ * 启动所有事件循环，每个循环一个线程并绑定cpu，当前线程执行第0个循环，阻塞至所有循环结束
+ * @param group 事件循环组
+ * @param cb    线程启动回调
+ * @param data  回调参数
+ */
+void sky_event_loop_group_run(sky_event_loop_group_t *group, sky_event_loop_group_pt cb, void *data);
+
+void sky_event_loop_group_destroy(sky_event_loop_group_t *group);
+
+sky_u32_t sky_event_loop_group_size(const sky_event_loop_group_t *group);
+
+sky_event_loop_t *sky_event_loop_group_get(const sky_event_loop_group_t *group, sky_u32_t index);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_EVENT_LOOP_GROUP_H
@@ -97,12 +97,20 @@ typedef struct {
     sky_usize_t body_str_max;
     sky_u32_t keepalive;
     sky_u32_t timeout;
+    sky_u32_t timeout_ms; // 优先于 timeout
     sky_u32_t header_buf_size;
+    sky_u32_t ssl_session_max; // 连接全部关闭后仍保留 TLS 会话的域名数上限，0则默认64
     sky_u16_t domain_conn_max;
     sky_u8_t header_buf_n;
     sky_bool_t ssl_need_verify;
 } sky_http_client_conf_t;
 
+typedef struct {
+    sky_u64_t hit; // 复用会话的握手次数
+    sky_u64_t miss; // 完整握手次数
+    sky_u32_t cached; // 当前缓存的会话数
+} sky_http_client_session_stat_t;
+
 sky_http_client_t *sky_http_client_create(
         sky_event_loop_t *ev_loop,
         const sky_http_client_conf_t *conf
@@ -110,6 +118,11 @@ sky_http_client_t *sky_http_client_create(
 
 void sky_http_client_destroy(sky_http_client_t *client);
 
+/**
+ * TLS 会话缓存统计，会话按域名(host+port)缓存，新建连接时用于简化握手
+ */
+void sky_http_client_session_stat(const sky_http_client_t *client, sky_http_client_session_stat_t *stat);
+
 sky_http_client_req_t *sky_http_client_req_create(sky_pool_t *pool, const sky_str_t *url);
 
 void sky_http_client_req(
@@ -6,6 +6,8 @@
 #define SKY_HTTP_SERVER_H
 
 #include "../event_loop.h"
+#include "../tls.h"
+#include "../thread_pool.h"
 #include "../../core/string.h"
 #include "../../core/palloc.h"
 #include "../../core/list.h"
@@ -23,6 +25,10 @@ extern "C" {
 #define SKY_HTTP_OPTIONS                   0x0020
 #define SKY_HTTP_PATCH                     0x0040
 
+#define SKY_HTTP_ENCODING_GZIP             0x01
+#define SKY_HTTP_ENCODING_DEFLATE          0x02
+#define SKY_HTTP_ENCODING_BR               0x04
+
 typedef struct sky_http_server_conf_s sky_http_server_conf_t;
 typedef struct sky_http_server_s sky_http_server_t;
 typedef struct sky_http_server_module_s sky_http_server_module_t;
@@ -30,6 +36,7 @@ typedef struct sky_http_connection_s sky_http_connection_t;
 typedef struct sky_http_server_request_s sky_http_server_request_t;
 typedef struct sky_http_server_header_s sky_http_server_header_t;
 typedef struct sky_http_server_multipart_s sky_http_server_multipart_t;
+typedef struct sky_http_access_log_s sky_http_access_log_t;
 
 typedef void (*sky_http_server_module_run_pt)(sky_http_server_request_t *r, void *module_data);
 
@@ -67,12 +74,27 @@ typedef void (*sky_http_server_multipart_read_pt)(
 );
 
 
+/**
+ * 响应压缩(gzip/deflate)配置，依赖 zlib，编译时未找到 zlib 则不生效
+ */
+typedef struct {
+    const sky_str_t *types; // 压缩的 Content-Type，以'*'结尾时按前缀匹配，null则使用默认文本类型
+    sky_u32_t type_n;
+    sky_u32_t min_size; // 小于该大小不压缩，0则默认1024
+    sky_u32_t offload_size; // 大于该大小时交给线程池压缩，0则不使用
+    sky_thread_pool_t *thread_pool; // 可为null，多个 server 可共享
+    sky_u8_t level; // 压缩级别1-9，0则默认6
+} sky_http_server_gzip_conf_t;
+
 struct sky_http_server_conf_s {
     sky_usize_t body_str_max;
     sky_u32_t keep_alive;
     sky_u32_t timeout;
+    sky_u32_t timeout_ms; // 优先于 timeout
     sky_u32_t header_buf_size;
     sky_u8_t header_buf_n;
+    sky_http_access_log_t *access_log; // 访问日志，可为null
+    const sky_http_server_gzip_conf_t *gzip; // 响应压缩，可为null
 };
 
 struct sky_http_server_module_s {
@@ -82,6 +104,8 @@ struct sky_http_server_module_s {
     void *module_data;
 };
 
+#define SKY_HTTP_PATH_PARAM_MAX 8
+
 struct sky_http_server_request_s {
     sky_str_t method_name;
     sky_str_t uri;
@@ -101,6 +125,7 @@ struct sky_http_server_request_s {
         sky_str_t *transfer_encoding;
         sky_str_t *range;
         sky_str_t *if_range;
+        sky_str_t *accept_encoding;
 
         sky_usize_t content_length_n;
     } headers_in;
@@ -110,6 +135,9 @@ struct sky_http_server_request_s {
         sky_str_t content_type;
     } headers_out;
 
+    sky_str_t path_params[SKY_HTTP_PATH_PARAM_MAX]; // 路由参数，指向uri，不额外分配
+    const sky_str_t *path_param_names;
+
     sky_usize_t index;
     sky_uchar_t *req_pos;
 
@@ -125,6 +153,7 @@ struct sky_http_server_request_s {
     sky_bool_t error: 1;
     sky_bool_t response: 1;
     sky_bool_t chunked: 1;
+    sky_u8_t path_param_n;
 };
 
 struct sky_http_server_header_s {
@@ -154,8 +183,33 @@ sky_bool_t sky_http_server_module_put(sky_http_server_t *server, sky_http_server
 
 sky_bool_t sky_http_server_bind(sky_http_server_t *server, const sky_inet_address_t *address);
 
+/**
+ * 绑定 HTTPS 监听，连接在握手完成后按 HTTP/1.1 处理
+ * @param server  server
+ * @param address 地址
+ * @param tls_ctx 服务端 tls 上下文(is_server)，可被多个事件循环共享，需在 server 停止后销毁
+ * @return 是否成功
+ */
+sky_bool_t sky_http_server_bind_tls(
+        sky_http_server_t *server,
+        const sky_inet_address_t *address,
+        sky_tls_ctx_t *tls_ctx
+);
+
+/**
+ * 销毁 server，关闭监听并释放连接与内存池，需在事件循环停止后调用
+ */
+void sky_http_server_destroy(sky_http_server_t *server);
+
 sky_bool_t sky_http_url_decode(sky_str_t *str);
 
+/**
+ * 解析请求的 Accept-Encoding，q=0 视为不接受
+ * @param r 请求
+ * @return 接受的编码，SKY_HTTP_ENCODING_* 组合
+ */
+sky_u8_t sky_http_req_accept_encoding(const sky_http_server_request_t *r);
+
 void sky_http_req_body_none(sky_http_server_request_t *r, sky_http_server_next_pt call, void *data);
 
 void sky_http_req_body_str(sky_http_server_request_t *r, sky_http_server_next_str_pt call, void *data);
@@ -190,6 +244,28 @@ void sky_http_response_str_len(
         void *cb_data
 );
 
+/**
+ * 发送已编码的完整响应(状态行、响应头、响应体)，不再附加任何响应头
+ * @param data 需保持有效至 call 执行
+ */
+void sky_http_response_raw(
+        sky_http_server_request_t *r,
+        const sky_uchar_t *data,
+        sky_usize_t data_len,
+        sky_http_server_next_pt call,
+        void *cb_data
+);
+
+/**
+ * 获取响应头 Date 的值(29字节)，每秒更新
+ * @param sec 输出值对应的秒数，可为null
+ */
+const sky_uchar_t *sky_http_response_date(sky_http_server_request_t *r, sky_time_t *sec);
+
+/**
+ * 当前 Content-Type 且响应体为 size 字节时是否会进行响应压缩，不考虑请求的 Accept-Encoding
+ */
+sky_bool_t sky_http_response_compressible(const sky_http_server_request_t *r, sky_usize_t size);
 
 void sky_http_response_file(
         sky_http_server_request_t *r,
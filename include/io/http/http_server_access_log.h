@@ -0,0 +1,39 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#ifndef SKY_HTTP_SERVER_ACCESS_LOG_H
+#define SKY_HTTP_SERVER_ACCESS_LOG_H
+
+#include "http_server.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * 打开访问日志文件，可被多个事件循环的 server 共享(sky_http_server_conf_t.access_log)。
+ * 每个 server 在请求结束时写入定长二进制记录，缓冲满或每秒批量格式化后以 writev 追加到文件。
+ * 首次创建时注册 SIGUSR1，收到信号后在下一次写入前重新打开文件，用于日志切割
+ * @param path 文件路径
+ * @return 打开失败返回null
+ */
+sky_http_access_log_t *sky_http_access_log_create(const sky_str_t *path);
+
+/**
+ * 重新打开日志文件，可在信号处理函数中调用
+ * @param log 访问日志
+ */
+void sky_http_access_log_reopen(sky_http_access_log_t *log);
+
+/**
+ * 关闭日志文件，需在所有使用它的 server 停止后调用
+ * @param log 访问日志
+ */
+void sky_http_access_log_destroy(sky_http_access_log_t *log);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_HTTP_SERVER_ACCESS_LOG_H
@@ -19,12 +19,22 @@ typedef struct sky_http_mapper_s sky_http_mapper_t;
 typedef void (*sky_http_mapper_pt)(sky_http_server_request_t *req);
 
 
+/**
+ * path 按 '/' 分段，参数段:
+ * {name}     匹配任意非空段
+ * {name:int} 只匹配数字段
+ * {name:*}   或 * 匹配剩余全部路径，只能位于末尾
+ * 同一位置优先级: 静态段 > int > 普通参数 > 通配
+ */
 struct sky_http_mapper_s {
     sky_str_t path;
     sky_http_mapper_pt get;
     sky_http_mapper_pt post;
     sky_http_mapper_pt put;
     sky_http_mapper_pt delete;
+    sky_http_mapper_pt patch;
+    sky_http_mapper_pt head;
+    sky_http_mapper_pt options;
 };
 
 typedef struct {
@@ -41,6 +51,21 @@ sky_http_server_module_t *sky_http_server_dispatcher_create(const sky_http_serve
 
 void sky_http_server_dispatcher_destroy(sky_http_server_module_t *server_dispatcher);
 
+static sky_inline const sky_str_t *
+sky_http_req_path_param_at(const sky_http_server_request_t *const req, const sky_u32_t index) {
+    return index < req->path_param_n ? req->path_params + index : null;
+}
+
+static sky_inline const sky_str_t *
+sky_http_req_path_param(const sky_http_server_request_t *const req, const sky_uchar_t *const name, const sky_usize_t len) {
+    for (sky_u32_t i = 0; i < req->path_param_n; ++i) {
+        if (sky_str_equals2(req->path_param_names + i, name, len)) {
+            return req->path_params + i;
+        }
+    }
+    return null;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
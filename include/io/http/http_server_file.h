@@ -17,7 +17,11 @@ typedef struct {
     sky_str_t dir;
     sky_bool_t (*pre_run)(sky_http_server_request_t *req, void *data);
     void *run_data;
-    sky_u32_t cache_sec;
+    sky_u32_t cache_sec; // 文件句柄缓存时间，开启 watch 时仅用于不存在或未能监听的文件
+    sky_u32_t mem_cache_size; // 小文件内存缓存总字节数，缓存包含响应头的完整响应，0则不开启
+    sky_u32_t mem_file_max; // 可进入内存缓存的文件大小上限，0则默认16KB
+    sky_bool_t precompressed; // 文本类型文件在客户端支持时发送同目录下预压缩的 .br/.gz 文件
+    sky_bool_t watch; // 使用 inotify 监听文件所在目录，变化时立即失效缓存，已打开的文件不再过期
 } sky_http_server_file_conf_t;
 
 sky_http_server_module_t *sky_http_server_file_create(sky_event_loop_t *ev_loop, const sky_http_server_file_conf_t *conf);
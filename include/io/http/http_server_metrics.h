@@ -0,0 +1,33 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#ifndef SKY_HTTP_SERVER_METRICS_H
+#define SKY_HTTP_SERVER_METRICS_H
+
+#include "http_server.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct {
+    sky_str_t host;
+    sky_str_t prefix; // 如 /metrics
+} sky_http_server_metrics_conf_t;
+
+/**
+ * 以 Prometheus 文本格式输出所有事件循环汇总后的统计(sky_event_loop_metrics_collect)，
+ * 模块不区分挂载在哪个事件循环，每个 server 各自创建或共享同一个均可
+ * @param conf 配置
+ * @return 模块
+ */
+sky_http_server_module_t *sky_http_server_metrics_create(const sky_http_server_metrics_conf_t *conf);
+
+void sky_http_server_metrics_destroy(sky_http_server_module_t *server_metrics);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_HTTP_SERVER_METRICS_H
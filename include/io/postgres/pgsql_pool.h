@@ -31,6 +31,7 @@ typedef struct {
     sky_inet_address_t *address;
     sky_u32_t keepalive;
     sky_u32_t timeout;
+    sky_u32_t timeout_ms; // 优先于 timeout
     sky_u16_t connection_size;
 } sky_pgsql_conf_t;
 
@@ -6,6 +6,7 @@
 #define SKY_SELECTOR_H
 
 #include "inet.h"
+#include "../core/histogram.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -21,6 +22,21 @@ typedef struct sky_ev_s sky_ev_t;
 
 typedef void (*sky_ev_cb_pt)(sky_ev_t *ev);
 
+/**
+ * 选择器所在事件循环的统计，仅由事件循环线程写入，其他线程可随时读取(可能读到稍旧的值)
+ */
+typedef struct {
+    sky_u64_t timer_n; // 定时器触发次数
+    sky_u64_t accept_n; // 接受的连接数
+    sky_u64_t connect_n; // 主动建立的连接数
+    sky_u64_t conn_active; // 当前连接数
+    sky_u64_t read_bytes;
+    sky_u64_t write_bytes;
+    sky_histogram_t event_hist; // 单次等待的就绪事件数，count 为等待次数
+    sky_histogram_t busy_hist; // 单次循环回调耗时(us)
+    sky_histogram_t req_hist; // 请求耗时(us)
+} sky_selector_metrics_t;
+
 struct sky_ev_s {
     sky_socket_t fd; //事件句柄
     sky_u32_t flags; // 注册的事件
@@ -47,6 +63,74 @@ sky_bool_t sky_selector_update(sky_ev_t *ev, sky_u32_t flags);
 
 sky_bool_t sky_selector_cancel(sky_ev_t *ev);
 
+#ifdef SKY_HAVE_IO_URING
+
+typedef struct sky_ev_req_s sky_ev_req_t;
+
+/**
+ * 提交请求的完成回调，在等待时执行
+ * @param req    请求
+ * @param result 与对应系统调用的返回值一致，出错为 -errno
+ * @return 需要执行回调的事件，不需要时返回null
+ */
+typedef sky_ev_t *(*sky_ev_req_pt)(sky_ev_req_t *req, sky_i32_t result);
+
+/**
+ * 提交请求，完成前 req 与缓冲必须保持有效
+ */
+struct sky_ev_req_s {
+    sky_ev_req_pt cb;
+};
+
+sky_bool_t sky_selector_recv(sky_selector_t *s, sky_ev_req_t *req, sky_socket_t fd, sky_uchar_t *buf, sky_u32_t size);
+
+sky_bool_t sky_selector_send(
+        sky_selector_t *s,
+        sky_ev_req_t *req,
+        sky_socket_t fd,
+        const sky_uchar_t *buf,
+        sky_u32_t size
+);
+
+/**
+ * 提交单次 poll 请求，result 为就绪的 epoll 事件
+ */
+sky_bool_t sky_selector_poll(sky_selector_t *s, sky_ev_req_t *req, sky_socket_t fd, sky_u32_t flags);
+
+/**
+ * 取消已提交的请求，请求仍会以 -ECANCELED 或实际结果完成
+ */
+sky_bool_t sky_selector_req_cancel(sky_selector_t *s, sky_ev_req_t *req);
+
+#endif
+
+
+/**
+ * 获取选择器的统计，各实现中统计为结构体首个成员
+ */
+static sky_inline sky_selector_metrics_t *
+sky_selector_metrics(sky_selector_t *const s) {
+    return (sky_selector_metrics_t *) s;
+}
+
+/**
+ * 单写者累加，使用relaxed原子写保证其他线程读取不会撕裂
+ */
+#define sky_metrics_add(_field, _n) \
+    __atomic_store_n(&(_field), (_field) + (sky_u64_t) (_n), __ATOMIC_RELAXED)
+
+static sky_inline void
+sky_selector_metrics_init(sky_selector_metrics_t *const metrics) {
+    metrics->timer_n = 0;
+    metrics->accept_n = 0;
+    metrics->connect_n = 0;
+    metrics->conn_active = 0;
+    metrics->read_bytes = 0;
+    metrics->write_bytes = 0;
+    sky_histogram_init(&metrics->event_hist);
+    sky_histogram_init(&metrics->busy_hist);
+    sky_histogram_init(&metrics->req_hist);
+}
 
 static sky_inline void
 sky_ev_init(sky_ev_t *const ev, sky_selector_t *const s, const sky_ev_cb_pt cb, const sky_socket_t fd) {
@@ -5,7 +5,7 @@
 #ifndef SKY_SYNC_WAIT_H
 #define SKY_SYNC_WAIT_H
 
-#include "../core/types.h"
+#include "thread_pool.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -25,6 +25,23 @@ void sky_sync_wait_yield_before(sky_sync_wait_t *wait);
 
 void *sky_sync_wait_yield(sky_sync_wait_t *sync_wait);
 
+/**
+ * 将阻塞任务交给线程池执行，当前协程让出，任务完成后在 loop 中恢复
+ * @param wait 当前协程
+ * @param pool 线程池
+ * @param loop 当前协程所在事件循环
+ * @param fn   阻塞任务
+ * @param arg  任务参数
+ * @return 线程池队列已满或已关闭返回false，此时任务未执行
+ */
+sky_bool_t sky_sync_wait_offload(
+        sky_sync_wait_t *wait,
+        sky_thread_pool_t *pool,
+        sky_event_loop_t *loop,
+        sky_thread_pool_pt fn,
+        void *arg
+);
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
@@ -18,6 +18,7 @@ extern "C" {
 
 
 typedef struct sky_tcp_s sky_tcp_t;
+typedef struct sky_tcp_ring_s sky_tcp_ring_t;
 
 typedef void (*sky_tcp_cb_pt)(sky_tcp_t *tcp);
 
@@ -25,6 +26,9 @@ typedef void (*sky_tcp_cb_pt)(sky_tcp_t *tcp);
 struct sky_tcp_s {
     sky_ev_t ev;
     sky_u32_t status;
+#ifdef SKY_HAVE_IO_URING
+    sky_tcp_ring_t *ring; // 提交模式的收发上下文，未开启时为null
+#endif
 };
 
 void sky_tcp_init(sky_tcp_t *tcp, sky_selector_t *s);
@@ -58,6 +62,14 @@ sky_isize_t sky_tcp_sendfile(
         sky_usize_t head_size
 );
 
+/**
+ * 已连接的 tcp 开启提交模式：收发经由 io_uring 提交，使用连接自有的缓冲，
+ * 写入拷贝到发送缓冲后即返回，完成时触发回调；关闭时未发送完的数据继续发送，完成后关闭句柄。
+ * 开启后读写返回0时直接等待回调，无需注册事件
+ * @return 未使用 io_uring 或内存不足返回false，此时仍为就绪模式
+ */
+sky_bool_t sky_tcp_ring_enable(sky_tcp_t *tcp);
+
 sky_bool_t sky_tcp_option_reuse_addr(const sky_tcp_t *tcp);
 
 sky_bool_t sky_tcp_option_reuse_port(const sky_tcp_t *tcp);
@@ -88,16 +100,31 @@ sky_tcp_set_cb(sky_tcp_t *const tcp, const sky_tcp_cb_pt cb) {
 
 static sky_inline sky_bool_t
 sky_tcp_register(sky_tcp_t *const tcp, const sky_u32_t flags) {
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) { // 提交模式由完成事件触发回调
+        return true;
+    }
+#endif
     return sky_selector_register(&tcp->ev, flags);
 }
 
 static sky_inline sky_bool_t
 sky_tcp_try_register(sky_tcp_t *const tcp, const sky_u32_t flags) {
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        return true;
+    }
+#endif
     return sky_ev_reg(&tcp->ev) || sky_selector_register(&tcp->ev, flags);
 }
 
 static sky_inline sky_bool_t
 sky_tcp_register_update(sky_tcp_t *const tcp, const sky_u32_t flags) {
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        return true;
+    }
+#endif
     return sky_selector_update(&tcp->ev, flags);
 }
 
@@ -0,0 +1,53 @@
+//
+// Created by beliefsky on 2023/11/5.
+//
+
+#ifndef SKY_THREAD_POOL_H
+#define SKY_THREAD_POOL_H
+
+#include "event_loop.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct sky_thread_pool_s sky_thread_pool_t;
+
+typedef void (*sky_thread_pool_pt)(void *data);
+
+/**
+ * 创建阻塞任务线程池
+ * @param thread_n   工作线程数，0则使用cpu核数
+ * @param queue_size 等待队列上限，0则默认1024
+ * @return 线程池
+ */
+sky_thread_pool_t *sky_thread_pool_create(sky_u32_t thread_n, sky_u32_t queue_size);
+
+/**
+ * 提交任务，work 在工作线程执行，完成后 done 投递回 loop 所在线程执行
+ * @param pool 线程池
+ * @param work 阻塞任务
+ * @param data 任务参数，同时作为 done 的参数
+ * @param loop 完成回调所在事件循环，可为null
+ * @param done 完成回调，可为null
+ * @return 队列已满或已关闭返回false
+ */
+sky_bool_t sky_thread_pool_submit(
+        sky_thread_pool_t *pool,
+        sky_thread_pool_pt work,
+        void *data,
+        sky_event_loop_t *loop,
+        sky_event_loop_post_pt done
+);
+
+/**
+ * 执行完已提交的任务后关闭线程池
+ * @param pool 线程池
+ */
+void sky_thread_pool_destroy(sky_thread_pool_t *pool);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif //SKY_THREAD_POOL_H
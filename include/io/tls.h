@@ -14,10 +14,20 @@ extern "C" {
 
 typedef struct sky_tls_ctx_s sky_tls_ctx_t;
 typedef struct sky_tls_s sky_tls_t;
+typedef struct sky_tls_session_s sky_tls_session_t;
 
+/**
+ * 客户端收到可复用的会话(含 TLS1.3 握手后下发的 ticket)时回调
+ * @param tls     所属连接
+ * @param session 会话，所有权转移给回调，不再使用时调用 sky_tls_session_free
+ */
+typedef void (*sky_tls_session_pt)(sky_tls_t *tls, sky_tls_session_t *session);
 
 struct sky_tls_ctx_s {
     void *ctx;
+    sky_uchar_t *alpn; // ALPN 协议列表(wire格式)
+    sky_tls_session_pt session_cb;
+    sky_u32_t alpn_len;
 };
 
 struct sky_tls_s {
@@ -30,6 +40,13 @@ typedef struct {
     sky_str_t ca_path;
     sky_str_t crt_file;
     sky_str_t key_file;
+    const sky_str_t *alpn; // ALPN 协议，按优先级排列，如 http/1.1
+    sky_tls_session_pt session_cb; // 客户端会话回调，设置后由使用方缓存会话，OpenSSL 内部不再保存
+    sky_u32_t alpn_n;
+    sky_u32_t session_cache_size; // 服务端会话缓存条数，0则默认20480
+    sky_u32_t session_timeout; // 会话有效期(秒)，0则默认300
+    sky_bool_t no_session_ticket; // 关闭 session ticket
+    sky_bool_t no_ktls; // 关闭内核TLS(kTLS)，默认在内核支持时启用，加密连接也可使用 sendfile
     sky_bool_t need_verify;
     sky_bool_t is_server;
 } sky_tls_ctx_conf_t;
@@ -49,12 +66,53 @@ sky_isize_t sky_tls_read(sky_tls_t *tls, sky_uchar_t *data, sky_usize_t size);
 
 sky_isize_t sky_tls_write(sky_tls_t *tls, const sky_uchar_t *data, sky_usize_t size);
 
+/**
+ * 依次写入多段数据，语义同 sky_tcp_write_vec
+ */
+sky_isize_t sky_tls_write_vec(sky_tls_t *tls, const sky_io_vec_t *vec, sky_u32_t num);
+
+/**
+ * 加密发送文件，语义同 sky_tcp_sendfile：返回写入的 head 与文件字节数之和，offset 按文件字节数后移
+ * 连接启用kTLS时由内核加密并零拷贝发送，否则每次读出一个记录大小在用户态加密
+ */
+sky_isize_t sky_tls_sendfile(
+        sky_tls_t *tls,
+        sky_fs_t *fs,
+        sky_i64_t *offset,
+        sky_usize_t size,
+        const sky_uchar_t *head,
+        sky_usize_t head_size
+);
+
 sky_i8_t sky_tls_shutdown(sky_tls_t *tls);
 
 void sky_tls_destroy(sky_tls_t *tls);
 
 void sky_tls_set_sni_hostname(sky_tls_t *tls, const sky_str_t *hostname);
 
+/**
+ * 获取握手协商的 ALPN 协议
+ * @return 未协商返回false
+ */
+sky_bool_t sky_tls_get_alpn(const sky_tls_t *tls, sky_str_t *out);
+
+/**
+ * @return 握手是否复用了会话
+ */
+sky_bool_t sky_tls_session_reused(const sky_tls_t *tls);
+
+/**
+ * 设置握手时尝试复用的会话，需在 sky_tls_connect 之前调用，不转移所有权
+ */
+sky_bool_t sky_tls_set_session(sky_tls_t *tls, sky_tls_session_t *session);
+
+void sky_tls_session_free(sky_tls_session_t *session);
+
+/**
+ * @return 发送方向是否已由内核加密(kTLS)，握手完成后有效
+ */
+sky_bool_t sky_tls_ktls_send(const sky_tls_t *tls);
+
 
 #if defined(__cplusplus)
 } /* extern "C" { */
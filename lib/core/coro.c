@@ -6,10 +6,24 @@
 #include <core/coro.h>
 #include <core/memory.h>
 #include <core/log.h>
+#include <core/histogram.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #define CORO_DEFAULT_STACK_SIZE 14336
+#define CORO_DEFAULT_FREE_MAX   256
+#define CORO_STACK_CANARY       SKY_USIZE(0xCDCDCDCDCDCDCDCD)
 #define PAGE_SIZE 2048
 
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
 #if defined(__MACH__)
 #define ASM_SYMBOL(name_) "_" #name_
 #else
@@ -41,12 +55,26 @@ typedef libucontext_ucontext_t sky_coro_context_t;
 #endif
 
 typedef struct coro_block_s coro_block_t;
+typedef struct coro_profile_s coro_profile_t;
 
 typedef struct {
     sky_coro_context_t caller;
     sky_coro_t *current;
+    sky_coro_t *free; // 当前线程空闲的默认栈协程
+    coro_profile_t *profile; // 当前线程的栈使用统计，首次统计时获取
+    sky_u32_t free_n;
+    sky_bool_t bind; // 是否已注册线程退出时的清理
 } coro_switcher_t;
 
+/**
+ * 每个线程单独记录(单写者)，线程退出后保留计数，交给之后的线程继续使用
+ */
+struct coro_profile_s {
+    sky_histogram_t hist;
+    coro_profile_t *next;
+    sky_bool_t used; // 是否有线程正在使用
+};
+
 struct coro_block_s {
     coro_block_t *next;
 };
@@ -63,6 +91,8 @@ struct sky_coro_s {
 
     sky_uchar_t *stack;
     sky_usize_t stack_size;
+    sky_usize_t map_size;
+    sky_bool_t profile; // 栈已填充canary
 };
 
 static sky_usize_t coro_resume(sky_coro_t *coro);
@@ -71,11 +101,43 @@ static sky_usize_t coro_yield(sky_coro_t *coro, sky_usize_t value);
 
 static void mem_block_add(sky_coro_t *coro);
 
+static void coro_page_init();
+
+static sky_coro_t *coro_map(sky_usize_t stack_size);
+
+static void coro_unmap(sky_coro_t *coro);
+
+static void coro_reset(sky_coro_t *coro);
+
+static void coro_profile_record(sky_coro_t *coro, sky_bool_t reuse);
+
+static coro_profile_t *coro_profile_get();
+
+static void coro_thread_bind(coro_switcher_t *switcher);
+
+static void coro_thread_key_create();
+
+static void coro_thread_exit(void *data);
+
 
 static sky_thread coro_switcher_t thread_switcher = {
-        .current = null
+        .current = null,
+        .free = null,
+        .profile = null,
+        .free_n = 0,
+        .bind = false
 };
 
+static sky_u32_t coro_free_max = CORO_DEFAULT_FREE_MAX;
+static sky_bool_t coro_trim_idle = false;
+static sky_usize_t coro_page_size = 0;
+static sky_usize_t coro_default_stack = 0;
+static sky_bool_t coro_profile = false;
+static coro_profile_t *coro_profile_list = null;
+static pthread_mutex_t coro_profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t coro_thread_once = PTHREAD_ONCE_INIT;
+static pthread_key_t coro_thread_key;
+
 
 #if defined(__x86_64__)
 
@@ -200,28 +262,64 @@ sky_coro_create_with_stack(sky_coro_func_t func, void *data, const sky_usize_t s
 
 sky_api sky_coro_t *
 sky_coro_new() {
-    return sky_coro_new_with_stack(CORO_DEFAULT_STACK_SIZE);
+    coro_switcher_t *const switcher = &thread_switcher;
+
+    sky_coro_t *const coro = switcher->free;
+    if (coro) {
+        switcher->free = coro->parent;
+        --switcher->free_n;
+        coro_reset(coro);
+
+        return coro;
+    }
+
+    return coro_map(CORO_DEFAULT_STACK_SIZE);
 }
 
 sky_api sky_coro_t *
 sky_coro_new_with_stack(sky_usize_t stack_size) {
-    stack_size = (stack_size + SKY_USIZE(63)) & ~SKY_USIZE(63); // 64字节对齐
+    coro_page_init();
 
-    sky_uchar_t *ptr = sky_malloc(stack_size + PAGE_SIZE);
-    if (sky_unlikely(!ptr)) {
-        return null;
+    stack_size = (stack_size + coro_page_size - 1) & ~(coro_page_size - 1);
+    if (stack_size == coro_default_stack) {
+        return sky_coro_new();
     }
-    sky_coro_t *const coro = (sky_coro_t *) ptr;
-    ptr += sizeof(sky_coro_t);
-    coro->block = null;
-    coro->ptr = ptr;
-    coro->ptr_size = PAGE_SIZE - sizeof(sky_coro_t) - 16;
-    ptr += coro->ptr_size + 16;
-    coro->stack = ptr;
-    coro->stack_size = stack_size;
+    return coro_map(stack_size);
+}
 
+sky_api void
+sky_coro_pool_config(const sky_u32_t free_max, const sky_bool_t trim_idle) {
+    coro_free_max = free_max;
+    coro_trim_idle = trim_idle;
+}
 
-    return coro;
+sky_api void
+sky_coro_pool_clean() {
+    coro_switcher_t *const switcher = &thread_switcher;
+
+    sky_coro_t *coro = switcher->free, *next;
+    for (; coro; coro = next) {
+        next = coro->parent;
+        coro_unmap(coro);
+    }
+    switcher->free = null;
+    switcher->free_n = 0;
+}
+
+sky_api void
+sky_coro_profile_enable(const sky_bool_t enable) {
+    coro_profile = enable;
+}
+
+sky_api void
+sky_coro_profile_get(sky_histogram_t *const profile) {
+    sky_histogram_init(profile);
+
+    pthread_mutex_lock(&coro_profile_lock);
+    for (const coro_profile_t *item = coro_profile_list; item; item = item->next) {
+        sky_histogram_merge(profile, &item->hist);
+    }
+    pthread_mutex_unlock(&coro_profile_lock);
 }
 
 sky_api void
@@ -304,10 +402,33 @@ sky_coro_current() {
 
 sky_api void
 sky_coro_destroy(sky_coro_t *const coro) {
-    for (coro_block_t *block = coro->block; block; block = block->next) {
+    coro_block_t *block = coro->block, *next;
+    for (; block; block = next) {
+        next = block->next;
         sky_free(block);
     }
-    sky_free(coro);
+    coro->block = null;
+
+    coro_switcher_t *const switcher = &thread_switcher;
+    if (coro->stack_size != coro_default_stack || switcher->free_n >= coro_free_max) {
+        if (coro->profile) {
+            coro_profile_record(coro, false);
+        }
+        coro_unmap(coro);
+        return;
+    }
+    if (coro->profile) {
+        coro_profile_record(coro, true);
+    } else if (coro_trim_idle) { // canary 需保留，统计时不回收
+        // 栈顶页下次运行必然使用，保留；其余归还给内核，再次使用时按需缺页
+        madvise(coro->stack, coro->stack_size - coro_page_size, MADV_DONTNEED);
+    }
+    if (sky_unlikely(!switcher->bind)) {
+        coro_thread_bind(switcher);
+    }
+    coro->parent = switcher->free;
+    switcher->free = coro;
+    ++switcher->free_n;
 }
 
 
@@ -356,6 +477,177 @@ coro_yield(sky_coro_t *const coro, const sky_usize_t value) {
     return coro->yield_value;
 }
 
+/**
+ * 内存布局: | guard page(PROT_NONE) | stack | sky_coro_t + 协程内存 |
+ * 栈向低地址增长，溢出时命中guard page直接SIGSEGV，而不是破坏堆
+ */
+static sky_coro_t *
+coro_map(sky_usize_t stack_size) {
+    coro_page_init();
+
+    const sky_usize_t page_mask = coro_page_size - 1;
+    const sky_usize_t guard_size = coro_page_size;
+
+    stack_size = (stack_size + page_mask) & ~page_mask;
+    const sky_usize_t head_map = (PAGE_SIZE + page_mask) & ~page_mask;
+    const sky_usize_t map_size = guard_size + stack_size + head_map;
+
+    sky_uchar_t *const ptr = mmap(
+            null,
+            map_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+            -1,
+            0
+    );
+    if (sky_unlikely(ptr == MAP_FAILED)) {
+        return null;
+    }
+    if (sky_unlikely(mprotect(ptr, guard_size, PROT_NONE) != 0)) {
+        munmap(ptr, map_size);
+        return null;
+    }
+
+    sky_coro_t *const coro = (sky_coro_t *) (ptr + guard_size + stack_size);
+    coro->stack = ptr + guard_size;
+    coro->stack_size = stack_size;
+    coro->map_size = map_size;
+    coro->block = null;
+    coro->profile = false;
+    coro_reset(coro);
+
+    return coro;
+}
+
+static sky_inline void
+coro_page_init() {
+    if (sky_likely(coro_page_size)) {
+        return;
+    }
+    const sky_i64_t page_size = sysconf(_SC_PAGESIZE);
+    const sky_usize_t size = page_size > 0 ? (sky_usize_t) page_size : SKY_USIZE(4096);
+
+    coro_default_stack = (CORO_DEFAULT_STACK_SIZE + size - 1) & ~(size - 1);
+    coro_page_size = size;
+}
+
+static void
+coro_unmap(sky_coro_t *const coro) {
+    munmap(coro->stack - coro_page_size, coro->map_size);
+}
+
+static sky_inline void
+coro_reset(sky_coro_t *const coro) {
+    coro->ptr = (sky_uchar_t *) (coro + 1);
+    coro->ptr_size = PAGE_SIZE - sizeof(sky_coro_t) - 16;
+
+    if (sky_unlikely(coro_profile && !coro->profile)) {
+        sky_usize_t *word = (sky_usize_t *) coro->stack;
+        for (sky_usize_t i = coro->stack_size / sizeof(sky_usize_t); i > 0; --i) {
+            *word++ = CORO_STACK_CANARY;
+        }
+        coro->profile = true;
+    }
+}
+
+/**
+ * 从栈底向上查找第一个被改写的canary，得到栈使用的最高水位并计入直方图
+ * @param coro  协程
+ * @param reuse 协程是否回收复用，复用时重新填充被改写部分
+ */
+static void
+coro_profile_record(sky_coro_t *const coro, const sky_bool_t reuse) {
+    sky_usize_t *const start = (sky_usize_t *) coro->stack;
+    sky_usize_t *const end = (sky_usize_t *) (coro->stack + coro->stack_size);
+    sky_usize_t *word = start;
+
+    while (word < end && *word == CORO_STACK_CANARY) {
+        ++word;
+    }
+    const sky_usize_t used = (sky_usize_t) (end - word) * sizeof(sky_usize_t);
+
+    coro_profile_t *const profile = coro_profile_get();
+    if (sky_likely(profile)) {
+        sky_histogram_record(&profile->hist, used);
+    }
+
+    if (!reuse || !coro_profile) {
+        coro->profile = false;
+        return;
+    }
+    for (; word < end; ++word) {
+        *word = CORO_STACK_CANARY;
+    }
+}
+
+/**
+ * 获取当前线程的统计，优先复用已退出线程留下的统计
+ */
+static coro_profile_t *
+coro_profile_get() {
+    coro_switcher_t *const switcher = &thread_switcher;
+    if (sky_likely(switcher->profile)) {
+        return switcher->profile;
+    }
+    pthread_mutex_lock(&coro_profile_lock);
+    coro_profile_t *profile = coro_profile_list;
+    while (profile && profile->used) {
+        profile = profile->next;
+    }
+    if (!profile) {
+        profile = sky_malloc(sizeof(coro_profile_t));
+        if (sky_unlikely(!profile)) {
+            pthread_mutex_unlock(&coro_profile_lock);
+            return null;
+        }
+        sky_histogram_init(&profile->hist);
+        profile->next = coro_profile_list;
+        coro_profile_list = profile;
+    }
+    profile->used = true;
+    pthread_mutex_unlock(&coro_profile_lock);
+
+    switcher->profile = profile;
+    if (!switcher->bind) {
+        coro_thread_bind(switcher);
+    }
+
+    return profile;
+}
+
+/**
+ * 注册线程退出时的清理，线程缓存空闲协程或开始统计时调用
+ */
+static void
+coro_thread_bind(coro_switcher_t *const switcher) {
+    pthread_once(&coro_thread_once, coro_thread_key_create);
+    switcher->bind = pthread_setspecific(coro_thread_key, switcher) == 0;
+}
+
+static void
+coro_thread_key_create() {
+    pthread_key_create(&coro_thread_key, coro_thread_exit);
+}
+
+/**
+ * 线程退出时释放缓存的空闲协程栈，并归还统计(计数保留在链表中)
+ */
+static void
+coro_thread_exit(void *const data) {
+    coro_switcher_t *const switcher = data;
+
+    sky_coro_pool_clean();
+
+    coro_profile_t *const profile = switcher->profile;
+    if (profile) {
+        pthread_mutex_lock(&coro_profile_lock);
+        profile->used = false;
+        pthread_mutex_unlock(&coro_profile_lock);
+        switcher->profile = null;
+    }
+    switcher->bind = false;
+}
+
 static sky_inline void
 mem_block_add(sky_coro_t *const coro) {
     coro_block_t *const block = sky_malloc(PAGE_SIZE);
@@ -0,0 +1,272 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#include <core/hashmap.h>
+#include <core/memory.h>
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+/**
+ * 控制字节：最高位为0表示占用，低7位保存hash低7位(h2)；0x80为空，0xFE为已删除
+ * 探测以16个控制字节为一组，组序号由hash高位(h1)决定，组间按三角数跳跃，保证遍历所有组
+ */
+#define HASHMAP_GROUP_WIDTH 16
+#define HASHMAP_CTRL_EMPTY  SKY_U8(0x80)
+#define HASHMAP_CTRL_DELETE SKY_U8(0xFE)
+
+#define hashmap_h1(_hash) ((_hash) >> 7)
+#define hashmap_h2(_hash) ((sky_u8_t) ((_hash) & 0x7F))
+
+static sky_bool_t hashmap_resize(sky_hashmap_t *map, sky_usize_t capacity);
+
+static sky_usize_t hashmap_find_insert(const sky_hashmap_t *map, sky_u64_t hash);
+
+static sky_u32_t group_match(const sky_u8_t *ctrl, sky_u8_t h2);
+
+static sky_u32_t group_match_empty(const sky_u8_t *ctrl);
+
+static sky_u32_t group_match_empty_or_delete(const sky_u8_t *ctrl);
+
+static sky_usize_t hashmap_growth(sky_usize_t capacity);
+
+
+sky_api void
+sky_hashmap_init(sky_hashmap_t *const map, const sky_hashmap_equals_pt equals) {
+    map->ctrl = null;
+    map->slots = null;
+    map->equals = equals;
+    map->mask = 0;
+    map->size = 0;
+    map->growth_left = 0;
+}
+
+sky_api void
+sky_hashmap_destroy(sky_hashmap_t *const map) {
+    if (map->slots) {
+        sky_free(map->slots);
+        map->ctrl = null;
+        map->slots = null;
+    }
+    map->mask = 0;
+    map->size = 0;
+    map->growth_left = 0;
+}
+
+sky_api void *
+sky_hashmap_get(const sky_hashmap_t *const map, const sky_u64_t hash, const void *const key) {
+    if (sky_unlikely(!map->ctrl)) {
+        return null;
+    }
+    const sky_u8_t h2 = hashmap_h2(hash);
+    const sky_usize_t group_mask = map->mask / HASHMAP_GROUP_WIDTH;
+    sky_usize_t group = (sky_usize_t) hashmap_h1(hash) & group_mask, step = 0, index;
+    const sky_u8_t *ctrl;
+    const sky_hashmap_slot_t *slot;
+    sky_u32_t match;
+
+    for (;;) {
+        ctrl = map->ctrl + group * HASHMAP_GROUP_WIDTH;
+        match = group_match(ctrl, h2);
+        while (match) {
+            index = group * HASHMAP_GROUP_WIDTH + (sky_usize_t) __builtin_ctz(match);
+            slot = map->slots + index;
+            if (slot->hash == hash && map->equals(slot->item, key)) {
+                return slot->item;
+            }
+            match &= match - 1;
+        }
+        if (sky_likely(group_match_empty(ctrl))) {
+            return null;
+        }
+        group = (group + (++step)) & group_mask;
+    }
+}
+
+sky_api sky_bool_t
+sky_hashmap_put(sky_hashmap_t *const map, const sky_u64_t hash, void *const item) {
+    if (sky_unlikely(!map->growth_left)) {
+        const sky_usize_t capacity = map->mask + 1;
+        if (!map->ctrl) {
+            if (sky_unlikely(!hashmap_resize(map, HASHMAP_GROUP_WIDTH))) {
+                return false;
+            }
+        } else if (map->size < (hashmap_growth(capacity) >> 1)) { // 删除标记过多，原容量重建
+            if (sky_unlikely(!hashmap_resize(map, capacity))) {
+                return false;
+            }
+        } else if (sky_unlikely(!hashmap_resize(map, capacity << 1))) {
+            return false;
+        }
+    }
+    const sky_usize_t index = hashmap_find_insert(map, hash);
+    if (map->ctrl[index] == HASHMAP_CTRL_EMPTY) {
+        --map->growth_left;
+    }
+    map->ctrl[index] = hashmap_h2(hash);
+    map->slots[index].item = item;
+    map->slots[index].hash = hash;
+    ++map->size;
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_hashmap_del(sky_hashmap_t *const map, const sky_u64_t hash, const void *const item) {
+    if (sky_unlikely(!map->ctrl)) {
+        return false;
+    }
+    const sky_u8_t h2 = hashmap_h2(hash);
+    const sky_usize_t group_mask = map->mask / HASHMAP_GROUP_WIDTH;
+    sky_usize_t group = (sky_usize_t) hashmap_h1(hash) & group_mask, step = 0, index;
+    sky_u8_t *ctrl;
+    sky_u32_t match;
+
+    for (;;) {
+        ctrl = map->ctrl + group * HASHMAP_GROUP_WIDTH;
+        match = group_match(ctrl, h2);
+        while (match) {
+            index = group * HASHMAP_GROUP_WIDTH + (sky_usize_t) __builtin_ctz(match);
+            if (map->slots[index].item == item) {
+                // 组内仍有空位时查找必然在此组终止，可直接置空，否则留下删除标记
+                if (group_match_empty(ctrl)) {
+                    map->ctrl[index] = HASHMAP_CTRL_EMPTY;
+                    ++map->growth_left;
+                } else {
+                    map->ctrl[index] = HASHMAP_CTRL_DELETE;
+                }
+                map->slots[index].item = null;
+                --map->size;
+                return true;
+            }
+            match &= match - 1;
+        }
+        if (sky_likely(group_match_empty(ctrl))) {
+            return false;
+        }
+        group = (group + (++step)) & group_mask;
+    }
+}
+
+sky_api void *
+sky_hashmap_next(const sky_hashmap_t *const map, sky_usize_t *const iter) {
+    if (!map->ctrl) {
+        return null;
+    }
+    const sky_usize_t capacity = map->mask + 1;
+
+    for (sky_usize_t i = *iter; i < capacity; ++i) {
+        if (!(map->ctrl[i] & 0x80)) {
+            *iter = i + 1;
+            return map->slots[i].item;
+        }
+    }
+    *iter = capacity;
+
+    return null;
+}
+
+static sky_bool_t
+hashmap_resize(sky_hashmap_t *const map, const sky_usize_t capacity) {
+    sky_hashmap_slot_t *const slots = sky_malloc((sizeof(sky_hashmap_slot_t) + 1) * capacity);
+    if (sky_unlikely(!slots)) {
+        return false;
+    }
+    sky_hashmap_slot_t *const old_slots = map->slots;
+    const sky_u8_t *const old_ctrl = map->ctrl;
+    const sky_usize_t old_capacity = old_ctrl ? map->mask + 1 : 0;
+
+    map->slots = slots;
+    map->ctrl = (sky_u8_t *) (slots + capacity);
+    map->mask = capacity - 1;
+    map->growth_left = hashmap_growth(capacity) - map->size;
+    memset(map->ctrl, HASHMAP_CTRL_EMPTY, capacity);
+
+    sky_usize_t index;
+    for (sky_usize_t i = 0; i < old_capacity; ++i) {
+        if (!(old_ctrl[i] & 0x80)) {
+            index = hashmap_find_insert(map, old_slots[i].hash);
+            map->ctrl[index] = old_ctrl[i];
+            map->slots[index] = old_slots[i];
+        }
+    }
+    if (old_slots) {
+        sky_free(old_slots);
+    }
+
+    return true;
+}
+
+static sky_usize_t
+hashmap_find_insert(const sky_hashmap_t *const map, const sky_u64_t hash) {
+    const sky_usize_t group_mask = map->mask / HASHMAP_GROUP_WIDTH;
+    sky_usize_t group = (sky_usize_t) hashmap_h1(hash) & group_mask, step = 0;
+    sky_u32_t match;
+
+    for (;;) {
+        match = group_match_empty_or_delete(map->ctrl + group * HASHMAP_GROUP_WIDTH);
+        if (sky_likely(match)) {
+            return group * HASHMAP_GROUP_WIDTH + (sky_usize_t) __builtin_ctz(match);
+        }
+        group = (group + (++step)) & group_mask;
+    }
+}
+
+#ifdef __SSE2__
+
+static sky_inline sky_u32_t
+group_match(const sky_u8_t *const ctrl, const sky_u8_t h2) {
+    const __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+
+    return (sky_u32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((sky_i8_t) h2)));
+}
+
+static sky_inline sky_u32_t
+group_match_empty(const sky_u8_t *const ctrl) {
+    return group_match(ctrl, HASHMAP_CTRL_EMPTY);
+}
+
+static sky_inline sky_u32_t
+group_match_empty_or_delete(const sky_u8_t *const ctrl) {
+    return (sky_u32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) ctrl));
+}
+
+#else
+
+static sky_inline sky_u32_t
+group_match(const sky_u8_t *const ctrl, const sky_u8_t h2) {
+    sky_u32_t match = 0;
+
+    for (sky_u32_t i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+        match |= (sky_u32_t) (ctrl[i] == h2) << i;
+    }
+
+    return match;
+}
+
+static sky_inline sky_u32_t
+group_match_empty(const sky_u8_t *const ctrl) {
+    return group_match(ctrl, HASHMAP_CTRL_EMPTY);
+}
+
+static sky_inline sky_u32_t
+group_match_empty_or_delete(const sky_u8_t *const ctrl) {
+    sky_u32_t match = 0;
+
+    for (sky_u32_t i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+        match |= (sky_u32_t) (ctrl[i] >> 7) << i;
+    }
+
+    return match;
+}
+
+#endif
+
+static sky_inline sky_usize_t
+hashmap_growth(const sky_usize_t capacity) {
+    return capacity - (capacity >> 3); // 最大负载 7/8
+}
@@ -0,0 +1,87 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#include <core/histogram.h>
+#include <core/memory.h>
+
+static sky_u64_t histogram_upper(sky_u32_t index);
+
+
+sky_api void
+sky_histogram_init(sky_histogram_t *const h) {
+    sky_memzero(h, sizeof(sky_histogram_t));
+    h->min = SKY_U64_MAX;
+}
+
+sky_api void
+sky_histogram_merge(sky_histogram_t *const dst, const sky_histogram_t *const src) {
+    // 先读count，保证读到的桶计数不少于count
+    const sky_u64_t count = __atomic_load_n(&src->count, __ATOMIC_ACQUIRE);
+    if (!count) {
+        return;
+    }
+    const sky_u64_t *bucket = src->buckets;
+    sky_u64_t n;
+    for (sky_u32_t i = 0; i < SKY_HISTOGRAM_BUCKET_N; ++i, ++bucket) {
+        n = __atomic_load_n(bucket, __ATOMIC_RELAXED);
+        dst->buckets[i] += n;
+    }
+    dst->count += count;
+    dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+
+    n = __atomic_load_n(&src->min, __ATOMIC_RELAXED);
+    dst->min = sky_min(dst->min, n);
+    n = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+    dst->max = sky_max(dst->max, n);
+}
+
+sky_api sky_u64_t
+sky_histogram_percentile(const sky_histogram_t *const h, sky_f64_t percent) {
+    if (!h->count) {
+        return 0;
+    }
+    percent = sky_min(percent, 100.0);
+    percent = sky_max(percent, 0.0);
+
+    sky_u64_t target = (sky_u64_t) ((percent / 100.0) * (sky_f64_t) h->count + 0.5);
+    target = sky_max(target, SKY_U64(1));
+
+    sky_u64_t total = 0;
+    for (sky_u32_t i = 0; i < SKY_HISTOGRAM_BUCKET_N; ++i) {
+        total += h->buckets[i];
+        if (total >= target) {
+            const sky_u64_t value = histogram_upper(i);
+            return sky_max(sky_min(value, h->max), h->min);
+        }
+    }
+
+    return h->max;
+}
+
+sky_api sky_u64_t
+sky_histogram_count_le(const sky_histogram_t *const h, const sky_u64_t value) {
+    const sky_u32_t last = sky_histogram_index(value);
+
+    sky_u64_t total = 0;
+    for (sky_u32_t i = 0; i <= last; ++i) {
+        total += h->buckets[i];
+    }
+
+    return total;
+}
+
+static sky_inline sky_u64_t
+histogram_upper(const sky_u32_t index) {
+    if (index < SKY_HISTOGRAM_SUB_N) {
+        return index;
+    }
+    if (index == SKY_HISTOGRAM_BUCKET_N - 1) {
+        return SKY_U64_MAX;
+    }
+    const sky_u32_t k = index - SKY_HISTOGRAM_SUB_N;
+    const sky_u32_t shift = k / SKY_HISTOGRAM_HALF_N + 1;
+    const sky_u64_t sub = k % SKY_HISTOGRAM_HALF_N + SKY_HISTOGRAM_HALF_N;
+
+    return ((sub + 1) << shift) - 1;
+}
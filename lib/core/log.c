@@ -0,0 +1,860 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#include <core/log.h>
+#include <core/memory.h>
+#include <core/string.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+/**
+ * 每个线程一个单生产者单消费者环形缓冲，记录为8字节对齐的二进制数据：头部之后依次保存参数，
+ * 整数统一扩展为64位，%s 复制字符串内容，后台线程按 format 重新解析并格式化输出
+ */
+#define LOG_RECORD_MAX      SKY_U32(4096)
+#define LOG_RING_MIN        SKY_U32(16384)
+#define LOG_RING_DEFAULT    SKY_U32(65536)
+#define LOG_OUT_SIZE        SKY_U32(65536)
+#define LOG_LINE_MAX        SKY_U32(8192)
+#define LOG_IOV_MAX         64
+#define LOG_IDLE_MIN_US     500
+#define LOG_IDLE_MAX_US     50000
+#define LOG_PAD             SKY_U8(0xFF)
+
+#define LOG_LEN_NONE        SKY_U8(0)
+#define LOG_LEN_HH          SKY_U8(1)
+#define LOG_LEN_H           SKY_U8(2)
+#define LOG_LEN_L           SKY_U8(3)
+#define LOG_LEN_LL          SKY_U8(4)
+#define LOG_LEN_J           SKY_U8(5)
+#define LOG_LEN_Z           SKY_U8(6)
+#define LOG_LEN_T           SKY_U8(7)
+#define LOG_LEN_LD          SKY_U8(8)
+
+typedef struct log_ring_s log_ring_t;
+
+typedef struct {
+    sky_u32_t size;
+    sky_u8_t level;
+    sky_u32_t line;
+    sky_u32_t msec;
+    sky_i64_t sec;
+    const char *file;
+    const char *format;
+} log_record_t;
+
+struct log_ring_s {
+    log_ring_t *next;
+    sky_uchar_t *buf;
+    sky_u64_t dropped;
+    sky_u32_t mask;
+    sky_bool_t closed;
+    sky_align(64) sky_u64_t head;
+    sky_align(64) sky_u64_t tail;
+    sky_align(64) sky_uchar_t scratch[LOG_RECORD_MAX];
+};
+
+typedef struct {
+    const char *flags;
+    sky_i32_t flags_n;
+    sky_i32_t width;
+    sky_i32_t precision;
+    sky_bool_t width_arg;
+    sky_bool_t precision_arg;
+    sky_u8_t length;
+    char conv;
+} log_spec_t;
+
+typedef struct {
+    const sky_uchar_t *pos;
+    const sky_uchar_t *end;
+} log_reader_t;
+
+typedef struct {
+    sky_uchar_t *pos;
+    sky_uchar_t *end;
+} log_writer_t;
+
+static void log_start();
+
+static void log_exit();
+
+static void *log_thread_run(void *data);
+
+static sky_u32_t log_drain(char *out, struct iovec *iov);
+
+static log_ring_t *log_ring_get();
+
+static void log_ring_close(void *data);
+
+static void log_ring_push(log_ring_t *ring, sky_u32_t size);
+
+static sky_u32_t log_record_capture(
+        sky_uchar_t *buf,
+        sky_u8_t level,
+        const char *file,
+        sky_u32_t line,
+        const char *format,
+        va_list args
+);
+
+static sky_u32_t log_record_format(const log_record_t *record, char *out, sky_u32_t out_size);
+
+static const char *log_spec_parse(const char *p, log_spec_t *spec);
+
+static sky_u32_t log_spec_build(const log_spec_t *spec, char *buf, const char *length, sky_bool_t precision);
+
+static sky_bool_t log_write_u64(log_writer_t *writer, sky_u64_t value);
+
+static sky_bool_t log_read_u64(log_reader_t *reader, sky_u64_t *value);
+
+static void log_out_write(struct iovec *iov, sky_u32_t iov_n);
+
+sky_api sky_u8_t sky_log_level = SKY_LOG_DEBUG; // 调试日志是否编译由 NDEBUG 决定
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_t thread;
+    log_ring_t *rings;
+    sky_u64_t dropped; // 已退出线程及无法分配缓冲时的丢弃数
+    sky_u64_t flush_req;
+    sky_u64_t flush_done;
+    sky_u32_t ring_size;
+    sky_i32_t fd;
+    sky_bool_t color;
+    sky_bool_t running;
+    sky_bool_t stop;
+} logger = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .ring_size = LOG_RING_DEFAULT,
+        .fd = STDOUT_FILENO
+};
+
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_key;
+static sky_thread log_ring_t *thread_ring = null;
+
+static const sky_str_t log_prefix[] = {
+        sky_string("[DEBUG] "),
+        sky_string("[INFO] "),
+        sky_string("[WARN] "),
+        sky_string("[ERROR] ")
+};
+
+static const sky_str_t log_color_prefix[] = {
+        sky_string("[DEBUG] "),
+        sky_string("\033[0;34m[INFO] "),
+        sky_string("\033[0;32m[WARN] "),
+        sky_string("\033[0;31m[ERROR] ")
+};
+
+sky_api sky_bool_t
+sky_log_init(const sky_log_conf_t *const conf) {
+    if (conf) {
+        pthread_mutex_lock(&logger.lock);
+        if (conf->ring_size) {
+            sky_u32_t size = LOG_RING_MIN;
+            while (size < conf->ring_size && size < SKY_U32(0x40000000)) {
+                size <<= 1;
+            }
+            logger.ring_size = size;
+        }
+        if (conf->fd > 0) {
+            logger.fd = conf->fd;
+        }
+        pthread_mutex_unlock(&logger.lock);
+        sky_log_level = conf->level;
+    }
+    pthread_once(&log_once, log_start);
+
+    return __atomic_load_n(&logger.running, __ATOMIC_ACQUIRE);
+}
+
+sky_api void
+sky_log_write(
+        const sky_u8_t level,
+        const char *const file,
+        const sky_u32_t line,
+        const char *const format,
+        ...
+) {
+    va_list args;
+
+    pthread_once(&log_once, log_start);
+
+    va_start(args, format);
+    if (sky_likely(__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE))) {
+        log_ring_t *const ring = log_ring_get();
+        if (sky_likely(ring)) {
+            const sky_u32_t size = log_record_capture(ring->scratch, level, file, line, format, args);
+            log_ring_push(ring, size);
+        } else {
+            __atomic_fetch_add(&logger.dropped, 1, __ATOMIC_RELAXED);
+        }
+        va_end(args);
+        return;
+    }
+
+    // 后台线程未运行，在锁内同步格式化输出
+    static sky_uchar_t scratch[LOG_RECORD_MAX] sky_align(8);
+    static char out[LOG_LINE_MAX];
+
+    pthread_mutex_lock(&logger.lock);
+    log_record_capture(scratch, level, file, line, format, args);
+
+    const sky_str_t *const prefix = (logger.color ? log_color_prefix : log_prefix) + level;
+    struct iovec iov[3] = {
+            {.iov_base = prefix->data, .iov_len = prefix->len},
+            {.iov_base = out, .iov_len = log_record_format((const log_record_t *) scratch, out, LOG_LINE_MAX)},
+            {.iov_base = (void *) (logger.color ? "\033[0m\n" : "\n"), .iov_len = logger.color ? 5 : 1}
+    };
+    log_out_write(iov, 3);
+    pthread_mutex_unlock(&logger.lock);
+    va_end(args);
+}
+
+sky_api void
+sky_log_flush() {
+    if (!__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    const sky_u64_t target = __atomic_add_fetch(&logger.flush_req, 1, __ATOMIC_ACQ_REL);
+    while (__atomic_load_n(&logger.flush_done, __ATOMIC_ACQUIRE) < target
+           && __atomic_load_n(&logger.running, __ATOMIC_ACQUIRE)) {
+        usleep(1000);
+    }
+}
+
+sky_api sky_u64_t
+sky_log_dropped() {
+    sky_u64_t dropped = __atomic_load_n(&logger.dropped, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&logger.lock);
+    for (const log_ring_t *ring = logger.rings; ring; ring = ring->next) {
+        dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&logger.lock);
+
+    return dropped;
+}
+
+static void
+log_start() {
+    logger.color = isatty(logger.fd) == 1;
+
+    if (sky_unlikely(pthread_key_create(&log_key, log_ring_close) != 0)) {
+        return;
+    }
+    if (sky_unlikely(pthread_create(&logger.thread, null, log_thread_run, null) != 0)) {
+        return;
+    }
+    __atomic_store_n(&logger.running, true, __ATOMIC_RELEASE);
+    atexit(log_exit);
+}
+
+static void
+log_exit() {
+    __atomic_store_n(&logger.stop, true, __ATOMIC_RELEASE);
+    pthread_join(logger.thread, null);
+    __atomic_store_n(&logger.running, false, __ATOMIC_RELEASE);
+}
+
+static void *
+log_thread_run(void *const data) {
+    (void) data;
+
+    char *const out = sky_malloc(LOG_OUT_SIZE);
+    struct iovec iov[LOG_IOV_MAX];
+    sky_u32_t idle_us = LOG_IDLE_MIN_US;
+    sky_u64_t flush_req;
+    sky_bool_t stop;
+
+    for (;;) {
+        stop = __atomic_load_n(&logger.stop, __ATOMIC_ACQUIRE);
+        flush_req = __atomic_load_n(&logger.flush_req, __ATOMIC_ACQUIRE);
+
+        if (log_drain(out, iov)) {
+            idle_us = LOG_IDLE_MIN_US;
+        } else if (!stop) {
+            usleep(idle_us);
+            idle_us = sky_min(idle_us << 1, LOG_IDLE_MAX_US);
+        }
+        __atomic_store_n(&logger.flush_done, flush_req, __ATOMIC_RELEASE);
+
+        if (stop) {
+            break;
+        }
+    }
+    sky_free(out);
+
+    return null;
+}
+
+static sky_u32_t
+log_drain(char *const out, struct iovec *const iov) {
+    log_ring_t **prev = &logger.rings, *ring;
+    const log_record_t *record;
+    const sky_str_t *prefix;
+    sky_u64_t tail, head;
+    sky_u32_t n = 0, out_n = 0, iov_n = 0, size;
+
+    const sky_str_t *const prefix_table = logger.color ? log_color_prefix : log_prefix;
+    const sky_str_t suffix = logger.color ? (sky_str_t) sky_string("\033[0m\n") : (sky_str_t) sky_string("\n");
+
+    pthread_mutex_lock(&logger.lock);
+    while ((ring = *prev)) {
+        const sky_bool_t closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+        tail = ring->tail;
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        while (tail < head) {
+            record = (const log_record_t *) (ring->buf + (tail & ring->mask));
+            tail += record->size;
+            if (record->level == LOG_PAD) {
+                continue;
+            }
+            if (LOG_OUT_SIZE - out_n < LOG_LINE_MAX || iov_n + 3 > LOG_IOV_MAX) {
+                log_out_write(iov, iov_n);
+                out_n = 0;
+                iov_n = 0;
+            }
+            prefix = prefix_table + record->level;
+            size = log_record_format(record, out + out_n, LOG_LINE_MAX);
+
+            iov[iov_n].iov_base = prefix->data;
+            iov[iov_n++].iov_len = prefix->len;
+            iov[iov_n].iov_base = out + out_n;
+            iov[iov_n++].iov_len = size;
+            iov[iov_n].iov_base = suffix.data;
+            iov[iov_n++].iov_len = suffix.len;
+            out_n += size;
+            ++n;
+        }
+        // 记录已格式化到输出缓冲，可以归还空间
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        if (closed) {
+            *prev = ring->next;
+            __atomic_fetch_add(&logger.dropped, ring->dropped, __ATOMIC_RELAXED);
+            sky_free(ring);
+            continue;
+        }
+        prev = &ring->next;
+    }
+    pthread_mutex_unlock(&logger.lock);
+
+    if (iov_n) {
+        log_out_write(iov, iov_n);
+    }
+
+    return n;
+}
+
+static log_ring_t *
+log_ring_get() {
+    log_ring_t *ring = thread_ring;
+    if (sky_likely(ring)) {
+        return ring;
+    }
+    const sky_u32_t size = logger.ring_size;
+
+    ring = sky_malloc(sizeof(log_ring_t) + size);
+    if (sky_unlikely(!ring)) {
+        return null;
+    }
+    ring->buf = (sky_uchar_t *) (ring + 1);
+    ring->dropped = 0;
+    ring->mask = size - 1;
+    ring->closed = false;
+    ring->head = 0;
+    ring->tail = 0;
+
+    pthread_mutex_lock(&logger.lock);
+    ring->next = logger.rings;
+    logger.rings = ring;
+    pthread_mutex_unlock(&logger.lock);
+
+    pthread_setspecific(log_key, ring);
+    thread_ring = ring;
+
+    return ring;
+}
+
+static void
+log_ring_close(void *const data) {
+    log_ring_t *const ring = data;
+    // 线程退出，剩余记录输出后由后台线程释放
+    __atomic_store_n(&ring->closed, true, __ATOMIC_RELEASE);
+}
+
+static void
+log_ring_push(log_ring_t *const ring, const sky_u32_t size) {
+    const sky_u64_t head = ring->head;
+    const sky_u64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const sky_u32_t capacity = ring->mask + 1;
+    const sky_u32_t offset = (sky_u32_t) head & ring->mask;
+
+    // 记录不跨越缓冲尾部，剩余空间不足时填充后从头写入
+    sky_u32_t pad = capacity - offset;
+    if (pad >= size) {
+        pad = 0;
+    }
+    if (sky_unlikely(size + pad > capacity - (sky_u32_t) (head - tail))) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (pad) {
+        log_record_t *const record = (log_record_t *) (ring->buf + offset);
+        record->size = pad;
+        record->level = LOG_PAD;
+    }
+    sky_memcpy(ring->buf + ((head + pad) & ring->mask), ring->scratch, size);
+
+    __atomic_store_n(&ring->head, head + pad + size, __ATOMIC_RELEASE);
+}
+
+static sky_u32_t
+log_record_capture(
+        sky_uchar_t *const buf,
+        const sky_u8_t level,
+        const char *const file,
+        const sky_u32_t line,
+        const char *const format,
+        va_list args
+) {
+    log_record_t *const record = (log_record_t *) buf;
+    struct timespec ts;
+
+#if defined(CLOCK_REALTIME_COARSE)
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+    record->level = level;
+    record->line = line;
+    record->sec = ts.tv_sec;
+    record->msec = (sky_u32_t) (ts.tv_nsec / 1000000);
+    record->file = file;
+    record->format = format;
+
+    log_writer_t writer = {
+            .pos = buf + sizeof(log_record_t),
+            .end = buf + LOG_RECORD_MAX
+    };
+    log_spec_t spec;
+    const char *p = format;
+    sky_u64_t value;
+    sky_i64_t i_value;
+    double f_value;
+    const char *str;
+    sky_usize_t len;
+
+    while ((p = strchr(p, '%'))) {
+        p = log_spec_parse(p + 1, &spec);
+        if (spec.width_arg && !log_write_u64(&writer, (sky_u64_t) va_arg(args, sky_i32_t))) {
+            break;
+        }
+        if (spec.precision_arg) {
+            spec.precision = va_arg(args, sky_i32_t);
+            if (!log_write_u64(&writer, (sky_u64_t) spec.precision)) {
+                break;
+            }
+        }
+        switch (spec.conv) {
+            case 'd':
+            case 'i': {
+                switch (spec.length) {
+                    case LOG_LEN_HH:
+                        i_value = (signed char) va_arg(args, sky_i32_t);
+                        break;
+                    case LOG_LEN_H:
+                        i_value = (short) va_arg(args, sky_i32_t);
+                        break;
+                    case LOG_LEN_L:
+                        i_value = va_arg(args, long);
+                        break;
+                    case LOG_LEN_LL:
+                        i_value = va_arg(args, long long);
+                        break;
+                    case LOG_LEN_J:
+                        i_value = va_arg(args, sky_i64_t);
+                        break;
+                    case LOG_LEN_Z:
+                    case LOG_LEN_T:
+                        i_value = va_arg(args, sky_isize_t);
+                        break;
+                    default:
+                        i_value = va_arg(args, sky_i32_t);
+                        break;
+                }
+                value = (sky_u64_t) i_value;
+                break;
+            }
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': {
+                switch (spec.length) {
+                    case LOG_LEN_HH:
+                        value = (unsigned char) va_arg(args, sky_u32_t);
+                        break;
+                    case LOG_LEN_H:
+                        value = (unsigned short) va_arg(args, sky_u32_t);
+                        break;
+                    case LOG_LEN_L:
+                        value = va_arg(args, unsigned long);
+                        break;
+                    case LOG_LEN_LL:
+                        value = va_arg(args, unsigned long long);
+                        break;
+                    case LOG_LEN_J:
+                        value = va_arg(args, sky_u64_t);
+                        break;
+                    case LOG_LEN_Z:
+                    case LOG_LEN_T:
+                        value = va_arg(args, sky_usize_t);
+                        break;
+                    default:
+                        value = va_arg(args, sky_u32_t);
+                        break;
+                }
+                break;
+            }
+            case 'c':
+                value = (sky_u64_t) va_arg(args, sky_i32_t);
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                f_value = spec.length == LOG_LEN_LD ? (double) va_arg(args, long double) : va_arg(args, double);
+                sky_memcpy8(&value, &f_value);
+                break;
+            case 'p':
+                value = (sky_u64_t) (sky_usize_t) va_arg(args, void *);
+                break;
+            case 's': {
+                str = va_arg(args, const char *);
+                if (!str) {
+                    str = "(null)";
+                }
+                len = spec.precision >= 0 ? strnlen(str, (sky_usize_t) spec.precision) : strlen(str);
+                if (sky_unlikely(writer.end - writer.pos < 8)) {
+                    goto done;
+                }
+                // 超出记录上限的部分截断
+                len = sky_min(len, (sky_usize_t) (writer.end - writer.pos - 8));
+                log_write_u64(&writer, len);
+                sky_memcpy(writer.pos, str, len);
+                writer.pos += sky_align_size(len, SKY_U64(8));
+                continue;
+            }
+            case 'n':
+                (void) va_arg(args, void *);
+                continue;
+            case '%':
+                continue;
+            default:
+                goto done;
+        }
+        if (!log_write_u64(&writer, value)) {
+            break;
+        }
+    }
+    done:
+    record->size = (sky_u32_t) (writer.pos - buf);
+
+    return record->size;
+}
+
+static sky_u32_t
+log_record_format(const log_record_t *const record, char *const out, const sky_u32_t out_size) {
+    static sky_thread sky_i64_t date_sec = -1;
+    static sky_thread char date[24];
+
+    if (record->sec != date_sec) {
+        struct tm tm;
+        const time_t sec = (time_t) record->sec;
+        localtime_r(&sec, &tm);
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+        date_sec = record->sec;
+    }
+    sky_i32_t n = snprintf(out, out_size, "%s.%03u (%s:%u) ", date, record->msec, record->file, record->line);
+    sky_u32_t size = (sky_u32_t) sky_min((sky_u32_t) n, out_size - 1);
+
+    log_reader_t reader = {
+            .pos = (const sky_uchar_t *) (record + 1),
+            .end = (const sky_uchar_t *) record + record->size
+    };
+    log_spec_t spec;
+    char spec_buf[64];
+    const char *p = record->format, *next;
+    sky_u64_t value, len;
+    double f_value;
+
+    for (;;) {
+        next = strchr(p, '%');
+        len = next ? (sky_u64_t) (next - p) : strlen(p);
+        len = sky_min(len, (sky_u64_t) (out_size - 1 - size));
+        sky_memcpy(out + size, p, len);
+        size += (sky_u32_t) len;
+        if (!next) {
+            break;
+        }
+        p = log_spec_parse(next + 1, &spec);
+        if (spec.width_arg) {
+            if (!log_read_u64(&reader, &value)) {
+                break;
+            }
+            spec.width = (sky_i32_t) value;
+        }
+        if (spec.precision_arg) {
+            if (!log_read_u64(&reader, &value)) {
+                break;
+            }
+            spec.precision = (sky_i32_t) value;
+        }
+        switch (spec.conv) {
+            case 'd':
+            case 'i':
+                if (!log_read_u64(&reader, &value)) {
+                    goto done;
+                }
+                log_spec_build(&spec, spec_buf, "ll", true);
+                n = snprintf(out + size, out_size - size, spec_buf, (long long) value);
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if (!log_read_u64(&reader, &value)) {
+                    goto done;
+                }
+                log_spec_build(&spec, spec_buf, "ll", true);
+                n = snprintf(out + size, out_size - size, spec_buf, (unsigned long long) value);
+                break;
+            case 'c':
+                if (!log_read_u64(&reader, &value)) {
+                    goto done;
+                }
+                log_spec_build(&spec, spec_buf, "", false);
+                n = snprintf(out + size, out_size - size, spec_buf, (sky_i32_t) value);
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (!log_read_u64(&reader, &value)) {
+                    goto done;
+                }
+                sky_memcpy8(&f_value, &value);
+                log_spec_build(&spec, spec_buf, "", true);
+                n = snprintf(out + size, out_size - size, spec_buf, f_value);
+                break;
+            case 'p':
+                if (!log_read_u64(&reader, &value)) {
+                    goto done;
+                }
+                log_spec_build(&spec, spec_buf, "", false);
+                n = snprintf(out + size, out_size - size, spec_buf, (void *) (sky_usize_t) value);
+                break;
+            case 's':
+                if (!log_read_u64(&reader, &len) || (sky_u64_t) (reader.end - reader.pos) < len) {
+                    goto done;
+                }
+                spec.precision_arg = false;
+                spec.precision = -1;
+                sky_u32_t spec_n = log_spec_build(&spec, spec_buf, "", false);
+                sky_memcpy(spec_buf + spec_n - 1, ".*s", 4);
+                n = snprintf(out + size, out_size - size, spec_buf, (sky_i32_t) len, reader.pos);
+                reader.pos += sky_align_size(len, SKY_U64(8));
+                break;
+            case '%':
+                n = 1;
+                out[size] = '%';
+                break;
+            case 'n':
+                continue;
+            default:
+                goto done;
+        }
+        if (n > 0) {
+            size += sky_min((sky_u32_t) n, out_size - 1 - size);
+        }
+        if (size >= out_size - 1) {
+            break;
+        }
+    }
+    done:
+
+    return size;
+}
+
+static const char *
+log_spec_parse(const char *p, log_spec_t *const spec) {
+    spec->flags = p;
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') {
+        ++p;
+    }
+    spec->flags_n = (sky_i32_t) (p - spec->flags);
+
+    spec->width = -1;
+    spec->width_arg = false;
+    if (*p == '*') {
+        spec->width_arg = true;
+        ++p;
+    } else if (*p >= '0' && *p <= '9') {
+        spec->width = 0;
+        do {
+            spec->width = spec->width * 10 + (*p++ - '0');
+        } while (*p >= '0' && *p <= '9');
+    }
+
+    spec->precision = -1;
+    spec->precision_arg = false;
+    if (*p == '.') {
+        ++p;
+        if (*p == '*') {
+            spec->precision_arg = true;
+            ++p;
+        } else {
+            spec->precision = 0;
+            while (*p >= '0' && *p <= '9') {
+                spec->precision = spec->precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+
+    switch (*p) {
+        case 'h':
+            if (*(++p) == 'h') {
+                ++p;
+                spec->length = LOG_LEN_HH;
+            } else {
+                spec->length = LOG_LEN_H;
+            }
+            break;
+        case 'l':
+            if (*(++p) == 'l') {
+                ++p;
+                spec->length = LOG_LEN_LL;
+            } else {
+                spec->length = LOG_LEN_L;
+            }
+            break;
+        case 'q':
+            ++p;
+            spec->length = LOG_LEN_LL;
+            break;
+        case 'j':
+            ++p;
+            spec->length = LOG_LEN_J;
+            break;
+        case 'z':
+            ++p;
+            spec->length = LOG_LEN_Z;
+            break;
+        case 't':
+            ++p;
+            spec->length = LOG_LEN_T;
+            break;
+        case 'L':
+            ++p;
+            spec->length = LOG_LEN_LD;
+            break;
+        default:
+            spec->length = LOG_LEN_NONE;
+            break;
+    }
+    spec->conv = *p;
+
+    return *p ? p + 1 : p;
+}
+
+static sky_u32_t
+log_spec_build(const log_spec_t *const spec, char *const buf, const char *const length, const sky_bool_t precision) {
+    sky_u32_t n = 1;
+
+    buf[0] = '%';
+    sky_memcpy(buf + n, spec->flags, (sky_usize_t) sky_min(spec->flags_n, 8));
+    n += (sky_u32_t) sky_min(spec->flags_n, 8);
+    if (spec->width >= 0 || spec->width_arg) { // 参数给出的负数宽度输出为 '-' 标志
+        n += (sky_u32_t) snprintf(buf + n, 12, "%d", spec->width);
+    }
+    if (precision && spec->precision >= 0) {
+        n += (sky_u32_t) snprintf(buf + n, 13, ".%d", spec->precision);
+    }
+    const sky_usize_t length_n = strlen(length);
+    sky_memcpy(buf + n, length, length_n);
+    n += (sky_u32_t) length_n;
+    buf[n++] = spec->conv;
+    buf[n] = '\0';
+
+    return n;
+}
+
+static sky_inline sky_bool_t
+log_write_u64(log_writer_t *const writer, const sky_u64_t value) {
+    if (sky_unlikely(writer->end - writer->pos < 8)) {
+        return false;
+    }
+    sky_memcpy8(writer->pos, &value);
+    writer->pos += 8;
+
+    return true;
+}
+
+static sky_inline sky_bool_t
+log_read_u64(log_reader_t *const reader, sky_u64_t *const value) {
+    if (sky_unlikely(reader->end - reader->pos < 8)) {
+        return false;
+    }
+    sky_memcpy8(value, reader->pos);
+    reader->pos += 8;
+
+    return true;
+}
+
+static void
+log_out_write(struct iovec *iov, sky_u32_t iov_n) {
+    ssize_t n;
+
+    while (iov_n) {
+        n = writev(logger.fd, iov, (sky_i32_t) iov_n);
+        if (sky_unlikely(n < 0)) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                usleep(1000);
+                continue;
+            }
+            return;
+        }
+        // 部分写入时跳过已写出的部分
+        while (iov_n && (sky_usize_t) n >= iov->iov_len) {
+            n -= (ssize_t) iov->iov_len;
+            ++iov;
+            --iov_n;
+        }
+        if (iov_n) {
+            iov->iov_base = (sky_uchar_t *) iov->iov_base + n;
+            iov->iov_len -= (sky_usize_t) n;
+        }
+    }
+}
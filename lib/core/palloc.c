@@ -1,6 +1,50 @@
 #include <core/palloc.h>
 #include <core/memory.h>
 
+#ifdef SKY_HAVE_POOL_STATS
+
+#include <core/log.h>
+
+#define pool_stats_alloc(_pool, _size)  pool_stats_change(_pool, (sky_isize_t) (_size), 0)
+#define pool_stats_free(_pool, _size)   pool_stats_change(_pool, -(sky_isize_t) (_size), 0)
+#define pool_stats_large(_pool, _size)  pool_stats_change(_pool, 0, (sky_isize_t) (_size))
+#define pool_stats_large_new(_pool, _size) \
+    do {                                    \
+        ++(_pool)->stats.large_n;           \
+        pool_stats_large(_pool, _size);     \
+    } while (0)
+#define pool_stats_block(_pool)         (++(_pool)->stats.block_n)
+#define pool_stats_failed(_pool)        (++(_pool)->stats.failed_n)
+/**
+ * reset 后保留的块在本周期首次分配时才计入
+ */
+#define pool_stats_enter(_pool, _p)                                                     \
+    do {                                                                                \
+        if ((_p) != (_pool) && (_p)->d.last == (sky_uchar_t *) (_p) + sizeof(sky_pool_t)) { \
+            pool_stats_block(_pool);                                                    \
+        }                                                                               \
+    } while (0)
+
+static void pool_stats_init(sky_pool_t *pool);
+
+static void pool_stats_change(sky_pool_t *pool, sky_isize_t bytes, sky_isize_t large_bytes);
+
+static void pool_stats_commit(sky_pool_t *pool);
+
+static sky_pool_stats_total_t pool_stats_total;
+
+#else
+
+#define pool_stats_alloc(_pool, _size)
+#define pool_stats_free(_pool, _size)
+#define pool_stats_large(_pool, _size)
+#define pool_stats_large_new(_pool, _size)
+#define pool_stats_block(_pool)
+#define pool_stats_failed(_pool)
+#define pool_stats_enter(_pool, _p)
+
+#endif
+
 #define SKY_ALIGNMENT   sizeof(sky_usize_t)
 
 /**
@@ -32,12 +76,20 @@ sky_pool_create(sky_usize_t size) {
     p->max = sky_min(size, SKY_MAX_ALLOC_FROM_POOL);
     p->current = p;
     p->large = null;
+#ifdef SKY_HAVE_POOL_STATS
+    pool_stats_init(p);
+    __atomic_fetch_add(&pool_stats_total.create_n, 1, __ATOMIC_RELAXED);
+#endif
 
     return p;
 }
 
 sky_api void
 sky_pool_destroy(sky_pool_t *const pool) {
+#ifdef SKY_HAVE_POOL_STATS
+    pool_stats_commit(pool);
+    __atomic_fetch_add(&pool_stats_total.destroy_n, 1, __ATOMIC_RELAXED);
+#endif
     for (sky_pool_large_t *l = pool->large; l; l = l->next) {
         if (sky_likely(l->alloc)) {
             sky_free(l->alloc);
@@ -54,6 +106,10 @@ sky_pool_destroy(sky_pool_t *const pool) {
 
 sky_api void
 sky_pool_reset(sky_pool_t *const pool) {
+#ifdef SKY_HAVE_POOL_STATS
+    pool_stats_commit(pool);
+    pool_stats_init(pool);
+#endif
     for (sky_pool_large_t *l = pool->large; l; l = l->next) {
         if (sky_likely(l->alloc)) {
             sky_free(l->alloc);
@@ -69,12 +125,20 @@ sky_pool_reset(sky_pool_t *const pool) {
 
 sky_api void *
 sky_palloc(sky_pool_t *const pool, const sky_usize_t size) {
-    return size <= pool->max ? palloc_small_align(pool, size) : palloc_large(pool, size);
+    if (size <= pool->max) {
+        pool_stats_alloc(pool, size);
+        return palloc_small_align(pool, size);
+    }
+    return palloc_large(pool, size);
 }
 
 sky_api void *
 sky_pnalloc(sky_pool_t *const pool, const sky_usize_t size) {
-    return size <= pool->max ? palloc_small(pool, size) : palloc_large(pool, size);
+    if (size <= pool->max) {
+        pool_stats_alloc(pool, size);
+        return palloc_small(pool, size);
+    }
+    return palloc_large(pool, size);
 }
 
 sky_api void *
@@ -98,11 +162,13 @@ sky_prealloc(sky_pool_t *const pool, void *const ptr, const sky_usize_t ptr_size
     if (end == p->d.last) {
         if (size < ptr_size) {
             p->d.last = ptr + size;
+            pool_stats_free(pool, ptr_size - size);
             return ptr;
         }
         const sky_usize_t re_size = size - ptr_size;
         if ((end + re_size) < p->d.end) {
             p->d.last += re_size;
+            pool_stats_alloc(pool, re_size);
             return ptr;
         }
     } else if (ptr_size > pool->max) {
@@ -111,9 +177,11 @@ sky_prealloc(sky_pool_t *const pool, void *const ptr, const sky_usize_t ptr_size
                 if (sky_unlikely(!size)) {
                     sky_free(ptr);
                     l->alloc = null;
+                    pool_stats_large(pool, -(sky_isize_t) ptr_size);
                     return null;
                 }
                 l->alloc = sky_realloc(ptr, size);
+                pool_stats_large(pool, (sky_isize_t) size - (sky_isize_t) ptr_size);
 
                 return l->alloc;
             }
@@ -141,11 +209,13 @@ sky_pfree(sky_pool_t *const pool, const void *const ptr, const sky_usize_t size)
 
     if (end == p->d.last) {
         p->d.last -= size;
+        pool_stats_free(pool, size);
     } else if (size > pool->max) {
         for (sky_pool_large_t *l = pool->large; l; l = l->next) {
             if (ptr == l->alloc) {
                 sky_free(l->alloc);
                 l->alloc = null;
+                pool_stats_large(pool, -(sky_isize_t) size);
                 return;
             }
         }
@@ -160,6 +230,7 @@ palloc_small(sky_pool_t *const pool, const sky_usize_t size) {
     do {
         m = p->d.last;
         if (sky_likely((sky_usize_t) (p->d.end - m) >= size)) {
+            pool_stats_enter(pool, p);
             p->d.last = m + size;
             return m;
         }
@@ -176,6 +247,7 @@ palloc_small_align(sky_pool_t *const pool, const sky_usize_t size) {
     do {
         m = sky_align_ptr(p->d.last, SKY_ALIGNMENT);
         if (sky_likely((sky_usize_t) (p->d.end - m) >= size)) {
+            pool_stats_enter(pool, p);
             p->d.last = m + size;
             return m;
         }
@@ -204,11 +276,13 @@ palloc_block(sky_pool_t *const pool, const sky_usize_t size) {
 
     sky_pool_t *p = pool->current;
     for (; p->d.next; p = p->d.next) {
+        pool_stats_failed(pool);
         if (p->d.failed++ > 4) {
             pool->current = p->d.next;
         }
     }
     p->d.next = new;
+    pool_stats_block(pool);
 
     return m;
 }
@@ -219,6 +293,7 @@ palloc_large(sky_pool_t *const pool, const sky_usize_t size) {
     if (sky_unlikely(!p)) {
         return null;
     }
+    pool_stats_large_new(pool, size);
     sky_u8_t n = 0;
 
     sky_pool_large_t *large = pool->large;
@@ -241,4 +316,93 @@ palloc_large(sky_pool_t *const pool, const sky_usize_t size) {
     pool->large = large;
 
     return p;
-}
\ No newline at end of file
+}
+
+#ifdef SKY_HAVE_POOL_STATS
+
+sky_api void
+sky_pool_stats_total(sky_pool_stats_total_t *const total) {
+    total->create_n = __atomic_load_n(&pool_stats_total.create_n, __ATOMIC_RELAXED);
+    total->destroy_n = __atomic_load_n(&pool_stats_total.destroy_n, __ATOMIC_RELAXED);
+    total->cycle_n = __atomic_load_n(&pool_stats_total.cycle_n, __ATOMIC_RELAXED);
+    total->overflow_n = __atomic_load_n(&pool_stats_total.overflow_n, __ATOMIC_RELAXED);
+    total->block_n = __atomic_load_n(&pool_stats_total.block_n, __ATOMIC_RELAXED);
+    total->large_n = __atomic_load_n(&pool_stats_total.large_n, __ATOMIC_RELAXED);
+    total->large_bytes = __atomic_load_n(&pool_stats_total.large_bytes, __ATOMIC_RELAXED);
+    total->peak_total = __atomic_load_n(&pool_stats_total.peak_total, __ATOMIC_RELAXED);
+    total->peak_max = __atomic_load_n(&pool_stats_total.peak_max, __ATOMIC_RELAXED);
+}
+
+sky_api void
+sky_pool_stats_dump() {
+    sky_pool_stats_total_t total;
+    sky_pool_stats_total(&total);
+
+    sky_log_info(
+            "pool stats: live %" PRIu64 " (create %" PRIu64 ", destroy %" PRIu64 "), cycle %" PRIu64
+            ", overflow %" PRIu64 ", block %" PRIu64 ", large %" PRIu64 "/%" PRIu64 " bytes"
+            ", peak avg %" PRIu64 " max %" PRIu64 " bytes",
+            total.create_n - total.destroy_n,
+            total.create_n,
+            total.destroy_n,
+            total.cycle_n,
+            total.overflow_n,
+            total.block_n,
+            total.large_n,
+            total.large_bytes,
+            total.cycle_n ? total.peak_total / total.cycle_n : 0,
+            total.peak_max
+    );
+}
+
+static sky_inline void
+pool_stats_init(sky_pool_t *const pool) {
+    pool->stats.bytes = 0;
+    pool->stats.large_bytes = 0;
+    pool->stats.peak = 0;
+    pool->stats.block_n = 1;
+    pool->stats.large_n = 0;
+    pool->stats.failed_n = 0;
+}
+
+static sky_inline void
+pool_stats_change(sky_pool_t *const pool, const sky_isize_t bytes, const sky_isize_t large_bytes) {
+    sky_pool_stats_t *const stats = &pool->stats;
+
+    stats->bytes = (sky_usize_t) ((sky_isize_t) stats->bytes + bytes);
+    stats->large_bytes = (sky_usize_t) ((sky_isize_t) stats->large_bytes + large_bytes);
+    if (large_bytes > 0) {
+        __atomic_fetch_add(&pool_stats_total.large_bytes, (sky_u64_t) large_bytes, __ATOMIC_RELAXED);
+    }
+    const sky_usize_t used = stats->bytes + stats->large_bytes;
+    if (used > stats->peak) {
+        stats->peak = used;
+    }
+}
+
+static void
+pool_stats_commit(sky_pool_t *const pool) {
+    const sky_pool_stats_t *const stats = &pool->stats;
+
+    __atomic_fetch_add(&pool_stats_total.cycle_n, 1, __ATOMIC_RELAXED);
+    if (stats->block_n > 1) {
+        __atomic_fetch_add(&pool_stats_total.overflow_n, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&pool_stats_total.block_n, stats->block_n - 1, __ATOMIC_RELAXED);
+    }
+    if (stats->large_n) {
+        __atomic_fetch_add(&pool_stats_total.large_n, stats->large_n, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&pool_stats_total.peak_total, stats->peak, __ATOMIC_RELAXED);
+
+    sky_u64_t max = __atomic_load_n(&pool_stats_total.peak_max, __ATOMIC_RELAXED);
+    while (stats->peak > max && !__atomic_compare_exchange_n(
+            &pool_stats_total.peak_max,
+            &max,
+            stats->peak,
+            true,
+            __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED
+    ));
+}
+
+#endif
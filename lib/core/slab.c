@@ -0,0 +1,53 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+#include <core/slab.h>
+#include <core/memory.h>
+
+struct sky_slab_block_s {
+    sky_slab_block_t *next;
+};
+
+sky_api void
+sky_slab_init(sky_slab_t *const slab, const sky_usize_t size, const sky_u32_t block_n) {
+    slab->free = null;
+    slab->block = null;
+    slab->size = sky_align_size(sky_max(size, sizeof(sky_slab_obj_t)), SKY_USIZE(16));
+    slab->block_n = block_n ?: 64;
+}
+
+sky_api void
+sky_slab_destroy(sky_slab_t *const slab) {
+    sky_slab_block_t *block = slab->block, *next;
+    for (; block; block = next) {
+        next = block->next;
+        sky_free(block);
+    }
+    slab->free = null;
+    slab->block = null;
+}
+
+sky_api void *
+sky_slab_alloc_block(sky_slab_t *const slab) {
+    const sky_usize_t head = sky_align_size(sizeof(sky_slab_block_t), SKY_USIZE(16));
+
+    sky_slab_block_t *const block = sky_malloc(head + slab->size * slab->block_n);
+    if (sky_unlikely(!block)) {
+        return null;
+    }
+    block->next = slab->block;
+    slab->block = block;
+
+    // 第一个对象直接返回，其余链入空闲链表
+    sky_uchar_t *const ptr = (sky_uchar_t *) block + head;
+    sky_uchar_t *item = ptr + slab->size * (slab->block_n - 1);
+    sky_slab_obj_t *obj;
+
+    for (; item != ptr; item -= slab->size) {
+        obj = (sky_slab_obj_t *) item;
+        obj->next = slab->free;
+        slab->free = obj;
+    }
+
+    return ptr;
+}
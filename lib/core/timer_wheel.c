@@ -5,7 +5,7 @@
 #include <core/memory.h>
 
 
-#define TIMER_WHEEL_NUM         SKY_U32(4)
+#define TIMER_WHEEL_NUM         SKY_U32(5)
 
 #define TIMER_WHEEL_BITS        SKY_U32(6)
 
@@ -22,7 +22,7 @@
 /**
  * (1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_NUM)) - 1)
  */
-#define TIMER_WHEEL_MAX_TICKS   SKY_U32(16777215)
+#define TIMER_WHEEL_MAX_TICKS   SKY_U32(1073741823)
 
 struct sky_timer_wheel_s {
     sky_u64_t last_run;
@@ -87,18 +87,22 @@ sky_timer_wheel_destroy(sky_timer_wheel_t *const ctx) {
     sky_free(ctx);
 }
 
-sky_api void
+sky_api sky_u32_t
 sky_timer_wheel_run(sky_timer_wheel_t *const ctx, const sky_u64_t now) {
     timer_wheel_update(ctx, now);
 
     sky_timer_wheel_entry_t *entry;
     sky_queue_t *tmp;
+    sky_u32_t n = 0;
     while (!sky_queue_empty(&ctx->expired)) {
         tmp = sky_queue_next(&ctx->expired);
         sky_queue_remove(tmp);
         entry = sky_queue_data(tmp, sky_timer_wheel_entry_t, link);
         entry->cb(entry);
+        ++n;
     }
+
+    return n;
 }
 
 sky_api void
@@ -225,11 +229,12 @@ timer_slot(const sky_u32_t wheel, const sky_u64_t expires) {
 
 static sky_inline sky_u32_t
 timer_wheel(const sky_u64_t current, const sky_u64_t expires) {
-    static const sky_u32_t TABLES[] = { // 除以6（TIMER_WHEEL_BITS）的结果，避免计算除法, 最大轮为4，因此不会越界访问
+    static const sky_u32_t TABLES[] = { // 除以6（TIMER_WHEEL_BITS）的结果，避免计算除法, 最大轮为5，因此不会越界访问
             0, 0, 0,
             1, 1, 1,
             2, 2, 2,
             3, 3, 3,
+            4, 4, 4,
     };
 
     sky_u64_t tmp = current ^ expires;
@@ -3,21 +3,67 @@
 //
 
 #include <core/trie.h>
+#include <core/memory.h>
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+/**
+ * 自适应基数树(ART)：节点按子节点数量在 4/16/48/256 四种布局间升级，
+ * 节点保存压缩路径，子节点以路径的首字节索引
+ */
+#define TRIE_NODE4   SKY_U8(0)
+#define TRIE_NODE16  SKY_U8(1)
+#define TRIE_NODE48  SKY_U8(2)
+#define TRIE_NODE256 SKY_U8(3)
 
 typedef struct sky_trie_node_s sky_trie_node_t;
 
 struct sky_trie_node_s {
-    sky_trie_node_t *next[256];
     sky_uchar_t *key;
     sky_usize_t key_n;
     void *value;
+    sky_u16_t num;
+    sky_u8_t type;
 };
 
+typedef struct {
+    sky_trie_node_t node;
+    sky_uchar_t keys[4];
+    sky_trie_node_t *child[4];
+} trie_node4_t;
+
+typedef struct {
+    sky_trie_node_t node;
+    sky_uchar_t keys[16];
+    sky_trie_node_t *child[16];
+} trie_node16_t;
+
+typedef struct {
+    sky_trie_node_t node;
+    sky_uchar_t index[256]; // 0表示不存在，否则为 child 下标 + 1
+    sky_trie_node_t *child[48];
+} trie_node48_t;
+
+typedef struct {
+    sky_trie_node_t node;
+    sky_trie_node_t *child[256];
+} trie_node256_t;
+
 struct sky_trie_s {
-    sky_trie_node_t root;
+    sky_trie_node_t *root;
     sky_pool_t *pool;
 };
 
+static sky_trie_node_t *node_create(sky_pool_t *pool, sky_uchar_t *key, sky_usize_t key_n, void *value);
+
+static sky_trie_node_t **node_child(sky_trie_node_t *node, sky_uchar_t c);
+
+static void node_add_child(sky_pool_t *pool, sky_trie_node_t **ref, sky_uchar_t c, sky_trie_node_t *child);
+
 static sky_usize_t str_cmp_index(const sky_uchar_t *one, const sky_uchar_t *two, sky_usize_t min_len);
 
 
@@ -25,7 +71,8 @@ sky_api sky_trie_t *
 sky_trie_create(sky_pool_t *pool) {
     sky_trie_t *trie;
 
-    trie = sky_pcalloc(pool, sizeof(sky_trie_t));
+    trie = sky_palloc(pool, sizeof(sky_trie_t));
+    trie->root = node_create(pool, null, 0, null);
     trie->pool = pool;
 
     return trie;
@@ -33,11 +80,12 @@ sky_trie_create(sky_pool_t *pool) {
 
 sky_api void
 sky_trie_put(sky_trie_t *trie, const sky_str_t *key, void *value) {
-    sky_trie_node_t **k_node, *pre_node, *tmp;
+    sky_trie_node_t **pre_ref, **k_node, *pre_node, *tmp;
     sky_uchar_t *tmp_key;
     sky_usize_t len, index;
 
-    pre_node = &trie->root;
+    pre_ref = &trie->root;
+    pre_node = *pre_ref;
     if (!key || !key->len) {
         pre_node->value = value;
         return;
@@ -45,18 +93,17 @@ sky_trie_put(sky_trie_t *trie, const sky_str_t *key, void *value) {
     tmp_key = key->data;
 
     for (;;) {
-        k_node = &pre_node->next[*tmp_key++];
-        tmp = *k_node;
+        k_node = node_child(pre_node, *tmp_key++);
+        len = key->len - (sky_usize_t) (tmp_key - key->data);
 
-        if (!tmp) {
-            *k_node = tmp = sky_pcalloc(trie->pool, sizeof(sky_trie_node_t));
-            tmp->key_n = key->len - (sky_usize_t) (tmp_key - key->data);
-            tmp->key = tmp_key;
-            tmp->value = value;
+        if (!k_node) {
+            tmp = node_create(trie->pool, tmp_key, len, value);
+            node_add_child(trie->pool, pre_ref, *(tmp_key - 1), tmp);
 
             return;
         }
-        len = key->len - (sky_usize_t) (tmp_key - key->data);
+        tmp = *k_node;
+
         if (len == tmp->key_n) {
             if (!len) {
                 tmp->value = value;
@@ -70,37 +117,32 @@ sky_trie_put(sky_trie_t *trie, const sky_str_t *key, void *value) {
         } else if (len < tmp->key_n) {
             index = str_cmp_index(tmp->key, tmp_key, len);
             if (index == len) {
-                *k_node = pre_node = sky_pcalloc(trie->pool, sizeof(sky_trie_node_t));
-                pre_node->key_n = len;
-                pre_node->key = tmp_key;
-                pre_node->value = value;
+                pre_node = node_create(trie->pool, tmp_key, len, value);
 
                 tmp->key_n -= len + 1;
                 tmp->key += len;
-                pre_node->next[*tmp->key++] = tmp;
+                node_add_child(trie->pool, &pre_node, *tmp->key++, tmp);
+                *k_node = pre_node;
                 return;
             }
         } else {
             index = str_cmp_index(tmp->key, tmp_key, tmp->key_n);
             if (index == tmp->key_n) {
                 tmp_key += index;
+                pre_ref = k_node;
                 pre_node = tmp;
                 continue;
             }
         }
-        *k_node = pre_node = sky_pcalloc(trie->pool, sizeof(sky_trie_node_t));
-        pre_node->key_n = index;
-        pre_node->key = tmp_key;
+        pre_node = node_create(trie->pool, tmp_key, index, null);
 
         tmp->key_n -= index + 1;
         tmp->key += index;
-        pre_node->next[*tmp->key++] = tmp;
+        node_add_child(trie->pool, &pre_node, *tmp->key++, tmp);
 
-        tmp = sky_pcalloc(trie->pool, sizeof(sky_trie_node_t));
-        tmp->key_n = len - index - 1;
-        tmp->key = tmp_key + index;
-        tmp->value = value;
-        pre_node->next[*tmp->key++] = tmp;
+        tmp = node_create(trie->pool, tmp_key + index + 1, len - index - 1, value);
+        node_add_child(trie->pool, &pre_node, tmp_key[index], tmp);
+        *k_node = pre_node;
         return;
 
     }
@@ -110,20 +152,22 @@ sky_trie_put(sky_trie_t *trie, const sky_str_t *key, void *value) {
 sky_api void *
 sky_trie_find(const sky_trie_t *trie, const sky_str_t *key) {
     const sky_trie_node_t *node, *prev_node;
+    sky_trie_node_t *const *next;
     const sky_uchar_t *tmp_key;
     sky_usize_t len;
 
-    node = &trie->root;
+    node = trie->root;
     if (!key || !key->len) {
         return node->value;
     }
     tmp_key = key->data;
     prev_node = node;
     for (;;) {
-        node = node->next[*tmp_key++];
-        if (!node) {
+        next = node_child((sky_trie_node_t *) node, *tmp_key++);
+        if (!next) {
             break;
         }
+        node = *next;
         len = key->len - (sky_usize_t) (tmp_key - key->data);
 
         if (len == node->key_n) {
@@ -151,20 +195,22 @@ sky_trie_find(const sky_trie_t *trie, const sky_str_t *key) {
 sky_api void *
 sky_trie_contains(const sky_trie_t *trie, const sky_str_t *key) {
     const sky_trie_node_t *node;
+    sky_trie_node_t *const *next;
     const sky_uchar_t *tmp_key;
     sky_usize_t len;
 
-    node = &trie->root;
+    node = trie->root;
     if (!key || !key->len) {
         return node->value;
     }
     tmp_key = key->data;
 
     for (;;) {
-        node = node->next[*tmp_key++];
-        if (!node) {
+        next = node_child((sky_trie_node_t *) node, *tmp_key++);
+        if (!next) {
             return null;
         }
+        node = *next;
         len = key->len - (sky_usize_t) (tmp_key - key->data);
 
         if (len == node->key_n) {
@@ -180,6 +226,136 @@ sky_trie_contains(const sky_trie_t *trie, const sky_str_t *key) {
     }
 }
 
+static sky_trie_node_t *
+node_create(sky_pool_t *const pool, sky_uchar_t *const key, const sky_usize_t key_n, void *const value) {
+    trie_node4_t *const node = sky_palloc(pool, sizeof(trie_node4_t));
+    node->node.key = key;
+    node->node.key_n = key_n;
+    node->node.value = value;
+    node->node.num = 0;
+    node->node.type = TRIE_NODE4;
+
+    return &node->node;
+}
+
+static sky_inline sky_trie_node_t **
+node_child(sky_trie_node_t *const node, const sky_uchar_t c) {
+    switch (node->type) {
+        case TRIE_NODE4: {
+            trie_node4_t *const n = (trie_node4_t *) node;
+            for (sky_u32_t i = 0; i < node->num; ++i) {
+                if (n->keys[i] == c) {
+                    return n->child + i;
+                }
+            }
+            return null;
+        }
+        case TRIE_NODE16: {
+            trie_node16_t *const n = (trie_node16_t *) node;
+#ifdef __SSE2__
+            const __m128i cmp = _mm_cmpeq_epi8(
+                    _mm_set1_epi8((char) c),
+                    _mm_loadu_si128((const __m128i *) n->keys)
+            );
+            const sky_u32_t mask = (sky_u32_t) _mm_movemask_epi8(cmp) & ((SKY_U32(1) << node->num) - 1);
+            return mask ? n->child + __builtin_ctz(mask) : null;
+#else
+            for (sky_u32_t i = 0; i < node->num; ++i) {
+                if (n->keys[i] == c) {
+                    return n->child + i;
+                }
+            }
+            return null;
+#endif
+        }
+        case TRIE_NODE48: {
+            trie_node48_t *const n = (trie_node48_t *) node;
+            const sky_u8_t index = n->index[c];
+            return index ? n->child + (index - 1) : null;
+        }
+        default: {
+            trie_node256_t *const n = (trie_node256_t *) node;
+            return n->child[c] ? n->child + c : null;
+        }
+    }
+}
+
+/**
+ * 添加子节点，节点已满时升级为更大的布局并替换 *ref，旧节点内存随内存池释放
+ */
+static void
+node_add_child(sky_pool_t *const pool, sky_trie_node_t **const ref, const sky_uchar_t c, sky_trie_node_t *const child) {
+    sky_trie_node_t *const node = *ref;
+
+    switch (node->type) {
+        case TRIE_NODE4: {
+            trie_node4_t *const n = (trie_node4_t *) node;
+            if (node->num < 4) {
+                n->keys[node->num] = c;
+                n->child[node->num++] = child;
+                return;
+            }
+            trie_node16_t *const new = sky_palloc(pool, sizeof(trie_node16_t));
+            new->node = *node;
+            new->node.type = TRIE_NODE16;
+            sky_memcpy(new->keys, n->keys, 4);
+            sky_memcpy(new->child, n->child, sizeof(sky_trie_node_t *) * 4);
+            new->keys[4] = c;
+            new->child[4] = child;
+            ++new->node.num;
+            *ref = &new->node;
+            return;
+        }
+        case TRIE_NODE16: {
+            trie_node16_t *const n = (trie_node16_t *) node;
+            if (node->num < 16) {
+                n->keys[node->num] = c;
+                n->child[node->num++] = child;
+                return;
+            }
+            trie_node48_t *const new = sky_palloc(pool, sizeof(trie_node48_t));
+            new->node = *node;
+            new->node.type = TRIE_NODE48;
+            sky_memzero(new->index, sizeof(new->index));
+            for (sky_u32_t i = 0; i < 16; ++i) {
+                new->index[n->keys[i]] = (sky_u8_t) (i + 1);
+                new->child[i] = n->child[i];
+            }
+            new->index[c] = 17;
+            new->child[16] = child;
+            ++new->node.num;
+            *ref = &new->node;
+            return;
+        }
+        case TRIE_NODE48: {
+            trie_node48_t *const n = (trie_node48_t *) node;
+            if (node->num < 48) {
+                n->child[node->num++] = child;
+                n->index[c] = (sky_u8_t) node->num;
+                return;
+            }
+            trie_node256_t *const new = sky_pcalloc(pool, sizeof(trie_node256_t));
+            new->node = *node;
+            new->node.type = TRIE_NODE256;
+            for (sky_u32_t i = 0; i < 256; ++i) {
+                if (n->index[i]) {
+                    new->child[i] = n->child[n->index[i] - 1];
+                }
+            }
+            new->child[c] = child;
+            ++new->node.num;
+            *ref = &new->node;
+            return;
+        }
+        default: {
+            trie_node256_t *const n = (trie_node256_t *) node;
+            n->child[c] = child;
+            ++node->num;
+            return;
+        }
+    }
+}
+
 static sky_inline sky_usize_t
 str_cmp_index(const sky_uchar_t *one, const sky_uchar_t *two, sky_usize_t min_len) {
     sky_usize_t i;
@@ -191,4 +367,3 @@ str_cmp_index(const sky_uchar_t *one, const sky_uchar_t *two, sky_usize_t min_le
 
     return min_len - i;
 }
-
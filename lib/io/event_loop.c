@@ -3,15 +3,66 @@
 //
 #include <io/event_loop.h>
 #include <core/memory.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef SKY_HAVE_EVENT_FD
+
+#include <sys/eventfd.h>
+
+#else
+
+#include <fcntl.h>
+
+#endif
+
+struct sky_event_loop_task_s {
+    sky_event_loop_task_t *next;
+    sky_event_loop_post_pt cb;
+    void *data;
+};
+
+static sky_bool_t event_loop_post_init(sky_event_loop_t *loop);
+
+static void event_loop_post_cb(sky_ev_t *ev);
+
+static void event_loop_post_wakeup(const sky_event_loop_t *loop);
+
+static void event_loop_metrics_link(sky_event_loop_t *loop);
+
+static void event_loop_metrics_unlink(sky_event_loop_t *loop);
+
+static sky_u64_t event_loop_clock_ms();
+
+static sky_i32_t event_loop_timeout(const sky_event_loop_t *loop);
+
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sky_queue_t metrics_loops = {
+        .next = &metrics_loops,
+        .prev = &metrics_loops
+};
 
 sky_api sky_event_loop_t *
 sky_event_loop_create() {
 
     sky_event_loop_t *const loop = sky_malloc(sizeof(sky_event_loop_t));
     loop->now = time(null);
-    loop->timer_ctx = sky_timer_wheel_create((sky_u64_t) loop->now);
+    loop->now_ms = event_loop_clock_ms();
+    loop->now_us = sky_event_clock_us();
+    loop->timer_ctx = sky_timer_wheel_create(loop->now_ms);
     loop->selector = sky_selector_create();
+    loop->post_tasks = null;
+
+    if (sky_unlikely(!event_loop_post_init(loop))) {
+        sky_timer_wheel_destroy(loop->timer_ctx);
+        sky_selector_destroy(loop->selector);
+        sky_free(loop);
+        return null;
+    }
+    event_loop_metrics_link(loop);
 
     return loop;
 }
@@ -19,28 +70,220 @@ sky_event_loop_create() {
 sky_api void
 sky_event_loop_run(sky_event_loop_t *const loop) {
     sky_i32_t timeout;
-    sky_u64_t next_time;
 
+    sky_timer_wheel_run(loop->timer_ctx, loop->now_ms);
+    timeout = event_loop_timeout(loop);
 
-    sky_timer_wheel_run(loop->timer_ctx, (sky_u64_t) loop->now);
-    next_time = sky_timer_wheel_timeout(loop->timer_ctx);
-    timeout = next_time == SKY_U64_MAX ? -1 : (sky_i32_t) (next_time) * 1000;
+    sky_selector_metrics_t *const metrics = sky_selector_metrics(loop->selector);
+    sky_u32_t timer_n;
 
     while (sky_likely(sky_selector_select(loop->selector, timeout))) {
         loop->now = time(null);
+        loop->now_ms = event_loop_clock_ms();
+        loop->now_us = sky_event_clock_us();
 
         sky_selector_run(loop->selector);
 
-        sky_timer_wheel_run(loop->timer_ctx, (sky_u64_t) loop->now);
-        next_time = sky_timer_wheel_timeout(loop->timer_ctx);
-        timeout = next_time == SKY_U64_MAX ? -1 : (sky_i32_t) (next_time) * 1000;
+        timer_n = sky_timer_wheel_run(loop->timer_ctx, loop->now_ms);
+        timeout = event_loop_timeout(loop);
+
+        sky_metrics_add(metrics->timer_n, timer_n);
+        sky_histogram_record(&metrics->busy_hist, sky_event_clock_us() - loop->now_us);
     }
 }
 
 sky_api void
 sky_event_loop_destroy(sky_event_loop_t *const loop) {
+    event_loop_metrics_unlink(loop);
+
+    sky_event_loop_task_t *task = __atomic_exchange_n(&loop->post_tasks, null, __ATOMIC_ACQUIRE), *next;
+    for (; task; task = next) {
+        next = task->next;
+        sky_free(task);
+    }
+    sky_selector_cancel(&loop->post_ev);
+    close(sky_ev_get_fd(&loop->post_ev));
+    if (loop->post_fd != sky_ev_get_fd(&loop->post_ev)) {
+        close(loop->post_fd);
+    }
+
     sky_timer_wheel_destroy(loop->timer_ctx);
     sky_selector_destroy(loop->selector);
     sky_free(loop);
 }
 
+sky_api sky_bool_t
+sky_event_loop_post(sky_event_loop_t *const loop, const sky_event_loop_post_pt cb, void *const data) {
+    sky_event_loop_task_t *const task = sky_malloc(sizeof(sky_event_loop_task_t));
+    if (sky_unlikely(!task)) {
+        return false;
+    }
+    task->cb = cb;
+    task->data = data;
+
+    sky_event_loop_task_t *head = __atomic_load_n(&loop->post_tasks, __ATOMIC_RELAXED);
+    do {
+        task->next = head;
+    } while (!__atomic_compare_exchange_n(
+            &loop->post_tasks,
+            &head,
+            task,
+            true,
+            __ATOMIC_RELEASE,
+            __ATOMIC_RELAXED
+    ));
+
+    if (!head) { // 队列由空变为非空时才唤醒，其余投递由同一次唤醒批量处理
+        event_loop_post_wakeup(loop);
+    }
+
+    return true;
+}
+
+sky_api sky_u32_t
+sky_event_loop_metrics_collect(sky_selector_metrics_t *const out) {
+    sky_selector_metrics_init(out);
+
+    const sky_selector_metrics_t *item;
+    sky_u64_t *const result = (sky_u64_t *) out;
+    sky_u32_t n = 0;
+
+    pthread_mutex_lock(&metrics_mutex);
+    for (sky_queue_t *node = sky_queue_next(&metrics_loops); node != &metrics_loops; node = node->next) {
+        item = sky_event_loop_metrics(sky_queue_data(node, sky_event_loop_t, metrics_link));
+        // 直方图之前的计数全部为 sky_u64_t，逐项累加
+        for (sky_usize_t i = 0; i < offsetof(sky_selector_metrics_t, event_hist) / sizeof(sky_u64_t); ++i) {
+            result[i] += __atomic_load_n((const sky_u64_t *) item + i, __ATOMIC_RELAXED);
+        }
+        sky_histogram_merge(&out->event_hist, &item->event_hist);
+        sky_histogram_merge(&out->busy_hist, &item->busy_hist);
+        sky_histogram_merge(&out->req_hist, &item->req_hist);
+        ++n;
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+
+    return n;
+}
+
+static void
+event_loop_metrics_link(sky_event_loop_t *const loop) {
+    pthread_mutex_lock(&metrics_mutex);
+    sky_queue_insert_prev(&metrics_loops, &loop->metrics_link);
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+static void
+event_loop_metrics_unlink(sky_event_loop_t *const loop) {
+    pthread_mutex_lock(&metrics_mutex);
+    sky_queue_remove(&loop->metrics_link);
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+static sky_bool_t
+event_loop_post_init(sky_event_loop_t *const loop) {
+#ifdef SKY_HAVE_EVENT_FD
+    const sky_i32_t fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sky_unlikely(fd < 0)) {
+        return false;
+    }
+    loop->post_fd = fd;
+#else
+    sky_i32_t fds[2];
+    if (sky_unlikely(pipe(fds) != 0)) {
+        return false;
+    }
+    for (sky_u32_t i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFD, fcntl(fds[i], F_GETFD) | FD_CLOEXEC);
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+    }
+    const sky_i32_t fd = fds[0];
+    loop->post_fd = fds[1];
+#endif
+    sky_ev_init(&loop->post_ev, loop->selector, event_loop_post_cb, fd);
+    if (sky_unlikely(!sky_selector_register(&loop->post_ev, SKY_EV_READ))) {
+        close(fd);
+        if (loop->post_fd != fd) {
+            close(loop->post_fd);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+static void
+event_loop_post_cb(sky_ev_t *const ev) {
+    sky_event_loop_t *const loop = sky_type_convert(ev, sky_event_loop_t, post_ev);
+
+    // 必须先清空唤醒计数再取任务，否则可能丢失取出之后的唤醒
+#ifdef SKY_HAVE_EVENT_FD
+    sky_u64_t value;
+    while (read(sky_ev_get_fd(ev), &value, sizeof(sky_u64_t)) > 0);
+#else
+    sky_uchar_t tmp[64];
+    while (read(sky_ev_get_fd(ev), tmp, sizeof(tmp)) > 0);
+#endif
+    sky_ev_clean_read(ev);
+
+    sky_event_loop_task_t *task = __atomic_exchange_n(&loop->post_tasks, null, __ATOMIC_ACQUIRE);
+    if (!task) {
+        return;
+    }
+    // 栈式入队，反转后按投递顺序执行
+    sky_event_loop_task_t *prev = null, *next;
+    do {
+        next = task->next;
+        task->next = prev;
+        prev = task;
+        task = next;
+    } while (task);
+
+    for (task = prev; task; task = next) {
+        next = task->next;
+        task->cb(loop, task->data);
+        sky_free(task);
+    }
+}
+
+static sky_inline void
+event_loop_post_wakeup(const sky_event_loop_t *const loop) {
+#ifdef SKY_HAVE_EVENT_FD
+    const sky_u64_t value = 1;
+#else
+    const sky_uchar_t value = 1;
+#endif
+    ssize_t n;
+    do {
+        n = write(loop->post_fd, &value, sizeof(value));
+    } while (sky_unlikely(n < 0 && errno == EINTR));
+}
+
+sky_api sky_u64_t
+sky_event_clock_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (sky_u64_t) ts.tv_sec * 1000000 + (sky_u64_t) ts.tv_nsec / 1000;
+}
+
+static sky_inline sky_u64_t
+event_loop_clock_ms() {
+    struct timespec ts;
+
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#elif defined(CLOCK_MONOTONIC_FAST)
+    clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+
+    return (sky_u64_t) ts.tv_sec * 1000 + (sky_u64_t) ts.tv_nsec / 1000000;
+}
+
+static sky_inline sky_i32_t
+event_loop_timeout(const sky_event_loop_t *const loop) {
+    const sky_u64_t next_time = sky_timer_wheel_timeout(loop->timer_ctx);
+
+    return next_time == SKY_U64_MAX ? -1 : (sky_i32_t) sky_min(next_time, SKY_U64(0x7FFFFFFF));
+}
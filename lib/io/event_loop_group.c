@@ -0,0 +1,152 @@
+//
+// Created by beliefsky on 2023/11/4.
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <io/event_loop_group.h>
+#include <core/memory.h>
+#include <core/log.h>
+#include <core/coro.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef SKY_HAVE_PTHREAD_AFFINITY
+
+#include <sched.h>
+
+#endif
+
+typedef struct {
+    pthread_t thread;
+    sky_event_loop_t *loop;
+    sky_event_loop_group_t *group;
+    sky_u32_t index;
+} event_loop_thread_t;
+
+struct sky_event_loop_group_s {
+    sky_event_loop_group_pt cb;
+    void *data;
+    sky_u32_t cpu_n;
+    sky_u32_t num;
+    event_loop_thread_t threads[];
+};
+
+static void *event_loop_thread_run(void *data);
+
+static void event_loop_thread_bind_cpu(const event_loop_thread_t *thread);
+
+sky_api sky_event_loop_group_t *
+sky_event_loop_group_create(sky_u32_t num) {
+    sky_i64_t cpu_n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (sky_unlikely(cpu_n <= 0)) {
+        cpu_n = 1;
+    }
+    if (!num) {
+        num = (sky_u32_t) cpu_n;
+    }
+
+    sky_event_loop_group_t *const group = sky_malloc(
+            sizeof(sky_event_loop_group_t) + sizeof(event_loop_thread_t) * num
+    );
+    if (sky_unlikely(!group)) {
+        return null;
+    }
+    group->cb = null;
+    group->data = null;
+    group->cpu_n = (sky_u32_t) cpu_n;
+    group->num = num;
+
+    event_loop_thread_t *thread = group->threads;
+    for (sky_u32_t i = 0; i < num; ++i, ++thread) {
+        thread->loop = sky_event_loop_create();
+        if (sky_unlikely(!thread->loop)) {
+            while (thread != group->threads) {
+                --thread;
+                sky_event_loop_destroy(thread->loop);
+            }
+            sky_free(group);
+            return null;
+        }
+        thread->group = group;
+        thread->index = i;
+    }
+
+    return group;
+}
+
+sky_api void
+sky_event_loop_group_run(sky_event_loop_group_t *const group, const sky_event_loop_group_pt cb, void *const data) {
+    group->cb = cb;
+    group->data = data;
+
+    event_loop_thread_t *thread = group->threads + 1;
+    sky_u32_t i;
+
+    for (i = 1; i < group->num; ++i, ++thread) {
+        if (sky_unlikely(pthread_create(&thread->thread, null, event_loop_thread_run, thread) != 0)) {
+            sky_log_error("event loop thread create error: %u", i);
+            break;
+        }
+    }
+    const sky_u32_t started = i;
+
+    event_loop_thread_run(group->threads);
+
+    thread = group->threads + 1;
+    for (i = 1; i < started; ++i, ++thread) {
+        pthread_join(thread->thread, null);
+    }
+}
+
+sky_api void
+sky_event_loop_group_destroy(sky_event_loop_group_t *const group) {
+    event_loop_thread_t *thread = group->threads;
+    for (sky_u32_t i = group->num; i > 0; --i, ++thread) {
+        sky_event_loop_destroy(thread->loop);
+    }
+    sky_free(group);
+}
+
+sky_api sky_u32_t
+sky_event_loop_group_size(const sky_event_loop_group_t *const group) {
+    return group->num;
+}
+
+sky_api sky_event_loop_t *
+sky_event_loop_group_get(const sky_event_loop_group_t *const group, const sky_u32_t index) {
+    return index < group->num ? group->threads[index].loop : null;
+}
+
+static void *
+event_loop_thread_run(void *const data) {
+    event_loop_thread_t *const thread = data;
+    sky_event_loop_group_t *const group = thread->group;
+
+    event_loop_thread_bind_cpu(thread);
+
+    if (group->cb) {
+        group->cb(thread->loop, thread->index, group->data);
+    }
+    sky_event_loop_run(thread->loop);
+    sky_coro_pool_clean();
+
+    return null;
+}
+
+static void
+event_loop_thread_bind_cpu(const event_loop_thread_t *const thread) {
+#ifdef SKY_HAVE_PTHREAD_AFFINITY
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(thread->index % thread->group->cpu_n, &set);
+
+    if (sky_unlikely(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0)) {
+        sky_log_warn("event loop %u bind cpu error", thread->index);
+    }
+#else
+    (void) thread;
+#endif
+}
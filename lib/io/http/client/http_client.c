@@ -14,14 +14,24 @@ typedef struct {
 } client_task_t;
 
 
-static domain_node_t *rb_tree_get(sky_rb_tree_t *tree, const sky_str_t *host, sky_u32_t host_hash, sky_u32_t port_ssl);
+typedef struct {
+    const sky_str_t *host;
+    sky_u32_t port_ssl;
+} domain_key_t;
+
 
-static void rb_tree_insert(sky_rb_tree_t *tree, domain_node_t *node);
+static sky_bool_t domain_node_equals(const void *item, const void *key);
 
 static void connect_task_next(sky_timer_wheel_entry_t *timer);
 
 static void connect_keepalive_timeout(sky_timer_wheel_entry_t *timer);
 
+static void https_session_new(sky_tls_t *tls, sky_tls_session_t *session);
+
+static void domain_node_idle(domain_node_t *node);
+
+static void domain_node_free(domain_node_t *node);
+
 
 sky_api sky_http_client_t *
 sky_http_client_create(
@@ -29,8 +39,11 @@ sky_http_client_create(
         const sky_http_client_conf_t *conf
 ) {
     sky_http_client_t *const client = sky_malloc(sizeof(sky_http_client_t));
-    sky_rb_tree_init(&client->tree);
+    sky_hashmap_init(&client->domains, domain_node_equals);
+    sky_queue_init(&client->idle_nodes);
     client->ev_loop = ev_loop;
+    sky_slab_init(&client->conn_slab, sizeof(sky_http_client_connect_t), 16);
+    sky_slab_init(&client->tls_conn_slab, sizeof(https_client_connect_t), 16);
 
     if (conf) {
         const sky_tls_ctx_conf_t tls_conf = {
@@ -38,6 +51,7 @@ sky_http_client_create(
                 .ca_path = conf->ssl_ca_path,
                 .crt_file = conf->ssl_crt_file,
                 .key_file = conf->ssl_key_file,
+                .session_cb = https_session_new,
                 .need_verify = conf->ssl_need_verify,
                 .is_server = false
         };
@@ -47,26 +61,34 @@ sky_http_client_create(
         }
 
         client->body_str_max = conf->body_str_max ?: SKY_USIZE(1048576);
-        client->keepalive = conf->keepalive ?: 75;
-        client->timeout = conf->timeout ?: 30;
+        client->keepalive = (conf->keepalive ?: 75) * 1000;
+        client->timeout = conf->timeout_ms ?: (conf->timeout ?: 30) * 1000;
         client->header_buf_size = conf->header_buf_size ?: 2048;
+        client->session_max = conf->ssl_session_max ?: 64;
         client->domain_conn_max = conf->domain_conn_max ?: 6;
         client->header_buf_n = conf->header_buf_n ?: 4;
     } else {
-        const sky_tls_ctx_conf_t tls_conf = {};
+        const sky_tls_ctx_conf_t tls_conf = {
+                .session_cb = https_session_new
+        };
         if (sky_unlikely(!sky_tls_ctx_init(&client->tls_ctx, &tls_conf))) {
             sky_free(client);
             return null;
         }
 
         client->body_str_max = SKY_USIZE(1048576);
-        client->keepalive = 75;
-        client->timeout = 30;
+        client->keepalive = 75000;
+        client->timeout = 30000;
         client->header_buf_size = 2048;
+        client->session_max = 64;
         client->domain_conn_max = 6;
         client->header_buf_n = 4;
     }
 
+    client->session_hit = 0;
+    client->session_miss = 0;
+    client->session_n = 0;
+    client->idle_node_n = 0;
     client->destroy = false;
 
     return client;
@@ -76,12 +98,25 @@ sky_api void
 sky_http_client_destroy(sky_http_client_t *client) {
     client->destroy = true;
 
-    if (sky_rb_tree_is_empty(&client->tree)) {
+    while (!sky_queue_empty(&client->idle_nodes)) {
+        domain_node_free(sky_type_convert(sky_queue_next(&client->idle_nodes), domain_node_t, idle_link));
+    }
+    if (sky_hashmap_is_empty(&client->domains)) {
+        sky_hashmap_destroy(&client->domains);
         sky_tls_ctx_destroy(&client->tls_ctx);
+        sky_slab_destroy(&client->conn_slab);
+        sky_slab_destroy(&client->tls_conn_slab);
         sky_free(client);
     }
 }
 
+sky_api void
+sky_http_client_session_stat(const sky_http_client_t *const client, sky_http_client_session_stat_t *const stat) {
+    stat->hit = client->session_hit;
+    stat->miss = client->session_miss;
+    stat->cached = client->session_n;
+}
+
 sky_api sky_http_client_req_t *
 sky_http_client_req_create(sky_pool_t *const pool, const sky_str_t *const url) {
     (void) url;
@@ -121,7 +156,11 @@ sky_http_client_req(
     host_hash = sky_crc32c_update(host_hash, (sky_uchar_t *) &port_ssl, sizeof(sky_u32_t));
     host_hash = sky_crc32_final(host_hash);
 
-    domain_node_t *node = rb_tree_get(&client->tree, &req->domain.host, host_hash, port_ssl);
+    const domain_key_t key = {
+            .host = &req->domain.host,
+            .port_ssl = port_ssl
+    };
+    domain_node_t *node = sky_hashmap_get(&client->domains, host_hash, &key);
     if (!node) {
         sky_uchar_t *ptr = sky_malloc(sizeof(domain_node_t) + req->domain.host.len);
         node = (domain_node_t *) ptr;
@@ -132,20 +171,29 @@ sky_http_client_req(
 
         sky_queue_init(&node->free_conns);
         sky_queue_init(&node->tasks);
+        sky_queue_init_node(&node->idle_link);
         node->client = client;
+        node->tls_session = null;
         node->host_hash = host_hash;
         node->port_and_ssl = port_ssl;
         node->conn_num = 0;
         node->free_conn_num = 0;
 
-        rb_tree_insert(&client->tree, node);
+        if (sky_unlikely(!sky_hashmap_put(&client->domains, host_hash, node))) {
+            sky_free(node);
+            call(null, data);
+            return;
+        }
+    } else if (sky_queue_linked(&node->idle_link)) {
+        sky_queue_remove(&node->idle_link);
+        --client->idle_node_n;
     }
 
     sky_queue_t *const next = sky_queue_next(&node->free_conns);
     if (next == &node->free_conns) {
         if (node->conn_num < client->domain_conn_max) {
             if (domain_node_is_ssl(node)) {
-                https_client_connect_t *const connect = sky_malloc(sizeof(https_client_connect_t));
+                https_client_connect_t *const connect = sky_slab_alloc(&client->tls_conn_slab);
                 sky_tcp_init(&connect->conn.tcp, sky_event_selector(client->ev_loop));
                 sky_event_timeout_init(client->ev_loop, &connect->conn.timer, null);
                 sky_queue_init_node(&connect->conn.link);
@@ -154,7 +202,7 @@ sky_http_client_req(
                 ++node->conn_num;
                 https_connect_req(&connect->conn, req, call, data);
             } else {
-                sky_http_client_connect_t *const connect = sky_malloc(sizeof(sky_http_client_connect_t));
+                sky_http_client_connect_t *const connect = sky_slab_alloc(&client->conn_slab);
                 sky_tcp_init(&connect->tcp, sky_event_selector(client->ev_loop));
                 sky_event_timeout_init(client->ev_loop, &connect->timer, null);
                 sky_queue_init_node(&connect->link);
@@ -193,7 +241,7 @@ http_connect_release(sky_http_client_connect_t *const connect) {
     if (sky_queue_empty(&node->tasks)) {
         sky_queue_insert_next(&node->free_conns, &connect->link);
         sky_timer_set_cb(&connect->timer, connect_keepalive_timeout);
-        sky_event_timeout_set(node->client->ev_loop, &connect->timer, node->client->keepalive);
+        sky_event_timeout_set_ms(node->client->ev_loop, &connect->timer, node->client->keepalive);
         ++node->free_conn_num;
         return;
     }
@@ -203,65 +251,12 @@ http_connect_release(sky_http_client_connect_t *const connect) {
 }
 
 
-static domain_node_t *
-rb_tree_get(
-        sky_rb_tree_t *const tree,
-        const sky_str_t *const host,
-        const sky_u32_t host_hash,
-        const sky_u32_t port_ssl
-) {
-    sky_rb_node_t *node = tree->root;
-    domain_node_t *tmp;
-    sky_i32_t r;
-
-    while (node != &tree->sentinel) {
-        tmp = sky_type_convert(node, domain_node_t, node);
-        if (tmp->host_hash == host_hash) {
-            if (tmp->port_and_ssl == port_ssl) {
-                r = sky_str_cmp(&tmp->host, host);
-                if (!r) {
-                    return tmp;
-                }
-                node = r > 0 ? node->left : node->right;
-            } else {
-                node = tmp->port_and_ssl > port_ssl ? node->left : node->right;
-            }
-        } else {
-            node = tmp->host_hash > host_hash ? node->left : node->right;
-        }
-    }
+static sky_bool_t
+domain_node_equals(const void *const item, const void *const key) {
+    const domain_node_t *const node = item;
+    const domain_key_t *const domain = key;
 
-    return null;
-}
-
-static void
-rb_tree_insert(sky_rb_tree_t *const tree, domain_node_t *const node) {
-    if (sky_rb_tree_is_empty(tree)) {
-        sky_rb_tree_link(tree, &node->node, null);
-        return;
-    }
-    sky_rb_node_t **p, *temp = tree->root;
-    domain_node_t *other;
-
-    for (;;) {
-        other = sky_type_convert(temp, domain_node_t, node);
-        if (node->host_hash == other->host_hash) {
-            if (node->port_and_ssl == other->port_and_ssl) {
-                p = sky_str_cmp(&node->host, &other->host) < 0 ? &temp->left : &temp->right;
-            } else {
-                p = node->port_and_ssl < other->port_and_ssl ? &temp->left : &temp->right;
-            }
-        } else {
-            p = node->host_hash < other->host_hash ? &temp->left : &temp->right;
-        }
-
-        if (*p == &tree->sentinel) {
-            *p = &node->node;
-            sky_rb_tree_link(tree, &node->node, temp);
-            return;
-        }
-        temp = *p;
-    }
+    return node->port_and_ssl == domain->port_ssl && sky_str_equals(&node->host, domain->host);
 }
 
 static void
@@ -273,7 +268,7 @@ connect_task_next(sky_timer_wheel_entry_t *const timer) {
     if (item == &node->tasks) {
         sky_queue_insert_next(&node->free_conns, &connect->link);
         sky_timer_set_cb(&connect->timer, connect_keepalive_timeout);
-        sky_event_timeout_set(node->client->ev_loop, &connect->timer, node->client->keepalive);
+        sky_event_timeout_set_ms(node->client->ev_loop, &connect->timer, node->client->keepalive);
 
         ++node->free_conn_num;
 
@@ -295,13 +290,62 @@ connect_keepalive_timeout(sky_timer_wheel_entry_t *const timer) {
     sky_http_client_connect_t *const connect = sky_type_convert(timer, sky_http_client_connect_t, timer);
     domain_node_t *const node = connect->node;
 
+    if (domain_node_is_ssl(node)) {
+        https_client_connect_t *const tls_connect = sky_type_convert(connect, https_client_connect_t, conn);
+        sky_tls_destroy(&tls_connect->tls);
+    }
     sky_tcp_close(&connect->tcp);
     sky_queue_remove(&connect->link);
-    sky_free(connect);
+    sky_slab_free(domain_node_is_ssl(node) ? &node->client->tls_conn_slab : &node->client->conn_slab, connect);
     --node->free_conn_num;
 
     if (!(--node->conn_num)) {
-        sky_rb_tree_del(&node->client->tree, &node->node);
-        sky_free(node);
+        domain_node_idle(node);
+    }
+}
+
+static void
+https_session_new(sky_tls_t *const tls, sky_tls_session_t *const session) {
+    https_client_connect_t *const connect = sky_type_convert(tls, https_client_connect_t, tls);
+    domain_node_t *const node = connect->conn.node;
+
+    if (node->tls_session) {
+        sky_tls_session_free(node->tls_session);
+    } else {
+        ++node->client->session_n;
+    }
+    node->tls_session = session;
+}
+
+/**
+ * 域名已无连接，持有会话时保留至超出上限被淘汰，以便下次建连复用会话
+ */
+static void
+domain_node_idle(domain_node_t *const node) {
+    sky_http_client_t *const client = node->client;
+
+    if (!node->tls_session || client->destroy) {
+        domain_node_free(node);
+        return;
+    }
+    sky_queue_insert_prev(&client->idle_nodes, &node->idle_link);
+    if (++client->idle_node_n > client->session_max) {
+        domain_node_free(sky_type_convert(sky_queue_next(&client->idle_nodes), domain_node_t, idle_link));
+    }
+}
+
+static void
+domain_node_free(domain_node_t *const node) {
+    sky_http_client_t *const client = node->client;
+
+    if (sky_queue_linked(&node->idle_link)) {
+        sky_queue_remove(&node->idle_link);
+        --client->idle_node_n;
+    }
+    if (node->tls_session) {
+        sky_tls_session_free(node->tls_session);
+        --client->session_n;
     }
+    sky_hashmap_del(&client->domains, node->host_hash, node);
+    sky_free(node);
 }
\ No newline at end of file
@@ -8,20 +8,29 @@
 
 #include <io/http/http_client.h>
 #include <io/tls.h>
-#include <core/rbtree.h>
+#include <core/hashmap.h>
 #include <core/timer_wheel.h>
 #include <core/buf.h>
+#include <core/slab.h>
 
 typedef struct domain_node_s domain_node_t;
 typedef struct https_client_connect_s https_client_connect_t;
 
 struct sky_http_client_s {
-    sky_rb_tree_t tree;
+    sky_hashmap_t domains;
     sky_tls_ctx_t tls_ctx;
+    sky_queue_t idle_nodes; // 无连接但持有 TLS 会话的域名，队首最久未使用
     sky_event_loop_t *ev_loop;
+    sky_slab_t conn_slab;
+    sky_slab_t tls_conn_slab;
+    sky_u64_t session_hit;
+    sky_u64_t session_miss;
     sky_usize_t body_str_max;
-    sky_u32_t keepalive;
-    sky_u32_t timeout;
+    sky_u32_t session_max;
+    sky_u32_t session_n;
+    sky_u32_t idle_node_n;
+    sky_u32_t keepalive; // ms
+    sky_u32_t timeout; // ms
     sky_u32_t header_buf_size;
     sky_u16_t domain_conn_max;
     sky_u8_t header_buf_n;
@@ -29,12 +38,13 @@ struct sky_http_client_s {
 };
 
 struct domain_node_s {
-    sky_rb_node_t node;
     sky_queue_t free_conns;
     sky_queue_t tasks;
+    sky_queue_t idle_link;
     sky_str_t host;
 
     sky_http_client_t *client;
+    sky_tls_session_t *tls_session;
 
     sky_u32_t host_hash;
     sky_u32_t port_and_ssl;
@@ -136,7 +136,7 @@ client_connect(sky_tcp_t *const tcp) {
         return;
     }
     if (sky_likely(!r)) {
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -237,7 +237,7 @@ client_send_str(sky_tcp_t *const tcp) {
         goto again;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -281,7 +281,7 @@ client_send_vec(sky_tcp_t *const tcp) {
         goto next_vec;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -342,7 +342,7 @@ client_read_res_line(sky_tcp_t *const tcp) {
         goto again;
     }
     if (!n) {
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -443,7 +443,7 @@ client_read_res_header(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         return;
     }
 
@@ -380,7 +380,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         return;
     }
 
@@ -565,7 +565,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         return;
     }
 
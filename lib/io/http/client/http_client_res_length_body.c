@@ -186,7 +186,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
 
         res->content_length_n = size;
         return;
@@ -243,7 +243,7 @@ http_body_read_str(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
         res->content_length_n = size;
         return;
     }
@@ -295,7 +295,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->timer, client->timeout);
 
         res->content_length_n = size;
         return;
@@ -142,12 +142,15 @@ client_connect(sky_tcp_t *const tcp) {
             goto error;
         }
         sky_tls_set_sni_hostname(&connect->tls, &connect->conn.node->host);
+        if (connect->conn.node->tls_session) {
+            sky_tls_set_session(&connect->tls, connect->conn.node->tls_session);
+        }
         sky_tcp_set_cb(tcp, client_handshake);
         client_handshake(tcp);
         return;
     }
     if (sky_likely(!r)) {
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -168,11 +171,16 @@ client_handshake(sky_tcp_t *const tcp) {
 
     const sky_i8_t r = sky_tls_connect(&connect->tls);
     if (r > 0) {
+        if (sky_tls_session_reused(&connect->tls)) {
+            ++client->session_hit;
+        } else {
+            ++client->session_miss;
+        }
         client_send_start(connect);
         return;
     }
     if (sky_likely(!r)) {
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -285,7 +293,7 @@ client_send_str(sky_tcp_t *const tcp) {
         goto again;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -326,7 +334,7 @@ client_send_vec(sky_tcp_t *const tcp) {
     }
 
     if (sky_likely(!n)) {
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -388,7 +396,7 @@ client_read_res_line(sky_tcp_t *const tcp) {
         goto again;
     }
     if (!n) {
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
         return;
     }
@@ -491,7 +499,7 @@ client_read_res_header(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         return;
     }
 
@@ -387,7 +387,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         return;
     }
 
@@ -575,7 +575,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(client->ev_loop, &connect->conn.timer, client->timeout);
+        sky_event_timeout_set_ms(client->ev_loop, &connect->conn.timer, client->timeout);
         return;
     }
 
@@ -5,36 +5,53 @@
 #include <core/memory.h>
 #include "http_server_common.h"
 
-typedef struct {
+struct http_listener_s {
     sky_tcp_t tcp;
     sky_http_server_t *server;
     sky_http_connection_t *conn_tmp;
-} http_listener_t;
+    sky_tls_ctx_t *tls_ctx;
+    http_listener_t *next;
+};
 
 static void http_server_accept(sky_tcp_t *tcp);
 
+static sky_http_connection_t *http_server_conn_alloc(sky_http_server_t *server);
+
+static void http_server_tls_accept(sky_tcp_t *tcp);
+
+static void http_server_tls_timeout(sky_timer_wheel_entry_t *timer);
+
+static void http_server_tls_free(sky_http_connection_t *conn);
+
 sky_api sky_http_server_t *
 sky_http_server_create(sky_event_loop_t *ev_loop, const sky_http_server_conf_t *const conf) {
     sky_pool_t *const pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
     sky_http_server_t *const server = sky_palloc(pool, sizeof(sky_http_server_t));
     server->pool = pool;
+    server->free_pool = null;
+    server->free_pool_n = 0;
     server->ev_loop = ev_loop;
     server->rfc_last = 0;
+    server->listeners = null;
+    sky_slab_init(&server->conn_slab, sizeof(sky_http_connection_t), 0);
 
     if (!conf) {
         server->body_str_max = SKY_USIZE(1048576);
-        server->keep_alive = SKY_U32(75);
-        server->timeout = SKY_U32(30);
+        server->keep_alive = SKY_U32(75000);
+        server->timeout = SKY_U32(30000);
         server->header_buf_size = SKY_U32(2048);
         server->header_buf_n = SKY_U8(4);
     } else {
         server->body_str_max = conf->body_str_max ?: SKY_USIZE(1048576);
-        server->keep_alive = conf->keep_alive ?: SKY_U32(75);
-        server->timeout = conf->timeout ?: SKY_U32(30);
+        server->keep_alive = (conf->keep_alive ?: SKY_U32(75)) * 1000;
+        server->timeout = conf->timeout_ms ?: (conf->timeout ?: SKY_U32(30)) * 1000;
         server->header_buf_size = conf->header_buf_size ?: SKY_U32(2048);
         server->header_buf_n = conf->header_buf_n ?: SKY_U8(4);
     }
+    server->access_buf = conf && conf->access_log ? http_access_buf_create(server, conf->access_log) : null;
     server->host_map = sky_trie_create(server->pool);
+    server->header_tpl = http_header_tpl_create(server->pool);
+    server->gzip = http_gzip_create(server->pool, conf ? conf->gzip : null);
 
     return server;
 }
@@ -83,11 +100,21 @@ sky_api sky_bool_t
 sky_http_server_bind(
         sky_http_server_t *const server,
         const sky_inet_address_t *const address
+) {
+    return sky_http_server_bind_tls(server, address, null);
+}
+
+sky_api sky_bool_t
+sky_http_server_bind_tls(
+        sky_http_server_t *const server,
+        const sky_inet_address_t *const address,
+        sky_tls_ctx_t *const tls_ctx
 ) {
     http_listener_t *const listener = sky_palloc(server->pool, sizeof(http_listener_t));
     sky_tcp_init(&listener->tcp, sky_event_selector(server->ev_loop));
     listener->server = server;
     listener->conn_tmp = null;
+    listener->tls_ctx = tls_ctx;
 
 
     if (sky_unlikely(!sky_tcp_open(&listener->tcp, sky_inet_address_family(address)))) {
@@ -116,47 +143,124 @@ sky_http_server_bind(
         sky_pfree(server->pool, listener, sizeof(http_listener_t));
         return false;
     }
+    listener->next = server->listeners;
+    server->listeners = listener;
     sky_tcp_set_cb(&listener->tcp, http_server_accept);
     http_server_accept(&listener->tcp);
     return true;
 }
 
+sky_api void
+sky_http_server_destroy(sky_http_server_t *const server) {
+    for (http_listener_t *l = server->listeners; l; l = l->next) {
+        sky_tcp_close(&l->tcp);
+    }
+    if (server->access_buf) {
+        http_access_buf_destroy(server->access_buf);
+    }
+    sky_pool_t *pool;
+    while ((pool = server->free_pool)) {
+        server->free_pool = pool->d.next;
+        sky_pool_destroy(pool);
+    }
+    sky_slab_destroy(&server->conn_slab);
+    sky_pool_destroy(server->pool);
+}
+
 static void
 http_server_accept(sky_tcp_t *const tcp) {
     http_listener_t *const l = sky_type_convert(tcp, http_listener_t, tcp);
 
     sky_http_connection_t *conn = l->conn_tmp;
-    if (!conn) {
-        conn = sky_malloc(sizeof(sky_http_connection_t));
-        sky_tcp_init(&conn->tcp, sky_event_selector(l->server->ev_loop));
-        sky_event_timeout_init(l->server->ev_loop, &conn->timer, null);
-        conn->server = l->server;
-    }
+    sky_tcp_t drop;
     sky_i8_t r;
     for (;;) {
+        if (!conn) {
+            conn = http_server_conn_alloc(l->server);
+        }
+        if (sky_unlikely(!conn)) { // 内存不足时接受后直接关闭，避免连接积压在队列中
+            sky_tcp_init(&drop, sky_event_selector(l->server->ev_loop));
+            r = sky_tcp_accept(tcp, &drop);
+            if (r > 0) {
+                sky_tcp_close(&drop);
+                continue;
+            }
+            break;
+        }
         r = sky_tcp_accept(tcp, &conn->tcp);
-        if (r > 0) {
+        if (r <= 0) {
+            break;
+        }
+        if (!l->tls_ctx) {
+            conn->tls.ssl = null;
+            sky_tcp_ring_enable(&conn->tcp); // 支持时收发改为提交模式，失败仍使用就绪模式
             http_server_request_process(conn);
+        } else if (sky_likely(sky_tls_init(l->tls_ctx, &conn->tls, &conn->tcp))) {
+            sky_timer_set_cb(&conn->timer, http_server_tls_timeout);
+            sky_tcp_set_cb(&conn->tcp, http_server_tls_accept);
+            http_server_tls_accept(&conn->tcp);
+        } else {
+            sky_tcp_close(&conn->tcp);
+            sky_slab_free(&l->server->conn_slab, conn);
+        }
+        conn = null;
+    }
+    l->conn_tmp = conn;
 
-            conn = sky_malloc(sizeof(sky_http_connection_t));
-            sky_tcp_init(&conn->tcp, sky_event_selector(l->server->ev_loop));
-            sky_event_timeout_init(l->server->ev_loop, &conn->timer, null);
-            conn->server = l->server;
+    if (sky_likely(!r)) {
+        sky_tcp_try_register(tcp, SKY_EV_READ);
+        return;
+    }
+    if (conn) {
+        sky_slab_free(&l->server->conn_slab, conn);
+        l->conn_tmp = null;
+    }
+    sky_tcp_close(tcp);
+}
 
-            continue;
-        }
-        l->conn_tmp = conn;
+static sky_http_connection_t *
+http_server_conn_alloc(sky_http_server_t *const server) {
+    sky_http_connection_t *const conn = sky_slab_alloc(&server->conn_slab);
+    if (sky_unlikely(!conn)) {
+        return null;
+    }
+    sky_tcp_init(&conn->tcp, sky_event_selector(server->ev_loop));
+    sky_event_timeout_init(server->ev_loop, &conn->timer, null);
+    conn->server = server;
 
-        if (sky_likely(!r)) {
-            sky_tcp_try_register(tcp, SKY_EV_READ);
-            return;
-        }
+    return conn;
+}
 
-        sky_free(l->conn_tmp);
-        l->conn_tmp = null;
-        sky_tcp_close(tcp);
+static void
+http_server_tls_accept(sky_tcp_t *const tcp) {
+    sky_http_connection_t *const conn = sky_type_convert(tcp, sky_http_connection_t, tcp);
 
+    const sky_i8_t r = sky_tls_accept(&conn->tls);
+    if (r > 0) {
+        sky_timer_wheel_unlink(&conn->timer);
+        http_server_request_process(conn);
         return;
     }
+    if (sky_likely(!r)) {
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
+        return;
+    }
+    sky_timer_wheel_unlink(&conn->timer);
+    http_server_tls_free(conn);
 }
 
+static void
+http_server_tls_timeout(sky_timer_wheel_entry_t *const timer) {
+    http_server_tls_free(sky_type_convert(timer, sky_http_connection_t, timer));
+}
+
+/**
+ * 握手阶段还未创建请求，单独释放
+ */
+static void
+http_server_tls_free(sky_http_connection_t *const conn) {
+    sky_tcp_close(&conn->tcp);
+    sky_tls_destroy(&conn->tls);
+    sky_slab_free(&conn->server->conn_slab, conn);
+}
@@ -0,0 +1,320 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#include "http_server_common.h"
+#include <io/http/http_server_access_log.h>
+#include <core/memory.h>
+#include <core/number.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/uio.h>
+
+#define ACCESS_LOG_RECORD_N     256
+#define ACCESS_LOG_URI_MAX      96
+#define ACCESS_LOG_BATCH        64
+#define ACCESS_LOG_FLUSH_MS     1000
+#define ACCESS_LOG_LINE_MAX     (128 + (ACCESS_LOG_URI_MAX << 2))
+
+struct sky_http_access_log_s {
+    sky_i32_t fd;
+    sky_i32_t reopen_seen;
+    char path[];
+};
+
+/**
+ * 定长记录，请求结束时只做拷贝，格式化推迟到批量写入时
+ */
+typedef struct {
+    sky_i64_t time;
+    sky_u64_t bytes;
+    sky_u32_t latency; // us
+    sky_u16_t status;
+    sky_u8_t method_len;
+    sky_u8_t uri_len;
+    sky_uchar_t method[7];
+    sky_bool_t uri_more;
+    sky_uchar_t uri[ACCESS_LOG_URI_MAX];
+} access_record_t;
+
+struct http_access_buf_s {
+    sky_timer_wheel_entry_t timer;
+    sky_http_access_log_t *log;
+    sky_event_loop_t *ev_loop;
+    sky_i64_t date_sec;
+    sky_u32_t n;
+    sky_u32_t date_len;
+    char date[32];
+    access_record_t records[ACCESS_LOG_RECORD_N];
+    struct iovec iov[ACCESS_LOG_BATCH * 3];
+    sky_uchar_t out[ACCESS_LOG_BATCH * ACCESS_LOG_LINE_MAX];
+};
+
+static void access_log_signal(sky_i32_t signo);
+
+static void access_buf_timer(sky_timer_wheel_entry_t *timer);
+
+static void access_buf_flush(http_access_buf_t *buf);
+
+static sky_u32_t access_uri_escape(const access_record_t *record, sky_uchar_t *out);
+
+static void access_log_writev(sky_i32_t fd, struct iovec *iov, sky_u32_t iov_n);
+
+static volatile sig_atomic_t access_log_reopen_n = 0;
+
+sky_api sky_http_access_log_t *
+sky_http_access_log_create(const sky_str_t *const path) {
+    static sky_bool_t signal_init = false;
+
+    sky_http_access_log_t *const log = sky_malloc(sizeof(sky_http_access_log_t) + path->len + 1);
+    if (sky_unlikely(!log)) {
+        return null;
+    }
+    sky_memcpy(log->path, path->data, path->len);
+    log->path[path->len] = '\0';
+
+    log->fd = open(log->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (sky_unlikely(log->fd < 0)) {
+        sky_free(log);
+        return null;
+    }
+    log->reopen_seen = access_log_reopen_n;
+
+    if (!__atomic_exchange_n(&signal_init, true, __ATOMIC_ACQ_REL)) {
+        struct sigaction sa;
+        // 不覆盖使用方已设置的处理函数
+        if (sigaction(SIGUSR1, null, &sa) == 0 && sa.sa_handler == SIG_DFL) {
+            sky_memzero(&sa, sizeof(struct sigaction));
+            sa.sa_handler = access_log_signal;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGUSR1, &sa, null);
+        }
+    }
+
+    return log;
+}
+
+sky_api void
+sky_http_access_log_reopen(sky_http_access_log_t *const log) {
+    // open/dup2/fcntl/close 均为异步信号安全，替换fd号不影响正在使用的 server
+    const sky_i32_t fd = open(log->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (sky_unlikely(fd < 0)) {
+        return;
+    }
+    if (sky_likely(dup2(fd, log->fd) >= 0)) {
+        fcntl(log->fd, F_SETFD, FD_CLOEXEC);
+    }
+    close(fd);
+}
+
+sky_api void
+sky_http_access_log_destroy(sky_http_access_log_t *const log) {
+    close(log->fd);
+    sky_free(log);
+}
+
+http_access_buf_t *
+http_access_buf_create(sky_http_server_t *const server, sky_http_access_log_t *const log) {
+    http_access_buf_t *const buf = sky_palloc(server->pool, sizeof(http_access_buf_t));
+    sky_event_timeout_init(server->ev_loop, &buf->timer, access_buf_timer);
+    buf->log = log;
+    buf->ev_loop = server->ev_loop;
+    buf->date_sec = -1;
+    buf->date_len = 0;
+    buf->n = 0;
+
+    return buf;
+}
+
+void
+http_access_buf_destroy(http_access_buf_t *const buf) {
+    sky_timer_wheel_unlink(&buf->timer);
+    if (buf->n) {
+        access_buf_flush(buf);
+    }
+}
+
+void
+http_access_log_write(sky_http_server_request_t *const r, const sky_u64_t latency) {
+    sky_http_connection_t *const conn = r->conn;
+    http_access_buf_t *const buf = conn->server->access_buf;
+
+    if (sky_unlikely(buf->n == ACCESS_LOG_RECORD_N)) {
+        access_buf_flush(buf);
+    }
+    access_record_t *const record = buf->records + (buf->n++);
+    record->time = sky_event_now(buf->ev_loop);
+    record->bytes = conn->res_size;
+    record->latency = (sky_u32_t) sky_min(latency, SKY_U64(0xFFFFFFFF));
+    record->status = (sky_u16_t) (r->state ?: (r->response ? 200 : 499));
+
+    record->method_len = (sky_u8_t) sky_min(r->method_name.len, sizeof(record->method));
+    sky_memcpy(record->method, r->method_name.data, record->method_len);
+
+    const sky_str_t *const uri = conn->log_uri.len ? &conn->log_uri : &r->uri;
+    record->uri_len = (sky_u8_t) sky_min(uri->len, ACCESS_LOG_URI_MAX);
+    record->uri_more = uri->len > ACCESS_LOG_URI_MAX;
+    sky_memcpy(record->uri, uri->data, record->uri_len);
+
+    if (!sky_timer_linked(&buf->timer)) {
+        sky_event_timeout_set_ms(buf->ev_loop, &buf->timer, ACCESS_LOG_FLUSH_MS);
+    }
+}
+
+static void
+access_log_signal(const sky_i32_t signo) {
+    (void) signo;
+
+    access_log_reopen_n = access_log_reopen_n + 1;
+}
+
+static void
+access_buf_timer(sky_timer_wheel_entry_t *const timer) {
+    http_access_buf_t *const buf = sky_type_convert(timer, http_access_buf_t, timer);
+
+    if (buf->n) {
+        access_buf_flush(buf);
+    }
+}
+
+static void
+access_buf_flush(http_access_buf_t *const buf) {
+    sky_http_access_log_t *const log = buf->log;
+
+    sky_i32_t seen = __atomic_load_n(&log->reopen_seen, __ATOMIC_RELAXED);
+    const sky_i32_t reopen_n = access_log_reopen_n;
+    if (sky_unlikely(seen != reopen_n)) {
+        // 多个事件循环共享时只由一个执行重新打开
+        if (__atomic_compare_exchange_n(
+                &log->reopen_seen,
+                &seen,
+                reopen_n,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_RELAXED
+        )) {
+            sky_http_access_log_reopen(log);
+        }
+    }
+
+    const access_record_t *record = buf->records;
+    struct iovec *const iov = buf->iov;
+    sky_uchar_t *out = buf->out;
+    sky_u32_t iov_n = 0, batch_n = 0, size;
+
+    for (sky_u32_t i = 0; i < buf->n; ++i, ++record) {
+        if (record->time != buf->date_sec) {
+            struct tm tm;
+            const time_t sec = (time_t) record->time;
+            localtime_r(&sec, &tm);
+            buf->date_len = (sky_u32_t) strftime(buf->date, sizeof(buf->date), "%Y-%m-%dT%H:%M:%S%z", &tm);
+            buf->date_sec = record->time;
+        }
+        iov[iov_n].iov_base = out;
+        sky_memcpy(out, buf->date, buf->date_len);
+        out += buf->date_len;
+        *(out++) = ' ';
+        sky_memcpy(out, record->method, record->method_len);
+        out += record->method_len;
+        *(out++) = ' ';
+        iov[iov_n].iov_len = (sky_usize_t) (out - (sky_uchar_t *) iov[iov_n].iov_base);
+        ++iov_n;
+
+        size = access_uri_escape(record, out);
+        if (size) {
+            iov[iov_n].iov_base = out;
+            iov[iov_n++].iov_len = size;
+            out += size;
+        } else {
+            iov[iov_n].iov_base = (void *) record->uri;
+            iov[iov_n++].iov_len = record->uri_len;
+        }
+
+        iov[iov_n].iov_base = out;
+        if (record->uri_more) {
+            sky_memcpy(out, "...", 3);
+            out += 3;
+        }
+        *(out++) = ' ';
+        out += sky_u16_to_str(record->status, out);
+        *(out++) = ' ';
+        out += sky_u64_to_str(record->bytes, out);
+        *(out++) = ' ';
+        out += sky_u32_to_str(record->latency, out);
+        sky_memcpy(out, "us\n", 3);
+        out += 3;
+        iov[iov_n].iov_len = (sky_usize_t) (out - (sky_uchar_t *) iov[iov_n].iov_base);
+        ++iov_n;
+
+        if (++batch_n == ACCESS_LOG_BATCH) {
+            access_log_writev(log->fd, iov, iov_n);
+            out = buf->out;
+            iov_n = 0;
+            batch_n = 0;
+        }
+    }
+    if (iov_n) {
+        access_log_writev(log->fd, iov, iov_n);
+    }
+    buf->n = 0;
+}
+
+/**
+ * uri 含空白或控制字符时转义为 \xHH，避免伪造日志行，无需转义返回0，直接引用记录内容
+ */
+static sky_u32_t
+access_uri_escape(const access_record_t *const record, sky_uchar_t *const out) {
+    static const sky_uchar_t hex[] = "0123456789ABCDEF";
+
+    const sky_uchar_t *p = record->uri, *const end = p + record->uri_len;
+    for (; p < end; ++p) {
+        if (*p <= ' ' || *p == '"' || *p == '\\' || *p >= 0x7F) {
+            break;
+        }
+    }
+    if (sky_likely(p == end)) {
+        return 0;
+    }
+    sky_u32_t size = (sky_u32_t) (p - record->uri);
+    sky_memcpy(out, record->uri, size);
+    for (; p < end; ++p) {
+        if (*p <= ' ' || *p == '"' || *p == '\\' || *p >= 0x7F) {
+            out[size++] = '\\';
+            out[size++] = 'x';
+            out[size++] = hex[*p >> 4];
+            out[size++] = hex[*p & 0xF];
+        } else {
+            out[size++] = *p;
+        }
+    }
+
+    return size;
+}
+
+static void
+access_log_writev(const sky_i32_t fd, struct iovec *iov, sky_u32_t iov_n) {
+    ssize_t n;
+
+    while (iov_n) {
+        n = writev(fd, iov, (sky_i32_t) iov_n);
+        if (sky_unlikely(n < 0)) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        while (iov_n && (sky_usize_t) n >= iov->iov_len) {
+            n -= (ssize_t) iov->iov_len;
+            ++iov;
+            --iov_n;
+        }
+        if (iov_n) {
+            iov->iov_base = (sky_uchar_t *) iov->iov_base + n;
+            iov->iov_len -= (sky_usize_t) n;
+        }
+    }
+}
@@ -11,27 +11,47 @@
 #include <io/http/http_server.h>
 #include <core/buf.h>
 #include <core/trie.h>
+#include <core/slab.h>
 
+#define HTTP_SERVER_POOL_CACHE_MAX 128
+#define HTTP_SERVER_OUT_BUF_SIZE   16384
+
+typedef struct http_access_buf_s http_access_buf_t;
+typedef struct http_header_tpl_s http_header_tpl_t;
+typedef struct http_gzip_s http_gzip_t;
+typedef struct http_gzip_stream_s http_gzip_stream_t;
+typedef struct http_listener_s http_listener_t;
 
 struct sky_http_server_s {
     sky_uchar_t rfc_date[30];
     sky_trie_t *host_map;
     sky_pool_t *pool;
+    sky_pool_t *free_pool; // 复用的请求内存池，通过 d.next 链接
     sky_event_loop_t *ev_loop;
+    sky_slab_t conn_slab;
+    http_listener_t *listeners; // 已绑定的监听，销毁时关闭
+    http_access_buf_t *access_buf; // 未开启访问日志时为null
+    http_header_tpl_t *header_tpl; // 响应头模板缓存
+    http_gzip_t *gzip; // 未开启响应压缩时为null
     sky_time_t rfc_last;
     sky_usize_t body_str_max;
-    sky_u32_t keep_alive;
-    sky_u32_t timeout;
+    sky_u32_t keep_alive; // ms
+    sky_u32_t timeout; // ms
     sky_u32_t header_buf_size;
+    sky_u32_t free_pool_n;
     sky_u8_t header_buf_n;
 };
 
 struct sky_http_connection_s {
     sky_tcp_t tcp;
+    sky_tls_t tls; // 明文连接时 ssl 为null
     sky_timer_wheel_entry_t timer;
     sky_http_server_t *server;
     sky_http_server_request_t *current_req;
     sky_buf_t *buf;
+    sky_pool_t *buf_pool; // buf 所在内存池，流水线请求直接复用读缓冲时与 current_req->pool 不同
+    sky_uchar_t *out_buf; // 流水线响应合并缓冲，按需分配
+    sky_tcp_cb_pt out_next; // 合并缓冲写完后继续执行的回调
 
     union {
         sky_http_server_next_pt next_cb;
@@ -43,9 +63,29 @@ struct sky_http_connection_s {
     };
 
     void *cb_data;
+    sky_str_t log_uri; // 模块执行前的uri，模块可能修改 r->uri
+    sky_u64_t req_start; // 请求开始时间(us)
+    sky_usize_t res_size; // 响应字节数
+    sky_u32_t out_len;
     sky_u8_t free_buf_n;
 };
 
+#define HTTP_GZIP_NONE     SKY_U8(0)
+#define HTTP_GZIP_GZIP     SKY_U8(1)
+#define HTTP_GZIP_DEFLATE  SKY_U8(2)
+
+/**
+ * 流式压缩输出，每次填充生成一个 chunk
+ */
+struct http_gzip_stream_s {
+    sky_str_t out; // 待写出的 chunk
+    void *cb_data;
+    sky_u32_t ev_flag;
+    sky_bool_t end: 1; // 已生成结束 chunk
+    sky_bool_t error: 1; // 线程池中填充失败
+    sky_bool_t offload: 1; // 在线程池中填充
+};
+
 sky_i8_t http_request_line_parse(sky_http_server_request_t *r, sky_buf_t *b);
 
 sky_i8_t http_request_header_parse(sky_http_server_request_t *r, sky_buf_t *b);
@@ -55,6 +95,151 @@ sky_i8_t http_multipart_header_parse(sky_http_server_multipart_t *r, sky_buf_t *
 
 void http_server_request_process(sky_http_connection_t *conn);
 
+/**
+ * 写出合并的流水线响应
+ * @param conn 连接
+ * @param next 需要等待可写时，写完后执行的回调
+ * @return 1写完，0等待可写，-1出错且连接已关闭
+ */
+sky_i8_t http_conn_out_flush(sky_http_connection_t *conn, sky_tcp_cb_pt next);
+
+/**
+ * 写出已确定内容的响应体，调用前需设置 r->response
+ */
+void http_response_str_body(
+        sky_http_server_request_t *r,
+        const sky_uchar_t *data,
+        sky_usize_t data_len,
+        sky_http_server_next_pt call,
+        void *cb_data
+);
+
+/**
+ * 连接读写，TLS 连接直接解密到调用方的缓冲，不经过中间拷贝
+ */
+static sky_inline sky_isize_t
+http_conn_read(sky_http_connection_t *const conn, sky_uchar_t *const data, const sky_usize_t size) {
+    return conn->tls.ssl ? sky_tls_read(&conn->tls, data, size) : sky_tcp_read(&conn->tcp, data, size);
+}
+
+static sky_inline sky_isize_t
+http_conn_write(sky_http_connection_t *const conn, const sky_uchar_t *const data, const sky_usize_t size) {
+    return conn->tls.ssl ? sky_tls_write(&conn->tls, data, size) : sky_tcp_write(&conn->tcp, data, size);
+}
+
+static sky_inline sky_isize_t
+http_conn_write_vec(sky_http_connection_t *const conn, const sky_io_vec_t *const vec, const sky_u32_t num) {
+    return conn->tls.ssl ? sky_tls_write_vec(&conn->tls, vec, num) : sky_tcp_write_vec(&conn->tcp, vec, num);
+}
+
+static sky_inline sky_isize_t
+http_conn_sendfile(
+        sky_http_connection_t *const conn,
+        sky_fs_t *const fs,
+        sky_i64_t *const offset,
+        const sky_usize_t size,
+        const sky_uchar_t *const head,
+        const sky_usize_t head_size
+) {
+    return conn->tls.ssl
+           ? sky_tls_sendfile(&conn->tls, fs, offset, size, head, head_size)
+           : sky_tcp_sendfile(&conn->tcp, fs, offset, size, head, head_size);
+}
+
+static sky_inline void
+http_conn_tls_destroy(sky_http_connection_t *const conn) {
+    if (conn->tls.ssl) {
+        sky_tls_destroy(&conn->tls);
+    }
+}
+
+static sky_inline sky_pool_t *
+http_server_pool_get(sky_http_server_t *const server) {
+    sky_pool_t *const pool = server->free_pool;
+    if (sky_likely(pool)) {
+        server->free_pool = pool->d.next;
+        pool->d.next = null;
+        --server->free_pool_n;
+        return pool;
+    }
+    return sky_pool_create(SKY_POOL_DEFAULT_SIZE);
+}
+
+/**
+ * 归还请求内存池，只缓存单块内存池，避免长期占用大请求扩展出的内存
+ */
+static sky_inline void
+http_server_pool_put(sky_http_server_t *const server, sky_pool_t *const pool) {
+    if (pool->d.next || server->free_pool_n >= HTTP_SERVER_POOL_CACHE_MAX) {
+        sky_pool_destroy(pool);
+        return;
+    }
+    sky_pool_reset(pool);
+    pool->d.next = server->free_pool;
+    server->free_pool = pool;
+    ++server->free_pool_n;
+}
+
+http_header_tpl_t *http_header_tpl_create(sky_pool_t *pool);
+
+http_gzip_t *http_gzip_create(sky_pool_t *pool, const sky_http_server_gzip_conf_t *conf);
+
+/**
+ * 按类型策略与 Accept-Encoding 协商压缩方式，类型需要压缩时追加 Vary 响应头
+ * @param r       请求
+ * @param size    响应体大小
+ * @param chunked 是否以 chunked 输出，HTTP/1.0 不压缩
+ * @return HTTP_GZIP_*
+ */
+sky_u8_t http_gzip_negotiate(sky_http_server_request_t *r, sky_usize_t size, sky_bool_t chunked);
+
+/**
+ * 一次性压缩响应体后执行 http_response_str_body，超过 offload_size 时在线程池中压缩
+ */
+void http_gzip_str(
+        sky_http_server_request_t *r,
+        sky_u8_t encoding,
+        const sky_uchar_t *data,
+        sky_usize_t size,
+        sky_http_server_next_pt call,
+        void *cb_data
+);
+
+/**
+ * 创建文件流式压缩，同时追加 Content-Encoding 响应头
+ * @return 内存不足返回null
+ */
+http_gzip_stream_t *http_gzip_stream_create(
+        sky_http_server_request_t *r,
+        sky_u8_t encoding,
+        sky_socket_t fd,
+        sky_i64_t offset,
+        sky_usize_t size
+);
+
+/**
+ * 读取文件并压缩生成下一个 chunk
+ * @return 是否成功
+ */
+sky_bool_t http_gzip_stream_fill(http_gzip_stream_t *s);
+
+/**
+ * 在线程池中填充，完成后 done 以 conn 为参数在事件循环中执行
+ * @return 提交失败返回false
+ */
+sky_bool_t http_gzip_stream_post(http_gzip_stream_t *s, sky_http_connection_t *conn, sky_event_loop_post_pt done);
+
+void http_gzip_stream_destroy(http_gzip_stream_t *s);
+
+http_access_buf_t *http_access_buf_create(sky_http_server_t *server, sky_http_access_log_t *log);
+
+/**
+ * 写出缓冲中剩余的记录并停止定时刷新
+ */
+void http_access_buf_destroy(http_access_buf_t *buf);
+
+void http_access_log_write(sky_http_server_request_t *r, sky_u64_t latency);
+
 void http_req_length_body_none(sky_http_server_request_t *r, sky_http_server_next_pt call, void *data);
 
 void http_req_length_body_str(sky_http_server_request_t *r, sky_http_server_next_str_pt call, void *data);
@@ -0,0 +1,656 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+
+#include "http_server_common.h"
+#include <core/memory.h>
+#include <core/log.h>
+
+static sky_bool_t gzip_q_zero(const sky_uchar_t *p, const sky_uchar_t *end);
+
+static sky_bool_t gzip_token_equals(const sky_uchar_t *token, sky_usize_t len, const sky_uchar_t *name, sky_usize_t name_len);
+
+#ifdef SKY_HAVE_ZLIB
+
+#include <zlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define HTTP_GZIP_CHUNK      16384
+#define HTTP_GZIP_CHUNK_HEAD 8 // chunk 长度行，16KB 最多4位16进制
+#define HTTP_GZIP_MIN_SIZE   1024
+
+struct http_gzip_s {
+    z_stream zs[2]; // 事件循环中复用，按 gzip、deflate 分别延迟初始化
+    sky_str_t *types;
+    sky_thread_pool_t *thread_pool;
+    sky_u32_t type_n;
+    sky_u32_t min_size;
+    sky_u32_t offload_size;
+    sky_i32_t level;
+    sky_bool_t zs_init[2];
+};
+
+typedef struct {
+    sky_http_server_request_t *r;
+    const sky_uchar_t *data;
+    sky_uchar_t *out;
+    sky_usize_t size;
+    sky_usize_t out_size; // 压缩后大小，0则失败
+    sky_http_server_next_pt call;
+    void *cb_data;
+    sky_i32_t level;
+    sky_u8_t encoding;
+} gzip_str_task_t;
+
+typedef struct {
+    http_gzip_stream_t base;
+    z_stream zs;
+    sky_thread_pool_t *thread_pool;
+    sky_i64_t offset;
+    sky_usize_t size; // 未读取的文件大小
+    sky_socket_t fd;
+    sky_uchar_t in[HTTP_GZIP_CHUNK];
+    sky_uchar_t buf[HTTP_GZIP_CHUNK_HEAD + HTTP_GZIP_CHUNK + 7];
+} gzip_stream_t;
+
+static sky_bool_t gzip_type_match(const http_gzip_t *gzip, const sky_str_t *content_type);
+
+static sky_bool_t gzip_content_encoding_set(sky_http_server_request_t *r, sky_bool_t *vary);
+
+static void gzip_header_push(sky_http_server_request_t *r, sky_u8_t encoding);
+
+static sky_usize_t gzip_deflate(z_stream *zs, const sky_uchar_t *data, sky_usize_t size, sky_uchar_t *out, sky_usize_t out_size);
+
+static void gzip_str_work(void *data);
+
+static void gzip_str_done(sky_event_loop_t *loop, void *data);
+
+static void gzip_stream_work(void *data);
+
+static void http_work_none(sky_tcp_t *tcp);
+
+
+http_gzip_t *
+http_gzip_create(sky_pool_t *const pool, const sky_http_server_gzip_conf_t *const conf) {
+    static const sky_str_t default_types[] = {
+            sky_string("text/*"),
+            sky_string("application/json"),
+            sky_string("application/javascript"),
+            sky_string("application/xml"),
+            sky_string("application/rss+xml"),
+            sky_string("application/atom+xml"),
+            sky_string("image/svg+xml")
+    };
+
+    if (!conf) {
+        return null;
+    }
+    http_gzip_t *const gzip = sky_palloc(pool, sizeof(http_gzip_t));
+    const sky_str_t *types = conf->types;
+    sky_u32_t type_n = conf->type_n;
+    if (!types) {
+        types = default_types;
+        type_n = sizeof(default_types) / sizeof(sky_str_t);
+    }
+    gzip->types = sky_palloc(pool, sizeof(sky_str_t) * type_n);
+    for (sky_u32_t i = 0; i < type_n; ++i) {
+        gzip->types[i].len = types[i].len;
+        gzip->types[i].data = sky_palloc(pool, types[i].len);
+        sky_memcpy(gzip->types[i].data, types[i].data, types[i].len);
+        sky_str_lower2(gzip->types + i);
+    }
+    gzip->type_n = type_n;
+    gzip->thread_pool = conf->offload_size ? conf->thread_pool : null;
+    gzip->min_size = conf->min_size ?: HTTP_GZIP_MIN_SIZE;
+    gzip->offload_size = conf->offload_size;
+    gzip->level = (conf->level && conf->level <= 9) ? conf->level : Z_DEFAULT_COMPRESSION;
+    gzip->zs_init[0] = false;
+    gzip->zs_init[1] = false;
+
+    return gzip;
+}
+
+sky_api sky_bool_t
+sky_http_response_compressible(const sky_http_server_request_t *const r, const sky_usize_t size) {
+    const http_gzip_t *const gzip = r->conn->server->gzip;
+
+    return gzip && size >= gzip->min_size && gzip_type_match(gzip, &r->headers_out.content_type);
+}
+
+sky_u8_t
+http_gzip_negotiate(sky_http_server_request_t *const r, const sky_usize_t size, const sky_bool_t chunked) {
+    const http_gzip_t *const gzip = r->conn->server->gzip;
+
+    if (size < gzip->min_size
+        || r->state == 204 || r->state == 206 || r->state == 304
+        || !gzip_type_match(gzip, &r->headers_out.content_type)) {
+        return HTTP_GZIP_NONE;
+    }
+    sky_bool_t vary;
+    if (gzip_content_encoding_set(r, &vary)) {
+        return HTTP_GZIP_NONE;
+    }
+    if (!vary) { // 内容随 Accept-Encoding 变化，无论本次是否压缩都需告知缓存
+        sky_http_server_header_t *const header = sky_list_push(&r->headers_out.headers);
+        sky_str_set(&header->key, "Vary");
+        sky_str_set(&header->val, "Accept-Encoding");
+    }
+    if (chunked && r->version_name.data[7] != '1') {
+        return HTTP_GZIP_NONE;
+    }
+    const sky_u8_t accept = sky_http_req_accept_encoding(r);
+    if (accept & SKY_HTTP_ENCODING_GZIP) {
+        return HTTP_GZIP_GZIP;
+    }
+    if (accept & SKY_HTTP_ENCODING_DEFLATE) {
+        return HTTP_GZIP_DEFLATE;
+    }
+
+    return HTTP_GZIP_NONE;
+}
+
+void
+http_gzip_str(
+        sky_http_server_request_t *const r,
+        const sky_u8_t encoding,
+        const sky_uchar_t *const data,
+        const sky_usize_t size,
+        const sky_http_server_next_pt call,
+        void *const cb_data
+) {
+    http_gzip_t *const gzip = r->conn->server->gzip;
+    const sky_usize_t out_size = compressBound((uLong) size) + 18; // gzip 头尾比 zlib 多12字节
+
+    if (sky_unlikely(size > SKY_U32_MAX)) {
+        http_response_str_body(r, data, size, call, cb_data);
+        return;
+    }
+
+    if (gzip->thread_pool && size > gzip->offload_size) {
+        gzip_str_task_t *const task = sky_palloc(r->pool, sizeof(gzip_str_task_t));
+        task->r = r;
+        task->data = data;
+        task->out = sky_palloc(r->pool, out_size);
+        task->size = size;
+        task->out_size = out_size;
+        task->call = call;
+        task->cb_data = cb_data;
+        task->level = gzip->level;
+        task->encoding = encoding;
+
+        sky_tcp_set_cb(&r->conn->tcp, http_work_none);
+        if (sky_likely(sky_thread_pool_submit(
+                gzip->thread_pool,
+                gzip_str_work,
+                task,
+                r->conn->server->ev_loop,
+                gzip_str_done
+        ))) {
+            return;
+        }
+        // 队列已满时在事件循环中压缩
+    }
+    const sky_u32_t index = encoding - HTTP_GZIP_GZIP;
+    z_stream *const zs = gzip->zs + index;
+    if (!gzip->zs_init[index]) {
+        sky_memzero(zs, sizeof(z_stream));
+        if (sky_unlikely(deflateInit2(
+                zs,
+                gzip->level,
+                Z_DEFLATED,
+                encoding == HTTP_GZIP_GZIP ? (MAX_WBITS + 16) : MAX_WBITS,
+                8,
+                Z_DEFAULT_STRATEGY
+        ) != Z_OK)) {
+            http_response_str_body(r, data, size, call, cb_data);
+            return;
+        }
+        gzip->zs_init[index] = true;
+    } else {
+        deflateReset(zs);
+    }
+    sky_uchar_t *const out = sky_palloc(r->pool, out_size);
+    const sky_usize_t n = gzip_deflate(zs, data, size, out, out_size);
+    if (sky_unlikely(!n || n >= size)) {
+        sky_pfree(r->pool, out, out_size);
+        http_response_str_body(r, data, size, call, cb_data);
+        return;
+    }
+    sky_pfree(r->pool, out + n, out_size - n);
+    gzip_header_push(r, encoding);
+    http_response_str_body(r, out, n, call, cb_data);
+}
+
+http_gzip_stream_t *
+http_gzip_stream_create(
+        sky_http_server_request_t *const r,
+        const sky_u8_t encoding,
+        const sky_socket_t fd,
+        const sky_i64_t offset,
+        const sky_usize_t size
+) {
+    const http_gzip_t *const gzip = r->conn->server->gzip;
+    gzip_stream_t *const s = sky_malloc(sizeof(gzip_stream_t));
+    if (sky_unlikely(!s)) {
+        return null;
+    }
+    sky_memzero(&s->zs, sizeof(z_stream));
+    if (sky_unlikely(deflateInit2(
+            &s->zs,
+            gzip->level,
+            Z_DEFLATED,
+            encoding == HTTP_GZIP_GZIP ? (MAX_WBITS + 16) : MAX_WBITS,
+            8,
+            Z_DEFAULT_STRATEGY
+    ) != Z_OK)) {
+        sky_free(s);
+        return null;
+    }
+    sky_str_null(&s->base.out);
+    s->base.cb_data = null;
+    s->base.ev_flag = 0;
+    s->base.end = false;
+    s->base.error = false;
+    s->base.offload = gzip->thread_pool && size > gzip->offload_size;
+    s->thread_pool = gzip->thread_pool;
+    s->offset = offset;
+    s->size = size;
+    s->fd = fd;
+
+    gzip_header_push(r, encoding);
+
+    return &s->base;
+}
+
+sky_bool_t
+http_gzip_stream_fill(http_gzip_stream_t *const stream) {
+    static const sky_uchar_t hex[] = "0123456789abcdef";
+
+    gzip_stream_t *const s = (gzip_stream_t *) stream;
+    z_stream *const zs = &s->zs;
+    sky_uchar_t *const data = s->buf + HTTP_GZIP_CHUNK_HEAD;
+    sky_isize_t n;
+    sky_i32_t ret;
+
+    zs->next_out = data;
+    zs->avail_out = HTTP_GZIP_CHUNK;
+    do {
+        if (!zs->avail_in && s->size) {
+            n = pread(s->fd, s->in, sky_min(s->size, HTTP_GZIP_CHUNK), s->offset);
+            if (sky_unlikely(n <= 0)) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false; // 文件被截断
+            }
+            s->offset += n;
+            s->size -= (sky_usize_t) n;
+            zs->next_in = s->in;
+            zs->avail_in = (uInt) n;
+        }
+        ret = deflate(zs, s->size ? Z_NO_FLUSH : Z_FINISH);
+        if (ret == Z_STREAM_END) {
+            stream->end = true;
+            break;
+        }
+        if (sky_unlikely(ret != Z_OK)) {
+            return false;
+        }
+    } while (zs->avail_out);
+
+    sky_usize_t size = HTTP_GZIP_CHUNK - zs->avail_out;
+    sky_uchar_t *start = data, *p = data + size;
+    if (size) {
+        *(p++) = '\r';
+        *(p++) = '\n';
+        *(--start) = '\n';
+        *(--start) = '\r';
+        do {
+            *(--start) = hex[size & 0xF];
+            size >>= 4;
+        } while (size);
+    }
+    if (stream->end) {
+        sky_memcpy(p, "0\r\n\r\n", 5);
+        p += 5;
+    }
+    stream->out.data = start;
+    stream->out.len = (sky_usize_t) (p - start);
+
+    return true;
+}
+
+sky_bool_t
+http_gzip_stream_post(
+        http_gzip_stream_t *const stream,
+        sky_http_connection_t *const conn,
+        const sky_event_loop_post_pt done
+) {
+    const gzip_stream_t *const s = (gzip_stream_t *) stream;
+
+    return sky_thread_pool_submit(s->thread_pool, gzip_stream_work, conn, conn->server->ev_loop, done);
+}
+
+void
+http_gzip_stream_destroy(http_gzip_stream_t *const stream) {
+    gzip_stream_t *const s = (gzip_stream_t *) stream;
+
+    deflateEnd(&s->zs);
+    sky_free(s);
+}
+
+static sky_bool_t
+gzip_type_match(const http_gzip_t *const gzip, const sky_str_t *const content_type) {
+    sky_str_t type = *content_type;
+    if (!type.len) {
+        sky_str_set(&type, "text/plain");
+    } else {
+        const sky_isize_t index = sky_str_index_char(&type, ';');
+        if (index != -1) {
+            type.len = (sky_usize_t) index;
+        }
+        while (type.len && type.data[type.len - 1] == ' ') {
+            --type.len;
+        }
+    }
+    const sky_str_t *item = gzip->types;
+    for (sky_u32_t i = 0; i < gzip->type_n; ++i, ++item) {
+        if (item->len && item->data[item->len - 1] == '*') {
+            if (type.len >= item->len - 1 && gzip_token_equals(type.data, item->len - 1, item->data, item->len - 1)) {
+                return true;
+            }
+        } else if (gzip_token_equals(type.data, type.len, item->data, item->len)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * 响应头是否已设置 Content-Encoding，同时检查是否已有 Vary
+ */
+static sky_bool_t
+gzip_content_encoding_set(sky_http_server_request_t *const r, sky_bool_t *const vary) {
+    *vary = false;
+    sky_list_foreach(&r->headers_out.headers, sky_http_server_header_t, item, {
+        if (gzip_token_equals(item->key.data, item->key.len, sky_str_line("content-encoding"))) {
+            return true;
+        }
+        if (gzip_token_equals(item->key.data, item->key.len, sky_str_line("vary"))) {
+            *vary = true;
+        }
+    });
+
+    return false;
+}
+
+static sky_inline void
+gzip_header_push(sky_http_server_request_t *const r, const sky_u8_t encoding) {
+    sky_http_server_header_t *const header = sky_list_push(&r->headers_out.headers);
+    sky_str_set(&header->key, "Content-Encoding");
+    if (encoding == HTTP_GZIP_GZIP) {
+        sky_str_set(&header->val, "gzip");
+    } else {
+        sky_str_set(&header->val, "deflate");
+    }
+}
+
+static sky_usize_t
+gzip_deflate(
+        z_stream *const zs,
+        const sky_uchar_t *const data,
+        const sky_usize_t size,
+        sky_uchar_t *const out,
+        const sky_usize_t out_size
+) {
+    zs->next_in = (Bytef *) data;
+    zs->avail_in = (uInt) size;
+    zs->next_out = out;
+    zs->avail_out = (uInt) out_size;
+
+    if (sky_unlikely(deflate(zs, Z_FINISH) != Z_STREAM_END)) {
+        return 0;
+    }
+
+    return out_size - zs->avail_out;
+}
+
+static void
+gzip_str_work(void *const data) {
+    gzip_str_task_t *const task = data;
+    z_stream zs;
+
+    sky_memzero(&zs, sizeof(z_stream));
+    if (sky_unlikely(deflateInit2(
+            &zs,
+            task->level,
+            Z_DEFLATED,
+            task->encoding == HTTP_GZIP_GZIP ? (MAX_WBITS + 16) : MAX_WBITS,
+            8,
+            Z_DEFAULT_STRATEGY
+    ) != Z_OK)) {
+        task->out_size = 0;
+        return;
+    }
+    task->out_size = gzip_deflate(&zs, task->data, task->size, task->out, task->out_size);
+    deflateEnd(&zs);
+}
+
+static void
+gzip_str_done(sky_event_loop_t *const loop, void *const data) {
+    (void) loop;
+
+    gzip_str_task_t *const task = data;
+    sky_http_server_request_t *const r = task->r;
+
+    if (sky_unlikely(!task->out_size || task->out_size >= task->size)) {
+        http_response_str_body(r, task->data, task->size, task->call, task->cb_data);
+        return;
+    }
+    gzip_header_push(r, task->encoding);
+    http_response_str_body(r, task->out, task->out_size, task->call, task->cb_data);
+}
+
+static void
+gzip_stream_work(void *const data) {
+    const sky_http_connection_t *const conn = data;
+    http_gzip_stream_t *const stream = conn->cb_data;
+
+    stream->error = !http_gzip_stream_fill(stream);
+}
+
+static void
+http_work_none(sky_tcp_t *const tcp) {
+    if (sky_unlikely(sky_ev_error(sky_tcp_ev(tcp)))) {
+        sky_tcp_close(tcp);
+    }
+}
+
+#else
+
+http_gzip_t *
+http_gzip_create(sky_pool_t *const pool, const sky_http_server_gzip_conf_t *const conf) {
+    (void) pool;
+
+    if (conf) {
+        sky_log_warn("not found zlib, response compression disabled");
+    }
+
+    return null;
+}
+
+sky_api sky_bool_t
+sky_http_response_compressible(const sky_http_server_request_t *const r, const sky_usize_t size) {
+    (void) r;
+    (void) size;
+
+    return false;
+}
+
+sky_u8_t
+http_gzip_negotiate(sky_http_server_request_t *const r, const sky_usize_t size, const sky_bool_t chunked) {
+    (void) r;
+    (void) size;
+    (void) chunked;
+
+    return HTTP_GZIP_NONE;
+}
+
+void
+http_gzip_str(
+        sky_http_server_request_t *const r,
+        const sky_u8_t encoding,
+        const sky_uchar_t *const data,
+        const sky_usize_t size,
+        const sky_http_server_next_pt call,
+        void *const cb_data
+) {
+    (void) encoding;
+
+    http_response_str_body(r, data, size, call, cb_data);
+}
+
+http_gzip_stream_t *
+http_gzip_stream_create(
+        sky_http_server_request_t *const r,
+        const sky_u8_t encoding,
+        const sky_socket_t fd,
+        const sky_i64_t offset,
+        const sky_usize_t size
+) {
+    (void) r;
+    (void) encoding;
+    (void) fd;
+    (void) offset;
+    (void) size;
+
+    return null;
+}
+
+sky_bool_t
+http_gzip_stream_fill(http_gzip_stream_t *const stream) {
+    (void) stream;
+
+    return false;
+}
+
+sky_bool_t
+http_gzip_stream_post(
+        http_gzip_stream_t *const stream,
+        sky_http_connection_t *const conn,
+        const sky_event_loop_post_pt done
+) {
+    (void) stream;
+    (void) conn;
+    (void) done;
+
+    return false;
+}
+
+void
+http_gzip_stream_destroy(http_gzip_stream_t *const stream) {
+    (void) stream;
+}
+
+#endif
+
+sky_api sky_u8_t
+sky_http_req_accept_encoding(const sky_http_server_request_t *const r) {
+    const sky_str_t *const value = r->headers_in.accept_encoding;
+    if (!value) {
+        return 0;
+    }
+    const sky_uchar_t *p = value->data, *const end = p + value->len, *token, *param;
+    sky_usize_t len;
+    sky_u8_t accept = 0, refuse = 0, any = 0, mask;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            ++p;
+        }
+        token = p;
+        while (p < end && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') {
+            ++p;
+        }
+        len = (sky_usize_t) (p - token);
+        param = p;
+        while (p < end && *p != ',') {
+            ++p;
+        }
+        if (!len) {
+            continue;
+        }
+        if (gzip_token_equals(token, len, sky_str_line("gzip"))
+            || gzip_token_equals(token, len, sky_str_line("x-gzip"))) {
+            mask = SKY_HTTP_ENCODING_GZIP;
+        } else if (gzip_token_equals(token, len, sky_str_line("br"))) {
+            mask = SKY_HTTP_ENCODING_BR;
+        } else if (gzip_token_equals(token, len, sky_str_line("deflate"))) {
+            mask = SKY_HTTP_ENCODING_DEFLATE;
+        } else if (len == 1 && *token == '*') {
+            any = gzip_q_zero(param, p) ? 2 : 1;
+            continue;
+        } else {
+            continue;
+        }
+        if (gzip_q_zero(param, p)) {
+            refuse |= mask;
+        } else {
+            accept |= mask;
+        }
+    }
+    if (any == 1) { // "*" 匹配未列出的编码
+        accept |= (SKY_HTTP_ENCODING_GZIP | SKY_HTTP_ENCODING_DEFLATE | SKY_HTTP_ENCODING_BR) & ~refuse;
+    }
+
+    return accept;
+}
+
+/**
+ * 参数中 q 值是否为0，如 ";q=0"、";q=0.000"
+ */
+static sky_bool_t
+gzip_q_zero(const sky_uchar_t *p, const sky_uchar_t *const end) {
+    for (; p < end; ++p) {
+        if ((*p | 0x20) == 'q' && (p + 1) < end && p[1] == '=') {
+            p += 2;
+            if (p == end || *p != '0') {
+                return false;
+            }
+            for (++p; p < end && (*p == '0' || *p == '.'); ++p);
+
+            return p == end || *p == ' ' || *p == '\t' || *p == ';';
+        }
+    }
+
+    return false;
+}
+
+/**
+ * 与小写的 name 比较，忽略大小写
+ */
+static sky_bool_t
+gzip_token_equals(
+        const sky_uchar_t *const token,
+        const sky_usize_t len,
+        const sky_uchar_t *const name,
+        const sky_usize_t name_len
+) {
+    if (len != name_len) {
+        return false;
+    }
+    sky_uchar_t ch;
+    for (sky_usize_t i = 0; i < len; ++i) {
+        ch = token[i];
+        if (ch >= 'A' && ch <= 'Z') {
+            ch |= 0x20;
+        }
+        if (ch != name[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
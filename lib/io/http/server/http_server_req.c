@@ -6,24 +6,36 @@
 #include <core/memory.h>
 
 
-static void http_server_request_set(sky_http_connection_t *conn, sky_pool_t *pool, sky_usize_t buf_size);
+static void http_server_request_set(sky_http_connection_t *conn, sky_pool_t *pool);
+
+static void http_server_buf_set(sky_http_connection_t *conn, sky_pool_t *pool, sky_usize_t buf_size);
 
 static void http_line_next(sky_http_connection_t *conn, sky_http_server_request_t *r, sky_buf_t *buf);
 
+static void http_buf_rebuild(sky_http_connection_t *conn, sky_http_server_request_t *r, sky_buf_t *buf);
+
 static void http_line_cb(sky_tcp_t *tcp);
 
 static void http_header_read(sky_tcp_t *tcp);
 
 static void http_module_run(sky_http_server_request_t *r);
 
+static void http_module_flush_cb(sky_tcp_t *tcp);
+
+static void http_module_handle(sky_http_server_request_t *r);
+
 static void http_server_req_finish(sky_http_server_request_t *r, void *data);
 
+static void http_server_req_done(sky_http_server_request_t *r);
+
 static void http_work_none(sky_tcp_t *tcp);
 
 static void http_read_timeout(sky_timer_wheel_entry_t *timer);
 
 static void http_server_request_next(sky_timer_wheel_entry_t *timer);
 
+static void http_conn_pool_put(sky_http_connection_t *conn);
+
 static void http_conn_free(sky_http_connection_t *conn);
 
 
@@ -32,6 +44,7 @@ sky_http_server_req_finish(sky_http_server_request_t *const r) {
     sky_http_connection_t *const conn = r->conn;
 
     if (sky_unlikely(!sky_tcp_is_open(&conn->tcp))) {
+        http_server_req_done(r);
         http_conn_free(conn);
         return;
     }
@@ -49,15 +62,18 @@ sky_http_server_req_finish(sky_http_server_request_t *const r) {
 
 void
 http_server_request_process(sky_http_connection_t *const conn) {
-    sky_pool_t *const pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
-    http_server_request_set(conn, pool, conn->server->header_buf_size);
+    sky_pool_t *const pool = http_server_pool_get(conn->server);
+    http_server_request_set(conn, pool);
+    http_server_buf_set(conn, pool, conn->server->header_buf_size);
+    conn->out_buf = null;
+    conn->out_len = 0;
 
     sky_tcp_set_cb(&conn->tcp, http_line_cb);
     http_line_cb(&conn->tcp);
 }
 
 static sky_inline void
-http_server_request_set(sky_http_connection_t *const conn, sky_pool_t *const pool, const sky_usize_t buf_size) {
+http_server_request_set(sky_http_connection_t *const conn, sky_pool_t *const pool) {
     sky_http_server_t *const server = conn->server;
     sky_http_server_request_t *const r = sky_pcalloc(pool, sizeof(sky_http_server_request_t));
     r->pool = pool;
@@ -68,10 +84,18 @@ http_server_request_set(sky_http_connection_t *const conn, sky_pool_t *const poo
 
     sky_timer_set_cb(&conn->timer, http_read_timeout);
     conn->current_req = r;
-    conn->buf = sky_buf_create(pool, buf_size);
+    sky_str_null(&conn->log_uri);
+    conn->req_start = 0;
+    conn->res_size = 0;
     conn->free_buf_n = server->header_buf_n;
 }
 
+static sky_inline void
+http_server_buf_set(sky_http_connection_t *const conn, sky_pool_t *const pool, const sky_usize_t buf_size) {
+    conn->buf = sky_buf_create(pool, buf_size);
+    conn->buf_pool = pool;
+}
+
 static void
 http_line_next(sky_http_connection_t *const conn, sky_http_server_request_t *const r, sky_buf_t *const buf) {
     sky_i8_t i = http_request_header_parse(r, buf);
@@ -86,15 +110,7 @@ http_line_next(sky_http_connection_t *const conn, sky_http_server_request_t *con
         if (sky_unlikely(--conn->free_buf_n == 0)) {
             goto error;
         }
-        if (r->req_pos) {
-            const sky_u32_t n = (sky_u32_t) (buf->pos - r->req_pos);
-            buf->pos -= n;
-            sky_buf_rebuild(buf, conn->server->header_buf_size);
-            r->req_pos = buf->pos;
-            buf->pos += n;
-        } else {
-            sky_buf_rebuild(buf, conn->server->header_buf_size);
-        }
+        http_buf_rebuild(conn, r, buf);
     }
     sky_tcp_set_cb(&conn->tcp, http_header_read);
     http_header_read(&conn->tcp);
@@ -104,6 +120,22 @@ http_line_next(sky_http_connection_t *const conn, sky_http_server_request_t *con
     http_conn_free(conn);
 }
 
+/**
+ * 读缓冲已满时重建，保留正在解析的数据
+ */
+static void
+http_buf_rebuild(sky_http_connection_t *const conn, sky_http_server_request_t *const r, sky_buf_t *const buf) {
+    if (r->req_pos) {
+        const sky_usize_t n = (sky_usize_t) (buf->pos - r->req_pos);
+        buf->pos -= n;
+        sky_buf_rebuild(buf, conn->server->header_buf_size);
+        r->req_pos = buf->pos;
+        buf->pos += n;
+    } else {
+        sky_buf_rebuild(buf, conn->server->header_buf_size);
+    }
+}
+
 static void
 http_line_cb(sky_tcp_t *const tcp) {
     sky_http_connection_t *const conn = sky_type_convert(tcp, sky_http_connection_t, tcp);
@@ -115,8 +147,11 @@ http_line_cb(sky_tcp_t *const tcp) {
     sky_i8_t i;
 
     again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
+        if (!conn->req_start) {
+            conn->req_start = sky_event_now_us(conn->server->ev_loop);
+        }
         buf->last += n;
         i = http_request_line_parse(r, buf);
         if (i > 0) {
@@ -130,11 +165,20 @@ http_line_cb(sky_tcp_t *const tcp) {
     }
 
     if (sky_likely(!n)) {
+        if (conn->out_len) { // 已读请求处理完毕，等待读取前写出合并的响应
+            i = http_conn_out_flush(conn, http_line_cb);
+            if (sky_unlikely(i < 0)) {
+                goto error;
+            }
+            if (!i) {
+                return;
+            }
+        }
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
         if (sky_timer_linked(&conn->timer)) {
-            sky_event_timeout_expired(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+            sky_event_timeout_expired_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         } else {
-            sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->keep_alive);
+            sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->keep_alive);
         }
         return;
     }
@@ -154,7 +198,7 @@ http_header_read(sky_tcp_t *const tcp) {
     sky_i8_t i;
 
     again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
         i = http_request_header_parse(r, buf);
@@ -169,23 +213,24 @@ http_header_read(sky_tcp_t *const tcp) {
             if (sky_unlikely(--conn->free_buf_n == 0)) {
                 goto error;
             }
-            if (r->req_pos) {
-                n = (sky_isize_t) (buf->pos - r->req_pos);
-                buf->pos -= n;
-                sky_buf_rebuild(buf, conn->server->header_buf_size);
-                r->req_pos = buf->pos;
-                buf->pos += n;
-            } else {
-                sky_buf_rebuild(buf, conn->server->header_buf_size);
-            }
+            http_buf_rebuild(conn, r, buf);
         }
 
         goto again;
     }
 
     if (sky_likely(!n)) {
+        if (conn->out_len) {
+            i = http_conn_out_flush(conn, http_header_read);
+            if (sky_unlikely(i < 0)) {
+                goto error;
+            }
+            if (!i) {
+                return;
+            }
+        }
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -196,8 +241,35 @@ http_header_read(sky_tcp_t *const tcp) {
 
 static sky_inline void
 http_module_run(sky_http_server_request_t *const r) {
-    sky_timer_wheel_unlink(&r->conn->timer);
-    sky_tcp_set_cb(&r->conn->tcp, http_work_none);
+    sky_http_connection_t *const conn = r->conn;
+    sky_timer_wheel_unlink(&conn->timer);
+    sky_tcp_set_cb(&conn->tcp, http_work_none);
+
+    // 已无缓冲的后续请求，先写出合并的响应，避免被异步处理的请求阻塞
+    if (conn->out_len && conn->buf->pos == conn->buf->last) {
+        const sky_i8_t i = http_conn_out_flush(conn, http_module_flush_cb);
+        if (!i) {
+            return;
+        }
+        if (sky_unlikely(i < 0)) {
+            http_conn_free(conn);
+            return;
+        }
+    }
+    http_module_handle(r);
+}
+
+static void
+http_module_flush_cb(sky_tcp_t *const tcp) {
+    sky_http_connection_t *const conn = sky_type_convert(tcp, sky_http_connection_t, tcp);
+
+    sky_tcp_set_cb(tcp, http_work_none);
+    http_module_handle(conn->current_req);
+}
+
+static void
+http_module_handle(sky_http_server_request_t *const r) {
+    r->conn->log_uri = r->uri;
 
     const sky_str_t *const host = r->headers_in.host;
     const sky_trie_t *host_trie;
@@ -233,6 +305,7 @@ http_server_req_finish(sky_http_server_request_t *r, void *const data) {
     (void) data;
 
     sky_http_connection_t *const conn = r->conn;
+    http_server_req_done(r);
     if (!r->keep_alive || !sky_tcp_is_open(&conn->tcp)) {
         http_conn_free(conn);
         return;
@@ -242,6 +315,24 @@ http_server_req_finish(sky_http_server_request_t *r, void *const data) {
     sky_timer_wheel_link(&conn->timer, 0);
 }
 
+/**
+ * 请求结束，记录统计与访问日志
+ */
+static void
+http_server_req_done(sky_http_server_request_t *const r) {
+    sky_http_connection_t *const conn = r->conn;
+    sky_u64_t latency = 0;
+
+    if (sky_likely(conn->req_start)) {
+        latency = sky_event_clock_us() - conn->req_start;
+
+        sky_histogram_record(&sky_event_loop_metrics(conn->server->ev_loop)->req_hist, latency);
+    }
+    if (conn->server->access_buf) {
+        http_access_log_write(r, latency);
+    }
+}
+
 static void
 http_work_none(sky_tcp_t *const tcp) {
     if (sky_unlikely(sky_ev_error(sky_tcp_ev(tcp)))) {
@@ -254,35 +345,43 @@ static void
 http_read_timeout(sky_timer_wheel_entry_t *const timer) {
     sky_http_connection_t *const conn = sky_type_convert(timer, sky_http_connection_t, timer);
 
-    sky_pool_destroy(conn->current_req->pool);
     sky_tcp_close(&conn->tcp);
-    sky_free(conn);
+    http_conn_tls_destroy(conn);
+    http_conn_pool_put(conn);
+    sky_slab_free(&conn->server->conn_slab, conn);
 }
 
 static void
 http_server_request_next(sky_timer_wheel_entry_t *const timer) {
     sky_http_connection_t *const conn = sky_type_convert(timer, sky_http_connection_t, timer);
+    sky_http_server_t *const server = conn->server;
     sky_http_server_request_t *r = conn->current_req;
+    sky_pool_t *const buf_pool = conn->buf_pool;
     sky_buf_t *const old_buf = conn->buf;
 
+    if (r->pool != buf_pool) {
+        http_server_pool_put(server, r->pool);
+    }
     if (old_buf->pos == old_buf->last) {
-        sky_pool_t *const pool = r->pool;
-        sky_pool_reset(pool);
-        http_server_request_set(conn, pool, conn->server->header_buf_size);
+        sky_pool_reset(buf_pool);
+        http_server_request_set(conn, buf_pool);
+        http_server_buf_set(conn, buf_pool, server->header_buf_size);
         sky_tcp_set_cb(&conn->tcp, http_line_cb);
         http_line_cb(&conn->tcp);
         return;
     }
-
-    const sky_u32_t read_n = (sky_u32_t) (old_buf->last - old_buf->pos);
-    sky_u32_t buf_size = conn->server->header_buf_size;
-    buf_size = sky_max(buf_size, read_n);
-
-    sky_pool_t *const pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
-    http_server_request_set(conn, pool, buf_size);
-    sky_memcpy(conn->buf->pos, old_buf->pos, read_n);
-    conn->buf->last += read_n;
-    sky_pool_destroy(r->pool);
+    sky_pool_t *const pool = http_server_pool_get(server);
+    http_server_request_set(conn, pool);
+    conn->req_start = sky_event_now_us(server->ev_loop);
+
+    if (buf_pool->d.next) {
+        // 读缓冲所在内存池已扩展，剩余数据迁移到新内存池，避免连续流水线请求时内存只增不减
+        const sky_u32_t read_n = (sky_u32_t) (old_buf->last - old_buf->pos);
+        http_server_buf_set(conn, pool, sky_max(server->header_buf_size, read_n));
+        sky_memcpy(conn->buf->pos, old_buf->pos, read_n);
+        conn->buf->last += read_n;
+        http_server_pool_put(server, buf_pool);
+    }
 
     r = conn->current_req;
     sky_buf_t *const buf = conn->buf;
@@ -292,9 +391,12 @@ http_server_request_next(sky_timer_wheel_entry_t *const timer) {
         http_line_next(conn, r, buf);
         return;
     }
-    if (sky_unlikely(i < 0 || buf->last >= buf->end)) {
+    if (sky_unlikely(i < 0)) {
         goto error;
     }
+    if (buf->last == buf->end) { // 未完整的请求位于读缓冲末尾
+        http_buf_rebuild(conn, r, buf);
+    }
     sky_tcp_set_cb(&conn->tcp, http_line_cb);
     http_line_cb(&conn->tcp);
     return;
@@ -303,10 +405,25 @@ http_server_request_next(sky_timer_wheel_entry_t *const timer) {
     http_conn_free(conn);
 }
 
+static sky_inline void
+http_conn_pool_put(sky_http_connection_t *const conn) {
+    sky_pool_t *const pool = conn->current_req->pool;
+
+    if (conn->buf_pool != pool) {
+        http_server_pool_put(conn->server, conn->buf_pool);
+    }
+    http_server_pool_put(conn->server, pool);
+    if (conn->out_buf) {
+        sky_free(conn->out_buf);
+        conn->out_buf = null;
+    }
+}
+
 static sky_inline void
 http_conn_free(sky_http_connection_t *const conn) {
     sky_timer_wheel_unlink(&conn->timer);
     sky_tcp_close(&conn->tcp);
-    sky_pool_destroy(conn->current_req->pool);
-    sky_free(conn);
+    http_conn_tls_destroy(conn);
+    http_conn_pool_put(conn);
+    sky_slab_free(&conn->server->conn_slab, conn);
 }
@@ -474,7 +474,7 @@ http_multipart_boundary_start(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -498,7 +498,7 @@ http_multipart_boundary_start(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -564,7 +564,7 @@ http_multipart_header_read(sky_tcp_t *const tcp) {
     sky_i8_t r;
 
     read_again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -586,7 +586,7 @@ http_multipart_header_read(sky_tcp_t *const tcp) {
     }
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -609,7 +609,7 @@ http_multipart_body_none(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -676,7 +676,7 @@ http_multipart_body_none(sky_tcp_t *const tcp) {
     }
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -701,7 +701,7 @@ http_multipart_body_str(sky_tcp_t *tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -788,7 +788,7 @@ http_multipart_body_str(sky_tcp_t *tcp) {
     }
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -812,7 +812,7 @@ http_multipart_body_str_none(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -877,7 +877,7 @@ http_multipart_body_str_none(sky_tcp_t *const tcp) {
     }
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -901,7 +901,7 @@ http_multipart_body_read(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(&conn->tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
 
@@ -977,7 +977,7 @@ http_multipart_body_read(sky_tcp_t *const tcp) {
     }
     if (sky_likely(!n)) {
         sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
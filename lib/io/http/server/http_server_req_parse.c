@@ -992,6 +992,12 @@ header_handle_run(sky_http_server_request_t *const req, sky_http_server_header_t
                 return sky_str_to_usize(&h->val, &req->headers_in.content_length_n);
             }
             return true;
+        case 15:
+            if (sky_str8_cmp(p, 'a', 'c', 'c', 'e', 'p', 't', '-', 'e')
+                && sky_str8_cmp(p + 7, 'e', 'n', 'c', 'o', 'd', 'i', 'n', 'g')) {
+                req->headers_in.accept_encoding = &h->val;
+            }
+            return true;
         case 17:
             switch (sky_str8_switch(p)) {
                 case sky_str8_num('i', 'f', '-', 'm', 'o', 'd', 'i', 'f'): {
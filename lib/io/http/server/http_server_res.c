@@ -5,9 +5,31 @@
 #include <io/http/http_server.h>
 #include <core/string_buf.h>
 #include <core/date.h>
+#include <core/memory.h>
 #include "http_server_common.h"
 
 
+#define HTTP_HEADER_TPL_N         16
+#define HTTP_HEADER_TPL_SIZE      224
+#define HTTP_HEADER_TPL_TYPE_MAX  64
+
+/**
+ * 响应头模板，缓存状态行至 Server 的固定部分，按状态码、版本、keep-alive、Content-Type 直接映射，
+ * 冲突时覆盖；Date 每秒原地更新一次
+ */
+struct http_header_tpl_s {
+    sky_time_t date_sec;
+    sky_u32_t status;
+    sky_u16_t len; // 0则为空
+    sky_u16_t date_offset;
+    sky_u8_t version_len;
+    sky_u8_t type_len;
+    sky_bool_t keep_alive;
+    sky_uchar_t version[8];
+    sky_uchar_t type[HTTP_HEADER_TPL_TYPE_MAX];
+    sky_uchar_t data[HTTP_HEADER_TPL_SIZE];
+};
+
 typedef struct {
     sky_u32_t ev_flag;
     void *cb_data;
@@ -33,16 +55,47 @@ typedef struct {
 
 static void http_header_write_pre(sky_http_server_request_t *r, sky_str_buf_t *buf);
 
+static sky_usize_t http_header_format(sky_http_server_request_t *r, sky_str_buf_t *buf);
+
+static http_header_tpl_t *http_header_tpl_get(const sky_http_server_request_t *r, sky_bool_t *save);
+
 static void http_header_write_ex(sky_http_server_request_t *r, sky_str_buf_t *buf);
 
 static void http_res_default_cb(sky_http_server_request_t *r, void *data);
 
+static sky_bool_t http_response_merge(
+        sky_http_server_request_t *r,
+        const sky_str_t *header,
+        const sky_uchar_t *data,
+        sky_usize_t data_len
+);
+
+static void http_response_start(sky_http_connection_t *conn, sky_timer_wheel_pt timeout, sky_tcp_cb_pt write);
+
+static void http_out_flush_cb(sky_tcp_t *tcp);
+
 static void http_response_file(sky_tcp_t *tcp);
 
 static void http_response_str(sky_tcp_t *tcp);
 
 static void http_response_vec(sky_tcp_t *tcp);
 
+static sky_bool_t http_response_file_gzip(
+        sky_http_server_request_t *r,
+        sky_u8_t encoding,
+        sky_socket_t fd,
+        sky_i64_t offset,
+        sky_usize_t size,
+        sky_http_server_next_pt call,
+        void *cb_data
+);
+
+static void http_response_gzip(sky_tcp_t *tcp);
+
+static void http_gzip_post_done(sky_event_loop_t *loop, void *data);
+
+static void http_gzip_stream_end(sky_http_connection_t *conn);
+
 static void http_response_none(sky_tcp_t *tcp);
 
 static void http_write_str_timeout(sky_timer_wheel_entry_t *timer);
@@ -51,6 +104,8 @@ static void http_write_vec_timeout(sky_timer_wheel_entry_t *timer);
 
 static void http_write_file_timeout(sky_timer_wheel_entry_t *timer);
 
+static void http_write_gzip_timeout(sky_timer_wheel_entry_t *timer);
+
 static void status_msg_get(sky_u32_t status, sky_str_t *out);
 
 
@@ -71,19 +126,22 @@ sky_http_response_nobody(
     packet->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
     packet->cb_data = cb_data;
 
-    sky_http_connection_t *const conn = r->conn;
-    conn->next_cb = call;
-    conn->cb_data = packet;
-
     sky_str_buf_t buf;
     sky_str_buf_init2(&buf, r->pool, 2048);
     http_header_write_pre(r, &buf);
     http_header_write_ex(r, &buf);
     sky_str_buf_build(&buf, &packet->buf);
 
-    sky_timer_set_cb(&conn->timer, http_write_str_timeout);
-    sky_tcp_set_cb(&conn->tcp, http_response_str);
-    http_response_str(&conn->tcp);
+    sky_http_connection_t *const conn = r->conn;
+    conn->res_size = packet->buf.len;
+    if (http_response_merge(r, &packet->buf, null, 0)) {
+        call(r, cb_data);
+        return;
+    }
+    conn->next_cb = call;
+    conn->cb_data = packet;
+
+    http_response_start(conn, http_write_str_timeout, http_response_str);
 }
 
 sky_api void
@@ -117,6 +175,24 @@ sky_http_response_str_len(
     }
     r->response = true;
 
+    if (data_len && r->conn->server->gzip) {
+        const sky_u8_t encoding = http_gzip_negotiate(r, data_len, false);
+        if (encoding != HTTP_GZIP_NONE) {
+            http_gzip_str(r, encoding, data, data_len, call, cb_data);
+            return;
+        }
+    }
+    http_response_str_body(r, data, data_len, call, cb_data);
+}
+
+void
+http_response_str_body(
+        sky_http_server_request_t *const r,
+        const sky_uchar_t *const data,
+        const sky_usize_t data_len,
+        const sky_http_server_next_pt call,
+        void *const cb_data
+) {
     if (!data_len) {
         http_str_packet_t *const packet = sky_palloc(r->pool, sizeof(http_str_packet_t));
         packet->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
@@ -130,25 +206,19 @@ sky_http_response_str_len(
         sky_str_buf_build(&buf, &packet->buf);
 
         sky_http_connection_t *const conn = r->conn;
+        conn->res_size = packet->buf.len;
+        if (http_response_merge(r, &packet->buf, null, 0)) {
+            call(r, cb_data);
+            return;
+        }
         conn->next_cb = call;
         conn->cb_data = packet;
 
-        sky_timer_set_cb(&conn->timer, http_write_str_timeout);
-        sky_tcp_set_cb(&conn->tcp, http_response_str);
-        http_response_str(&conn->tcp);
+        http_response_start(conn, http_write_str_timeout, http_response_str);
 
         return;
     }
 
-    http_vec_packet_t *const packet = sky_palloc(
-            r->pool,
-            sizeof(http_vec_packet_t) + (sizeof(sky_io_vec_t) << 1)
-    );
-    packet->read = 0;
-    packet->num = 2;
-    packet->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
-    packet->cb_data = cb_data;
-
     sky_str_buf_t buf;
     sky_str_buf_init2(&buf, r->pool, SKY_USIZE(2048));
     http_header_write_pre(r, &buf);
@@ -159,20 +229,83 @@ sky_http_response_str_len(
 
     sky_str_t result;
     sky_str_buf_build(&buf, &result);
+
+    sky_http_connection_t *const conn = r->conn;
+    conn->res_size = result.len + data_len;
+    if (http_response_merge(r, &result, data, data_len)) {
+        call(r, cb_data);
+        return;
+    }
+
+    http_vec_packet_t *const packet = sky_palloc(
+            r->pool,
+            sizeof(http_vec_packet_t) + (sizeof(sky_io_vec_t) << 1)
+    );
+    packet->read = 0;
+    packet->num = 2;
+    packet->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
+    packet->cb_data = cb_data;
     packet->vec[0].buf = result.data;
     packet->vec[0].size = result.len;
     packet->vec[1].buf = (sky_uchar_t *) data;
     packet->vec[1].size = data_len;
 
+    conn->next_cb = call;
+    conn->cb_data = packet;
+
+    http_response_start(conn, http_write_vec_timeout, http_response_vec);
+}
+
+sky_api void
+sky_http_response_raw(
+        sky_http_server_request_t *const r,
+        const sky_uchar_t *const data,
+        const sky_usize_t data_len,
+        sky_http_server_next_pt call,
+        void *const cb_data
+) {
+    call = call ?: http_res_default_cb;
+
+    if (sky_unlikely(r->response)) {
+        call(r, cb_data);
+        return;
+    }
+    r->response = true;
+
     sky_http_connection_t *const conn = r->conn;
+    conn->res_size = data_len;
+
+    http_str_packet_t *const packet = sky_palloc(r->pool, sizeof(http_str_packet_t));
+    packet->buf.data = (sky_uchar_t *) data;
+    packet->buf.len = data_len;
+    if (http_response_merge(r, &packet->buf, null, 0)) {
+        call(r, cb_data);
+        return;
+    }
+    packet->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
+    packet->cb_data = cb_data;
+
     conn->next_cb = call;
     conn->cb_data = packet;
 
-    sky_timer_set_cb(&conn->timer, http_write_vec_timeout);
-    sky_tcp_set_cb(&conn->tcp, http_response_vec);
-    http_response_vec(&conn->tcp);
+    http_response_start(conn, http_write_str_timeout, http_response_str);
 }
 
+sky_api const sky_uchar_t *
+sky_http_response_date(sky_http_server_request_t *const r, sky_time_t *const sec) {
+    sky_http_server_t *const server = r->conn->server;
+    const sky_time_t now = sky_event_now(server->ev_loop);
+
+    if (now > server->rfc_last) {
+        sky_date_to_rfc_str(now, server->rfc_date);
+        server->rfc_last = now;
+    }
+    if (sec) {
+        *sec = server->rfc_last;
+    }
+
+    return server->rfc_date;
+}
 
 sky_api void
 sky_http_response_file(
@@ -192,6 +325,13 @@ sky_http_response_file(
     }
     r->response = true;
 
+    if (size && r->conn->server->gzip) {
+        const sky_u8_t encoding = http_gzip_negotiate(r, size, true);
+        if (encoding != HTTP_GZIP_NONE && http_response_file_gzip(r, encoding, fd, offset, size, call, cb_data)) {
+            return;
+        }
+    }
+
     sky_str_buf_t buf;
     sky_str_buf_init2(&buf, r->pool, 2048);
 
@@ -221,12 +361,15 @@ sky_http_response_file(
         packet->buf = result;
 
         sky_http_connection_t *const conn = r->conn;
+        conn->res_size = result.len;
+        if (http_response_merge(r, &result, null, 0)) {
+            call(r, cb_data);
+            return;
+        }
         conn->next_cb = call;
         conn->cb_data = packet;
 
-        sky_timer_set_cb(&conn->timer, http_write_str_timeout);
-        sky_tcp_set_cb(&conn->tcp, http_response_str);
-        http_response_str(&conn->tcp);
+        http_response_start(conn, http_write_str_timeout, http_response_str);
         return;
     }
 
@@ -242,15 +385,122 @@ sky_http_response_file(
     sky_http_connection_t *const conn = r->conn;
     conn->next_cb = call;
     conn->cb_data = packet;
+    conn->res_size = result.len + size;
 
-    sky_timer_set_cb(&conn->timer, http_write_file_timeout);
-    sky_tcp_set_cb(&conn->tcp, http_response_file);
-    http_response_file(&conn->tcp);
+    http_response_start(conn, http_write_file_timeout, http_response_file);
 }
 
+/**
+ * 文件内容边读边压缩，以 chunked 输出
+ * @return 压缩初始化失败返回false，由调用方按原内容输出
+ */
+static sky_bool_t
+http_response_file_gzip(
+        sky_http_server_request_t *const r,
+        const sky_u8_t encoding,
+        const sky_socket_t fd,
+        const sky_i64_t offset,
+        const sky_usize_t size,
+        const sky_http_server_next_pt call,
+        void *const cb_data
+) {
+    http_gzip_stream_t *const stream = http_gzip_stream_create(r, encoding, fd, offset, size);
+    if (sky_unlikely(!stream)) {
+        return false;
+    }
+    stream->ev_flag = r->keep_alive ? (SKY_EV_READ | SKY_EV_WRITE) : SKY_EV_WRITE;
+    stream->cb_data = cb_data;
+
+    sky_str_buf_t buf;
+    sky_str_buf_init2(&buf, r->pool, 2048);
+    http_header_write_pre(r, &buf);
+    sky_str_buf_append_str_len(&buf, sky_str_line("Transfer-Encoding: chunked\r\n"));
+    http_header_write_ex(r, &buf);
+    sky_str_buf_build(&buf, &stream->out);
+
+    sky_http_connection_t *const conn = r->conn;
+    conn->next_cb = call;
+    conn->cb_data = stream;
+    conn->res_size = 0; // 写出时累加
+
+    http_response_start(conn, http_write_gzip_timeout, http_response_gzip);
+
+    return true;
+}
+
+sky_i8_t
+http_conn_out_flush(sky_http_connection_t *const conn, const sky_tcp_cb_pt next) {
+    sky_isize_t n;
+
+    for (;;) {
+        n = http_conn_write(conn, conn->out_buf, conn->out_len);
+        if (n > 0) {
+            conn->out_len -= (sky_u32_t) n;
+            if (!conn->out_len) {
+                return 1;
+            }
+            sky_memmove(conn->out_buf, conn->out_buf + n, conn->out_len);
+            continue;
+        }
+        if (sky_likely(!n)) {
+            conn->out_next = next;
+            sky_tcp_set_cb(&conn->tcp, http_out_flush_cb);
+            sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+            sky_tcp_try_register(&conn->tcp, SKY_EV_READ | SKY_EV_WRITE);
+            return 0;
+        }
+        conn->out_len = 0;
+        sky_tcp_close(&conn->tcp);
+        return -1;
+    }
+}
+
+
+http_header_tpl_t *
+http_header_tpl_create(sky_pool_t *const pool) {
+    return sky_pcalloc(pool, sizeof(http_header_tpl_t) * HTTP_HEADER_TPL_N);
+}
 
 static void
 http_header_write_pre(sky_http_server_request_t *const r, sky_str_buf_t *const buf) {
+    sky_http_server_t *const server = r->conn->server;
+    sky_http_response_date(r, null);
+
+    sky_bool_t save;
+    http_header_tpl_t *const tpl = http_header_tpl_get(r, &save);
+    if (!save) {
+        if (tpl->date_sec != server->rfc_last) {
+            sky_memcpy(tpl->data + tpl->date_offset, server->rfc_date, 29);
+            tpl->date_sec = server->rfc_last;
+        }
+        sky_str_buf_append_str_len(buf, tpl->data, tpl->len);
+        return;
+    }
+    const sky_usize_t date_offset = http_header_format(r, buf);
+    if (!tpl || sky_str_buf_fail(buf) || sky_str_buf_size(buf) > HTTP_HEADER_TPL_SIZE) {
+        return;
+    }
+    const sky_str_t *const version = &r->version_name;
+    const sky_str_t *const type = &r->headers_out.content_type;
+
+    tpl->date_sec = server->rfc_last;
+    tpl->status = r->state;
+    tpl->len = (sky_u16_t) sky_str_buf_size(buf);
+    tpl->date_offset = (sky_u16_t) date_offset;
+    tpl->version_len = (sky_u8_t) version->len;
+    tpl->type_len = (sky_u8_t) type->len;
+    tpl->keep_alive = r->keep_alive;
+    sky_memcpy(tpl->version, version->data, version->len);
+    sky_memcpy(tpl->type, type->data, type->len);
+    sky_memcpy(tpl->data, buf->start, tpl->len);
+}
+
+/**
+ * 格式化状态行至 Server 的固定响应头
+ * @return Date 值的偏移
+ */
+static sky_usize_t
+http_header_format(sky_http_server_request_t *const r, sky_str_buf_t *const buf) {
     sky_str_buf_append_str(buf, &r->version_name);
     sky_str_buf_append_uchar(buf, ' ');
 
@@ -266,14 +516,7 @@ http_header_write_pre(sky_http_server_request_t *const r, sky_str_buf_t *const b
         sky_str_buf_append_str_len(buf, sky_str_line("\r\nConnection: close\r\n"));
     }
     sky_str_buf_append_str_len(buf, sky_str_line("Date: "));
-
-    const sky_i64_t now = sky_event_now(r->conn->server->ev_loop);
-
-    if (now > r->conn->server->rfc_last) {
-        sky_date_to_rfc_str(now, r->conn->server->rfc_date);
-        r->conn->server->rfc_last = now;
-    }
-
+    const sky_usize_t date_offset = sky_str_buf_size(buf);
     sky_str_buf_append_str_len(buf, r->conn->server->rfc_date, 29);
 
     if (r->headers_out.content_type.len) {
@@ -283,6 +526,44 @@ http_header_write_pre(sky_http_server_request_t *const r, sky_str_buf_t *const b
     } else {
         sky_str_buf_append_str_len(buf, sky_str_line("\r\nContent-Type: text/plain\r\n"));
     }
+    sky_str_buf_append_str_len(buf, sky_str_line("Server: sky\r\n"));
+
+    return date_offset;
+}
+
+/**
+ * 查找响应头模板
+ * @param r    请求
+ * @param save 未命中时为true，返回的模板(可能为null)需由调用方写入
+ * @return 模板，不可缓存时为null
+ */
+static http_header_tpl_t *
+http_header_tpl_get(const sky_http_server_request_t *const r, sky_bool_t *const save) {
+    const sky_str_t *const version = &r->version_name;
+    const sky_str_t *const type = &r->headers_out.content_type;
+
+    *save = true;
+    if (sky_unlikely(version->len > sizeof(((http_header_tpl_t *) 0)->version)
+                     || type->len > HTTP_HEADER_TPL_TYPE_MAX)) {
+        return null;
+    }
+    sky_u32_t index = r->state * 31 + (sky_u32_t) type->len * 7 + r->keep_alive;
+    if (type->len) {
+        index += type->data[type->len >> 1];
+    }
+    http_header_tpl_t *const tpl = r->conn->server->header_tpl + (index & (HTTP_HEADER_TPL_N - 1));
+
+    if (tpl->len
+        && tpl->status == r->state
+        && tpl->keep_alive == r->keep_alive
+        && tpl->type_len == type->len
+        && tpl->version_len == version->len
+        && sky_str_len_unsafe_equals(tpl->type, type->data, type->len)
+        && sky_str_len_unsafe_equals(tpl->version, version->data, version->len)) {
+        *save = false;
+    }
+
+    return tpl;
 }
 
 static void
@@ -294,7 +575,7 @@ http_header_write_ex(sky_http_server_request_t *r, sky_str_buf_t *buf) {
         sky_str_buf_append_two_uchar(buf, '\r', '\n');
     });
 
-    sky_str_buf_append_str_len(buf, sky_str_line("Server: sky\r\n\r\n"));
+    sky_str_buf_append_two_uchar(buf, '\r', '\n');
 }
 
 
@@ -305,6 +586,66 @@ http_res_default_cb(sky_http_server_request_t *const r, void *const data) {
     sky_http_server_req_finish(r);
 }
 
+/**
+ * 读缓冲中已有后续流水线请求时，小响应拷贝到连接的合并缓冲后立即完成，与后续响应一起写出
+ */
+static sky_bool_t
+http_response_merge(
+        sky_http_server_request_t *const r,
+        const sky_str_t *const header,
+        const sky_uchar_t *const data,
+        const sky_usize_t data_len
+) {
+    sky_http_connection_t *const conn = r->conn;
+
+    if (!r->keep_alive || !r->read_request_body || (conn->buf->pos == conn->buf->last && !conn->out_len)) {
+        return false;
+    }
+    const sky_usize_t size = header->len + data_len;
+    if (size > (HTTP_SERVER_OUT_BUF_SIZE - conn->out_len)) {
+        return false;
+    }
+    if (!conn->out_buf) {
+        conn->out_buf = sky_malloc(HTTP_SERVER_OUT_BUF_SIZE);
+        if (sky_unlikely(!conn->out_buf)) {
+            return false;
+        }
+    }
+    sky_uchar_t *const p = conn->out_buf + conn->out_len;
+    sky_memcpy(p, header->data, header->len);
+    if (data_len) {
+        sky_memcpy(p + header->len, data, data_len);
+    }
+    conn->out_len += (sky_u32_t) size;
+    sky_tcp_set_cb(&conn->tcp, http_response_none);
+
+    return true;
+}
+
+/**
+ * 开始写响应，存在合并的响应时先写出，保证响应顺序
+ */
+static void
+http_response_start(sky_http_connection_t *const conn, const sky_timer_wheel_pt timeout, const sky_tcp_cb_pt write) {
+    sky_timer_set_cb(&conn->timer, timeout);
+    sky_tcp_set_cb(&conn->tcp, write);
+    if (conn->out_len && !http_conn_out_flush(conn, write)) {
+        return;
+    }
+    write(&conn->tcp);
+}
+
+static void
+http_out_flush_cb(sky_tcp_t *const tcp) {
+    sky_http_connection_t *const conn = sky_type_convert(tcp, sky_http_connection_t, tcp);
+
+    if (http_conn_out_flush(conn, conn->out_next)) {
+        sky_timer_wheel_unlink(&conn->timer);
+        sky_tcp_set_cb(tcp, conn->out_next);
+        conn->out_next(tcp);
+    }
+}
+
 
 static void
 http_response_str(sky_tcp_t *const tcp) {
@@ -314,7 +655,7 @@ http_response_str(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_write(tcp, buf->data, buf->len);
+    n = http_conn_write(conn, buf->data, buf->len);
     if (n > 0) {
         buf->data += n;
         buf->len -= (sky_usize_t) n;
@@ -327,7 +668,7 @@ http_response_str(sky_tcp_t *const tcp) {
         goto again;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         sky_tcp_try_register(tcp, packet->ev_flag);
         return;
     }
@@ -347,7 +688,7 @@ http_response_vec(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_write_vec(tcp, vec, num);
+    n = http_conn_write_vec(conn, vec, num);
     if (n > 0) {
         next_vec:
         if ((sky_usize_t) n < vec->size) {
@@ -368,7 +709,7 @@ http_response_vec(sky_tcp_t *const tcp) {
         goto next_vec;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         sky_tcp_try_register(tcp, packet->ev_flag);
         return;
     }
@@ -388,7 +729,7 @@ http_response_file(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_sendfile(tcp, &packet->fs, &packet->offset, packet->size, buf->data, buf->len);
+    n = http_conn_sendfile(conn, &packet->fs, &packet->offset, packet->size, buf->data, buf->len);
     if (n > 0) {
         if (buf->len) {
             if ((sky_usize_t) n < buf->len) {
@@ -412,7 +753,7 @@ http_response_file(sky_tcp_t *const tcp) {
         goto again;
     }
     if (sky_likely(!n)) {
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         sky_tcp_try_register(tcp, packet->ev_flag);
     } else {
         sky_timer_wheel_unlink(&conn->timer);
@@ -421,6 +762,75 @@ http_response_file(sky_tcp_t *const tcp) {
     }
 }
 
+static void
+http_response_gzip(sky_tcp_t *const tcp) {
+    sky_http_connection_t *const conn = sky_type_convert(tcp, sky_http_connection_t, tcp);
+    http_gzip_stream_t *const stream = conn->cb_data;
+    sky_str_t *const buf = &stream->out;
+    sky_isize_t n;
+
+    for (;;) {
+        if (buf->len) {
+            n = http_conn_write(conn, buf->data, buf->len);
+            if (n > 0) {
+                buf->data += n;
+                buf->len -= (sky_usize_t) n;
+                conn->res_size += (sky_usize_t) n;
+                continue;
+            }
+            if (sky_likely(!n)) {
+                sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+                sky_tcp_try_register(tcp, stream->ev_flag);
+                return;
+            }
+            break;
+        }
+        if (stream->end) {
+            sky_tcp_set_cb(tcp, http_response_none);
+            sky_timer_wheel_unlink(&conn->timer);
+            http_gzip_stream_end(conn);
+            return;
+        }
+        if (stream->offload && http_gzip_stream_post(stream, conn, http_gzip_post_done)) {
+            sky_tcp_set_cb(tcp, http_response_none);
+            sky_timer_wheel_unlink(&conn->timer);
+            return;
+        }
+        if (sky_unlikely(!http_gzip_stream_fill(stream))) {
+            break;
+        }
+    }
+
+    sky_timer_wheel_unlink(&conn->timer);
+    sky_tcp_close(tcp);
+    http_gzip_stream_end(conn);
+}
+
+static void
+http_gzip_post_done(sky_event_loop_t *const loop, void *const data) {
+    (void) loop;
+
+    sky_http_connection_t *const conn = data;
+    http_gzip_stream_t *const stream = conn->cb_data;
+
+    if (sky_unlikely(stream->error)) {
+        sky_tcp_close(&conn->tcp);
+        http_gzip_stream_end(conn);
+        return;
+    }
+    sky_tcp_set_cb(&conn->tcp, http_response_gzip);
+    http_response_gzip(&conn->tcp);
+}
+
+static void
+http_gzip_stream_end(sky_http_connection_t *const conn) {
+    http_gzip_stream_t *const stream = conn->cb_data;
+    void *const cb_data = stream->cb_data;
+
+    http_gzip_stream_destroy(stream);
+    conn->next_cb(conn->current_req, cb_data);
+}
+
 static void
 http_response_none(sky_tcp_t *const tcp) {
     if (sky_unlikely(sky_ev_error(sky_tcp_ev(tcp)))) {
@@ -455,6 +865,14 @@ http_write_file_timeout(sky_timer_wheel_entry_t *const timer) {
     conn->next_cb(conn->current_req, packet->cb_data);
 }
 
+static sky_inline void
+http_write_gzip_timeout(sky_timer_wheel_entry_t *const timer) {
+    sky_http_connection_t *const conn = sky_type_convert(timer, sky_http_connection_t, timer);
+    sky_tcp_close(&conn->tcp);
+
+    http_gzip_stream_end(conn);
+}
+
 static void
 status_msg_get(const sky_u32_t status, sky_str_t *const out) {
     switch (status) {
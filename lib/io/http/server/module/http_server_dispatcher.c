@@ -4,12 +4,38 @@
 #include <io/http/http_server_dispatcher.h>
 #include <core/memory.h>
 #include <core/trie.h>
+#include <core/array.h>
+#include <core/log.h>
 
+#define HTTP_HANDLER_NUM 7
+
+typedef struct route_node_s route_node_t;
+
+typedef struct {
+    sky_http_mapper_pt handlers[HTTP_HANDLER_NUM];
+    sky_str_t *names;
+    sky_u8_t name_n;
+    sky_u8_t methods; // 已注册方法的位图，与 r->method 对应
+} http_route_t;
+
+typedef struct {
+    sky_str_t segment;
+    route_node_t *node;
+} route_static_t;
+
+struct route_node_s {
+    sky_array_t statics;
+    route_node_t *param_int;
+    route_node_t *param;
+    route_node_t *wildcard;
+    http_route_t *route;
+};
 
 typedef struct {
     sky_str_t *prefix;
     sky_pool_t *pool;
-    sky_trie_t *mappers;
+    sky_trie_t *mappers; // 静态路径精确匹配
+    route_node_t *param_root; // 含参数的路径
 
     sky_bool_t (*pre_run)(sky_http_server_request_t *req, void *data);
 
@@ -22,6 +48,25 @@ static void http_run_handler(sky_http_server_request_t *r, void *data);
 
 static void http_run_handler_next(sky_http_server_request_t *r, const http_module_dispatcher_t *dispatcher);
 
+static http_route_t *route_create(sky_pool_t *pool, const sky_http_mapper_t *mapper);
+
+static sky_bool_t route_param_put(http_module_dispatcher_t *dispatcher, sky_str_t *path, http_route_t *route);
+
+static route_node_t *route_node_create(sky_pool_t *pool);
+
+static const http_route_t *route_match(
+        const route_node_t *node,
+        const sky_uchar_t *p,
+        const sky_uchar_t *end,
+        sky_bool_t has_seg,
+        sky_str_t *values,
+        sky_u32_t n
+);
+
+static sky_bool_t path_is_param(const sky_str_t *path);
+
+static sky_u32_t method_slot(sky_u32_t method);
+
 
 sky_api sky_http_server_module_t *
 sky_http_server_dispatcher_create(const sky_http_server_dispatcher_conf_t *const conf) {
@@ -49,12 +94,12 @@ sky_http_server_dispatcher_create(const sky_http_server_dispatcher_conf_t *const
     data->prefix = &module->prefix;
     data->pool = pool;
     data->mappers = sky_trie_create(pool);
+    data->param_root = null;
     data->pre_run = conf->pre_run;
     data->run_data = conf->run_data;
 
     const sky_http_mapper_t *mapper = conf->mappers;
-    const sky_usize_t size = sizeof(sky_http_mapper_pt) << 2;
-    sky_http_mapper_pt *handlers;
+    http_route_t *route;
     sky_str_t path;
 
     for (sky_u32_t i = 0; i < conf->mapper_len; ++mapper, ++i) {
@@ -62,9 +107,14 @@ sky_http_server_dispatcher_create(const sky_http_server_dispatcher_conf_t *const
         path.len = mapper->path.len;
         sky_memcpy(path.data, mapper->path.data, mapper->path.len);
 
-        handlers = sky_palloc(pool, size);
-        sky_memcpy(handlers, &mapper->get, size);
-        sky_trie_put(data->mappers, &path, handlers);
+        route = route_create(pool, mapper);
+        if (!path_is_param(&path)) {
+            sky_trie_put(data->mappers, &path, route);
+            continue;
+        }
+        if (sky_unlikely(!route_param_put(data, &path, route))) {
+            sky_log_error("http mapper path error: %.*s", (int) path.len, path.data);
+        }
     }
 
     module->module_data = data;
@@ -100,10 +150,24 @@ http_run_handler(sky_http_server_request_t *const r, void *const data) {
 
 static void
 http_run_handler_next(sky_http_server_request_t *const r, const http_module_dispatcher_t *const dispatcher) {
-    const sky_http_mapper_pt *handler = sky_trie_contains(dispatcher->mappers, &r->uri);
+    const http_route_t *route = sky_trie_contains(dispatcher->mappers, &r->uri);
+    if (!route && dispatcher->param_root && r->uri.len && *r->uri.data == '/') {
+        route = route_match(
+                dispatcher->param_root,
+                r->uri.data + 1,
+                r->uri.data + r->uri.len,
+                true,
+                r->path_params,
+                0
+        );
+        if (route) {
+            r->path_param_names = route->names;
+            r->path_param_n = route->name_n;
+        }
+    }
 
     sky_str_set(&r->headers_out.content_type, "application/json");
-    if (!handler) {
+    if (!route) {
         r->state = 404;
         sky_http_response_str_len(
                 r,
@@ -114,30 +178,7 @@ http_run_handler_next(sky_http_server_request_t *const r, const http_module_disp
         return;
     }
 
-    switch (r->method) {
-        case SKY_HTTP_GET:
-            break;
-        case SKY_HTTP_POST:
-            ++handler;
-            break;
-        case SKY_HTTP_PUT:
-            handler += 2;
-            break;
-        case SKY_HTTP_DELETE:
-            handler += 3;
-            break;
-        default:
-            r->state = 405;
-            sky_http_response_str_len(
-                    r,
-                    sky_str_line("{\"errcode\": 405, \"errmsg\": \"405 Method Not Allowed\"}"),
-                    null,
-                    null
-            );
-            return;
-    }
-
-    if (!(*handler)) {
+    if (!(route->methods & r->method)) {
         r->state = 405;
         sky_http_response_str_len(
                 r,
@@ -145,8 +186,234 @@ http_run_handler_next(sky_http_server_request_t *const r, const http_module_disp
                 null,
                 null
         );
-    } else {
-        (*handler)(r);
+        return;
+    }
+    route->handlers[method_slot(r->method)](r);
+}
+
+static http_route_t *
+route_create(sky_pool_t *const pool, const sky_http_mapper_t *const mapper) {
+    static const sky_u8_t methods[HTTP_HANDLER_NUM] = {
+            SKY_HTTP_GET,
+            SKY_HTTP_POST,
+            SKY_HTTP_PUT,
+            SKY_HTTP_DELETE,
+            SKY_HTTP_PATCH,
+            SKY_HTTP_HEAD,
+            SKY_HTTP_OPTIONS
+    };
+
+    http_route_t *const route = sky_palloc(pool, sizeof(http_route_t));
+    sky_memcpy(route->handlers, &mapper->get, sizeof(sky_http_mapper_pt) * HTTP_HANDLER_NUM);
+    route->names = null;
+    route->name_n = 0;
+    route->methods = 0;
+
+    for (sky_u32_t i = 0; i < HTTP_HANDLER_NUM; ++i) {
+        if (route->handlers[i]) {
+            route->methods |= methods[i];
+        }
+    }
+
+    return route;
+}
+
+static sky_bool_t
+route_param_put(http_module_dispatcher_t *const dispatcher, sky_str_t *const path, http_route_t *const route) {
+    if (!path->len || *path->data != '/') {
+        return false;
+    }
+    if (!dispatcher->param_root) {
+        dispatcher->param_root = route_node_create(dispatcher->pool);
+    }
+    sky_str_t names[SKY_HTTP_PATH_PARAM_MAX];
+    route_node_t *node = dispatcher->param_root, **next;
+    sky_uchar_t *p = path->data + 1, *q;
+    sky_uchar_t *const end = path->data + path->len;
+    sky_str_t seg;
+    sky_u32_t name_n = 0;
+    sky_bool_t has_seg = true;
+
+    while (has_seg) {
+        q = p;
+        while (q != end && *q != '/') {
+            ++q;
+        }
+        seg.data = p;
+        seg.len = (sky_usize_t) (q - p);
+        has_seg = q != end;
+        p = q + 1;
+
+        if (seg.len == 1 && *seg.data == '*') {
+            if (has_seg || name_n == SKY_HTTP_PATH_PARAM_MAX) {
+                return false;
+            }
+            sky_str_set(names + name_n, "*");
+            ++name_n;
+            next = &node->wildcard;
+        } else if (seg.len > 2 && seg.data[0] == '{' && seg.data[seg.len - 1] == '}') {
+            if (name_n == SKY_HTTP_PATH_PARAM_MAX) {
+                return false;
+            }
+            sky_str_t *const name = names + name_n++;
+            name->data = seg.data + 1;
+            name->len = seg.len - 2;
+            next = &node->param;
+
+            for (sky_usize_t i = 0; i < name->len; ++i) {
+                if (name->data[i] != ':') {
+                    continue;
+                }
+                const sky_uchar_t *const type = name->data + i + 1;
+                const sky_usize_t type_len = name->len - i - 1;
+                name->len = i;
+
+                if (sky_str_len_equals(type, type_len, sky_str_line("int"))) {
+                    next = &node->param_int;
+                } else if (sky_str_len_equals(type, type_len, sky_str_line("*"))) {
+                    if (has_seg) {
+                        return false;
+                    }
+                    next = &node->wildcard;
+                } else {
+                    return false;
+                }
+                break;
+            }
+        } else {
+            route_static_t *item = null;
+            sky_array_foreach(&node->statics, route_static_t, tmp) {
+                if (sky_str_equals(&tmp->segment, &seg)) {
+                    item = tmp;
+                    break;
+                }
+            }
+            if (!item) {
+                item = sky_array_push(&node->statics);
+                item->segment = seg;
+                item->node = null;
+            }
+            next = &item->node;
+        }
+        if (!*next) {
+            *next = route_node_create(dispatcher->pool);
+        }
+        node = *next;
+    }
+    if (name_n) {
+        route->names = sky_palloc(dispatcher->pool, sizeof(sky_str_t) * name_n);
+        sky_memcpy(route->names, names, sizeof(sky_str_t) * name_n);
+        route->name_n = (sky_u8_t) name_n;
+    }
+    node->route = route;
+
+    return true;
+}
+
+static route_node_t *
+route_node_create(sky_pool_t *const pool) {
+    route_node_t *const node = sky_palloc(pool, sizeof(route_node_t));
+    sky_array_init2(&node->statics, pool, 4, sizeof(route_static_t));
+    node->param_int = null;
+    node->param = null;
+    node->wildcard = null;
+    node->route = null;
+
+    return node;
+}
+
+/**
+ * 逐段匹配，失败时回溯尝试下一优先级，参数值直接指向uri
+ */
+static const http_route_t *
+route_match(
+        const route_node_t *const node,
+        const sky_uchar_t *const p,
+        const sky_uchar_t *const end,
+        const sky_bool_t has_seg,
+        sky_str_t *const values,
+        const sky_u32_t n
+) {
+    if (!has_seg) {
+        return node->route;
+    }
+    const sky_uchar_t *q = p;
+    while (q != end && *q != '/') {
+        ++q;
+    }
+    const sky_usize_t seg_len = (sky_usize_t) (q - p);
+    const sky_bool_t next_has = q != end;
+    const http_route_t *route;
+
+    sky_array_foreach(&node->statics, route_static_t, item) {
+        if (sky_str_equals2(&item->segment, p, seg_len)) {
+            route = route_match(item->node, q + 1, end, next_has, values, n);
+            if (route) {
+                return route;
+            }
+            break;
+        }
+    }
+    if (seg_len) {
+        if (node->param_int) {
+            const sky_uchar_t *c = p;
+            while (c != q && *c >= '0' && *c <= '9') {
+                ++c;
+            }
+            if (c == q) {
+                values[n].data = (sky_uchar_t *) p;
+                values[n].len = seg_len;
+                route = route_match(node->param_int, q + 1, end, next_has, values, n + 1);
+                if (route) {
+                    return route;
+                }
+            }
+        }
+        if (node->param) {
+            values[n].data = (sky_uchar_t *) p;
+            values[n].len = seg_len;
+            route = route_match(node->param, q + 1, end, next_has, values, n + 1);
+            if (route) {
+                return route;
+            }
+        }
+    }
+    if (node->wildcard && node->wildcard->route) {
+        values[n].data = (sky_uchar_t *) p;
+        values[n].len = (sky_usize_t) (end - p);
+        return node->wildcard->route;
+    }
+
+    return null;
+}
+
+static sky_bool_t
+path_is_param(const sky_str_t *const path) {
+    for (sky_usize_t i = 0; i < path->len; ++i) {
+        if (path->data[i] == '{' || (path->data[i] == '*' && (!i || path->data[i - 1] == '/'))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static sky_inline sky_u32_t
+method_slot(const sky_u32_t method) {
+    switch (method) {
+        case SKY_HTTP_GET:
+            return 0;
+        case SKY_HTTP_POST:
+            return 1;
+        case SKY_HTTP_PUT:
+            return 2;
+        case SKY_HTTP_DELETE:
+            return 3;
+        case SKY_HTTP_PATCH:
+            return 4;
+        case SKY_HTTP_HEAD:
+            return 5;
+        default:
+            return 6;
     }
 }
 
@@ -5,12 +5,24 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <string.h>
 #include <io/http/http_server_file.h>
 #include <core/memory.h>
+#include <core/string_buf.h>
 #include <core/number.h>
 #include <core/date.h>
-#include <core/rbtree.h>
+#include <core/hashmap.h>
 #include <core/crc32.h>
+#include <core/log.h>
+
+#ifdef SKY_HAVE_INOTIFY
+
+#include <sys/inotify.h>
+
+#define FILE_WATCH_MASK (IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+    | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+#endif
 
 #define http_error_page(_r, _status, _msg)                              \
     (_r)->state = _status;                                              \
@@ -41,9 +53,13 @@ typedef struct {
 } http_mime_type_t;
 
 typedef struct {
-    sky_rb_tree_t cache_tree;
+    sky_hashmap_t cache_map;
+    sky_hashmap_t mem_map;
+    sky_hashmap_t watch_map;
     sky_queue_t cache_queue;
+    sky_queue_t mem_queue; // 由旧到新，淘汰时从头部开始
     sky_timer_wheel_entry_t timer;
+    sky_ev_t watch_ev; // inotify
     http_mime_type_t default_mime_type;
     sky_str_t path;
     sky_str_t *prefix;
@@ -53,23 +69,78 @@ typedef struct {
     sky_bool_t (*pre_run)(sky_http_server_request_t *req, void *data);
 
     void *run_data;
+    sky_usize_t mem_size;
+    sky_usize_t mem_max;
+    sky_u32_t mem_file_max;
     sky_u32_t cache_sec;
+    sky_bool_t precompressed;
+    sky_bool_t watch;
 } http_module_file_t;
 
+#define FILE_VARIANT_BR 0
+#define FILE_VARIANT_GZ 1
+#define FILE_VARIANT_N  2
+
+/**
+ * 预压缩文件，不存在或比原文件旧时 fd 为-1
+ */
+typedef struct {
+    sky_i64_t modified_time;
+    sky_i64_t file_size;
+    sky_i32_t fd;
+} file_cache_variant_t;
+
+/**
+ * 被监听的目录，不再有缓存节点时移除
+ */
+typedef struct {
+    sky_queue_t nodes;
+    sky_i32_t wd;
+} file_watch_t;
 
 typedef struct {
-    sky_rb_node_t node;
     sky_queue_t link;
+    sky_queue_t watch_link;
     sky_str_t path;
     sky_i64_t modified_time;
     sky_i64_t file_size;
-    sky_i64_t expire_at;
+    sky_u64_t expire_at;
     http_module_file_t *module_file;
+    file_watch_t *watch; // 未监听时为null
     sky_u32_t path_hash;
+    sky_u32_t name_offset; // 文件名在 path 中的偏移
     sky_u32_t ref_count;
     sky_i32_t fd;
+    sky_bool_t stale; // 已失效但仍在使用，释放引用时删除
+    sky_bool_t has_variant;
+    file_cache_variant_t variants[FILE_VARIANT_N];
 } file_cache_node_t;
 
+#define FILE_MEM_FILE_MAX SKY_U32(16384)
+
+/**
+ * 预先编码的完整响应，发送中被替换或淘汰时延迟至引用释放后删除
+ */
+typedef struct {
+    sky_time_t date_sec;
+    sky_u32_t ref_count;
+    sky_u32_t size;
+    sky_u32_t date_offset;
+    sky_bool_t detached;
+    sky_uchar_t data[];
+} file_mem_buf_t;
+
+typedef struct {
+    sky_queue_t link;
+    sky_str_t path;
+    sky_i64_t modified_time;
+    sky_i64_t file_size;
+    const sky_uchar_t *type;
+    file_mem_buf_t *buf;
+    sky_usize_t cost;
+    sky_u32_t path_hash;
+} file_mem_t;
+
 static void http_run_handler(sky_http_server_request_t *r, void *data);
 
 static void http_response_next(sky_http_server_request_t *r, void *data);
@@ -77,20 +148,68 @@ static void http_response_next(sky_http_server_request_t *r, void *data);
 static file_cache_node_t *cache_node_file_get_ref(
         http_module_file_t *module_file,
         sky_pool_t *pool,
-        const sky_str_t *uri_path
+        const sky_str_t *uri_path,
+        sky_bool_t variant
+);
+
+static void cache_variant_open(file_cache_node_t *node, sky_char_t *path, sky_usize_t path_len);
+
+static const file_cache_variant_t *cache_variant_get(
+        sky_http_server_request_t *r,
+        const file_cache_node_t *node
 );
 
 static void cache_node_file_unref(file_cache_node_t *node);
 
+static void cache_node_close(file_cache_node_t *node);
+
+static void cache_node_invalidate(http_module_file_t *module_file, file_cache_node_t *node);
+
 static void cache_node_free_timer(sky_timer_wheel_entry_t *timer);
 
-static file_cache_node_t *rb_tree_get(
-        sky_rb_tree_t *tree,
-        const sky_str_t *path,
-        sky_u32_t path_hash
+static sky_bool_t cache_node_equals(const void *item, const void *key);
+
+static sky_bool_t file_mem_response(
+        http_module_file_t *module_file,
+        sky_http_server_request_t *r,
+        file_cache_node_t *node
 );
 
-static void rb_tree_insert(sky_rb_tree_t *tree, file_cache_node_t *node);
+static file_mem_t *file_mem_create(
+        http_module_file_t *module_file,
+        sky_http_server_request_t *r,
+        const file_cache_node_t *node,
+        const sky_str_t *last_modified
+);
+
+static void file_mem_remove(http_module_file_t *module_file, file_mem_t *mem);
+
+static void file_mem_next(sky_http_server_request_t *r, void *data);
+
+static sky_bool_t file_mem_equals(const void *item, const void *key);
+
+static sky_bool_t file_watch_init(http_module_file_t *module_file);
+
+static void file_watch_add(file_cache_node_t *node, sky_char_t *path, sky_usize_t dir_len);
+
+static void file_watch_unlink(file_cache_node_t *node);
+
+static sky_bool_t file_watch_equals(const void *item, const void *key);
+
+#ifdef SKY_HAVE_INOTIFY
+
+static void file_watch_clean(http_module_file_t *module_file, file_watch_t *watch);
+
+static void file_watch_cb(sky_ev_t *ev);
+
+static void file_watch_name_changed(
+        http_module_file_t *module_file,
+        file_watch_t *watch,
+        const sky_uchar_t *name,
+        sky_usize_t name_len
+);
+
+#endif
 
 static sky_bool_t http_mime_type_get(const sky_str_t *exten, http_mime_type_t *type);
 
@@ -118,8 +237,11 @@ sky_http_server_file_create(sky_event_loop_t *const ev_loop, const sky_http_serv
     module->run = http_run_handler;
 
     http_module_file_t *const data = sky_palloc(pool, sizeof(http_module_file_t));
-    sky_rb_tree_init(&data->cache_tree);
+    sky_hashmap_init(&data->cache_map, cache_node_equals);
+    sky_hashmap_init(&data->mem_map, file_mem_equals);
+    sky_hashmap_init(&data->watch_map, file_watch_equals);
     sky_queue_init(&data->cache_queue);
+    sky_queue_init(&data->mem_queue);
     sky_event_timeout_init(ev_loop, &data->timer, cache_node_free_timer);
     sky_str_set(&data->default_mime_type.val, "application/octet-stream");
     data->default_mime_type.binary = true;
@@ -131,7 +253,12 @@ sky_http_server_file_create(sky_event_loop_t *const ev_loop, const sky_http_serv
     data->ev_loop = ev_loop;
     data->pre_run = conf->pre_run;
     data->run_data = conf->run_data;
+    data->mem_size = 0;
+    data->mem_max = conf->mem_cache_size;
+    data->mem_file_max = conf->mem_file_max ?: FILE_MEM_FILE_MAX;
     data->cache_sec = conf->cache_sec ?: 5;
+    data->precompressed = conf->precompressed;
+    data->watch = conf->watch && file_watch_init(data);
 
     module->module_data = data;
 
@@ -143,21 +270,32 @@ sky_http_server_file_destroy(sky_http_server_module_t *const server_file) {
     http_module_file_t *const data = server_file->module_data;
     sky_timer_wheel_unlink(&data->timer);
 
-    sky_rb_node_t *item;
     file_cache_node_t *node;
-    for (;;) {
-        item = sky_rb_tree_first(&data->cache_tree);
-        if (!item) {
-            break;
-        }
-        sky_rb_tree_del(&data->cache_tree, item);
-
-        node = sky_type_convert(item, file_cache_node_t, node);
-        if (node->fd != -1) {
-            close(node->fd);
-        }
+    sky_usize_t iter = 0;
+    while ((node = sky_hashmap_next(&data->cache_map, &iter))) {
+        cache_node_close(node);
         sky_free(node);
     }
+    sky_hashmap_destroy(&data->cache_map);
+
+    file_watch_t *watch;
+    iter = 0;
+    while ((watch = sky_hashmap_next(&data->watch_map, &iter))) {
+        sky_free(watch);
+    }
+    sky_hashmap_destroy(&data->watch_map);
+    if (data->watch) {
+        sky_selector_cancel(&data->watch_ev);
+        close(sky_ev_get_fd(&data->watch_ev));
+    }
+
+    file_mem_t *mem;
+    iter = 0;
+    while ((mem = sky_hashmap_next(&data->mem_map, &iter))) {
+        sky_free(mem->buf);
+        sky_free(mem);
+    }
+    sky_hashmap_destroy(&data->mem_map);
     sky_pool_destroy(data->pool);
 }
 
@@ -216,15 +354,41 @@ http_run_handler(sky_http_server_request_t *const r, void *const data) {
         }
     }
 
-    file_cache_node_t *const node = cache_node_file_get_ref(module_file, r->pool, &r->uri);
+    file_cache_node_t *const node = cache_node_file_get_ref(
+            module_file,
+            r->pool,
+            &r->uri,
+            module_file->precompressed && !mime_type.binary
+    );
+    if (sky_unlikely(!node)) {
+        http_error_page(r, 500, "500 Internal Server Error");
+        return;
+    }
     if (node->fd == -1) {
+        cache_node_file_unref(node); // 不存在的文件同样进入过期队列，短时间内重复请求不再打开
         http_error_page(r, 404, "404 Not Found");
         return;
     }
 
+    // 内存缓存的响应头为预先编码，仅用于未附加其他响应头的 HTTP/1.1 keep-alive 请求
+    const sky_bool_t mem_able = module_file->mem_max
+                                && !node->has_variant
+                                && !file->range
+                                && !r->state
+                                && r->keep_alive
+                                && !r->headers_out.headers.part.nelts
+                                && r->version_name.len == 8
+                                && r->version_name.data[7] == '1'
+                                && node->file_size <= module_file->mem_file_max;
+
     r->headers_out.content_type = mime_type.val;
     sky_http_server_header_t *const header = sky_list_push(&r->headers_out.headers);
     sky_str_set(&header->key, "Last-Modified");
+    if (node->has_variant) {
+        sky_http_server_header_t *const vary = sky_list_push(&r->headers_out.headers);
+        sky_str_set(&vary->key, "Vary");
+        sky_str_set(&vary->val, "Accept-Encoding");
+    }
 
     if (file->modified && file->modified_time == node->modified_time) {
         header->val = *r->headers_in.if_modified_since;
@@ -233,9 +397,28 @@ http_run_handler(sky_http_server_request_t *const r, void *const data) {
         sky_http_response_nobody(r, null, null);
         return;
     }
+    if (mem_able && file_mem_response(module_file, r, node)) {
+        return;
+    }
     header->val.data = sky_palloc(r->pool, 30);
     header->val.len = sky_date_to_rfc_str(node->modified_time, header->val.data);
 
+    if (node->has_variant && !file->range) {
+        const file_cache_variant_t *const variant = cache_variant_get(r, node);
+        if (variant) {
+            sky_http_response_file(
+                    r,
+                    variant->fd,
+                    0,
+                    (sky_usize_t) variant->file_size,
+                    (sky_usize_t) variant->file_size,
+                    http_response_next,
+                    node
+            );
+            return;
+        }
+    }
+
     if (file->range && (!file->if_range || file->range_time == node->modified_time)) {
         r->state = 206;
         if (file->right == 0 || file->right > node->file_size) {
@@ -266,12 +449,17 @@ http_response_next(sky_http_server_request_t *const r, void *const data) {
 }
 
 static file_cache_node_t *
-cache_node_file_get_ref(http_module_file_t *module_file, sky_pool_t *pool, const sky_str_t *uri_path) {
+cache_node_file_get_ref(
+        http_module_file_t *const module_file,
+        sky_pool_t *const pool,
+        const sky_str_t *const uri_path,
+        const sky_bool_t variant
+) {
     sky_u32_t path_hash = sky_crc32_init();
     path_hash = sky_crc32c_update(path_hash, uri_path->data, uri_path->len);
     path_hash = sky_crc32_final(path_hash);
 
-    file_cache_node_t *node = rb_tree_get(&module_file->cache_tree, uri_path, path_hash);
+    file_cache_node_t *node = sky_hashmap_get(&module_file->cache_map, path_hash, uri_path);
     if (node) {
         if (sky_queue_linked(&node->link)) {
             sky_queue_remove(&node->link);
@@ -284,20 +472,40 @@ cache_node_file_get_ref(http_module_file_t *module_file, sky_pool_t *pool, const
     ptr += sizeof(file_cache_node_t);
 
     sky_queue_init_node(&node->link);
+    sky_queue_init_node(&node->watch_link);
     node->module_file = module_file;
+    node->watch = null;
     node->path_hash = path_hash;
     node->ref_count = 1;
     node->fd = -1;
+    node->stale = false;
+    node->has_variant = false;
+    node->variants[FILE_VARIANT_BR].fd = -1;
+    node->variants[FILE_VARIANT_GZ].fd = -1;
     node->path.data = ptr;
     node->path.len = uri_path->len;
     sky_memcpy(node->path.data, uri_path->data, uri_path->len);
-    rb_tree_insert(&module_file->cache_tree, node);
+    sky_isize_t dir_index = (sky_isize_t) uri_path->len - 1;
+    while (dir_index >= 0 && uri_path->data[dir_index] != '/') {
+        --dir_index;
+    }
+    node->name_offset = (sky_u32_t) (dir_index + 1);
+    if (sky_unlikely(!sky_hashmap_put(&module_file->cache_map, path_hash, node))) {
+        sky_free(node);
+        return null;
+    }
 
 
-    sky_char_t *const path = sky_palloc(pool, module_file->path.len + uri_path->len + 1);
+    const sky_usize_t path_len = module_file->path.len + uri_path->len;
+    sky_char_t *const path = sky_palloc(pool, path_len + 4); // 预留 .gz/.br 后缀
     sky_memcpy(path, module_file->path.data, module_file->path.len);
     sky_memcpy(path + module_file->path.len, uri_path->data, uri_path->len + 1);
 
+    // 先监听再打开，避免遗漏打开期间的变化
+    if (module_file->watch && dir_index >= 0) {
+        file_watch_add(node, path, module_file->path.len + (sky_usize_t) dir_index);
+    }
+
     const sky_i32_t fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
     if (fd < 0) {
         return node;
@@ -311,16 +519,85 @@ cache_node_file_get_ref(http_module_file_t *module_file, sky_pool_t *pool, const
     node->modified_time = stat_buf.st_mtime;
     node->file_size = stat_buf.st_size;
 
+    if (variant) {
+        cache_variant_open(node, path, path_len);
+    }
+
     return node;
 }
 
+static void
+cache_variant_open(file_cache_node_t *const node, sky_char_t *const path, const sky_usize_t path_len) {
+    static const sky_char_t exten[FILE_VARIANT_N][4] = {".br", ".gz"};
+
+    file_cache_variant_t *variant = node->variants;
+    struct stat stat_buf;
+    sky_i32_t fd;
+
+    for (sky_u32_t i = 0; i < FILE_VARIANT_N; ++i, ++variant) {
+        sky_memcpy(path + path_len, exten[i], 4);
+        fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        // 比原文件旧的预压缩文件视为过期，不使用
+        if (fstat(fd, &stat_buf) < 0
+            || !S_ISREG(stat_buf.st_mode)
+            || !stat_buf.st_size
+            || stat_buf.st_mtime < node->modified_time) {
+            close(fd);
+            continue;
+        }
+        variant->fd = fd;
+        variant->modified_time = stat_buf.st_mtime;
+        variant->file_size = stat_buf.st_size;
+        node->has_variant = true;
+    }
+    path[path_len] = '\0';
+}
+
+/**
+ * 按 Accept-Encoding 选择预压缩文件，br 优先，同时设置 Content-Encoding
+ */
+static const file_cache_variant_t *
+cache_variant_get(sky_http_server_request_t *const r, const file_cache_node_t *const node) {
+    const sky_u8_t accept = sky_http_req_accept_encoding(r);
+    const file_cache_variant_t *variant;
+    sky_http_server_header_t *header;
+
+    variant = node->variants + FILE_VARIANT_BR;
+    if ((accept & SKY_HTTP_ENCODING_BR) && variant->fd != -1) {
+        header = sky_list_push(&r->headers_out.headers);
+        sky_str_set(&header->key, "Content-Encoding");
+        sky_str_set(&header->val, "br");
+        return variant;
+    }
+    variant = node->variants + FILE_VARIANT_GZ;
+    if ((accept & SKY_HTTP_ENCODING_GZIP) && variant->fd != -1) {
+        header = sky_list_push(&r->headers_out.headers);
+        sky_str_set(&header->key, "Content-Encoding");
+        sky_str_set(&header->val, "gzip");
+        return variant;
+    }
+
+    return null;
+}
+
 static void
 cache_node_file_unref(file_cache_node_t *const node) {
     if ((--node->ref_count) != 0) {
         return;
     }
+    if (node->stale) {
+        cache_node_close(node);
+        sky_free(node);
+        return;
+    }
+    if (node->watch && node->fd != -1) { // 由目录监听负责失效
+        return;
+    }
     http_module_file_t *const module_file = node->module_file;
-    node->expire_at = sky_event_now(module_file->ev_loop) + module_file->cache_sec;
+    node->expire_at = sky_event_now_ms(module_file->ev_loop) + (sky_u64_t) module_file->cache_sec * 1000;
     sky_queue_insert_prev(&module_file->cache_queue, &node->link);
     if (!sky_timer_linked(&module_file->timer)) {
         sky_event_timeout_set(module_file->ev_loop, &module_file->timer, module_file->cache_sec);
@@ -333,76 +610,446 @@ cache_node_free_timer(sky_timer_wheel_entry_t *const timer) {
     sky_queue_t *item;
     file_cache_node_t *node;
 
-    const sky_i64_t now_time = sky_event_now(module_file->ev_loop);
+    const sky_u64_t now_time = sky_event_now_ms(module_file->ev_loop);
     while (!sky_queue_empty(&module_file->cache_queue)) {
         item = sky_queue_next(&module_file->cache_queue);
         node = sky_type_convert(item, file_cache_node_t, link);
         if (node->expire_at > now_time) {
-            sky_event_timeout_set(module_file->ev_loop, &module_file->timer, (sky_u32_t) (node->expire_at - now_time));
+            sky_event_timeout_set_ms(
+                    module_file->ev_loop,
+                    &module_file->timer,
+                    (sky_u32_t) (node->expire_at - now_time)
+            );
             return;
         }
         sky_queue_remove(item);
-        sky_rb_tree_del(&node->module_file->cache_tree, &node->node);
-        if (node->fd != -1) {
-            close(node->fd);
-        }
+        sky_hashmap_del(&module_file->cache_map, node->path_hash, node);
+        file_watch_unlink(node);
+        cache_node_close(node);
         sky_free(node);
     }
 }
 
+/**
+ * 文件变化时移除节点及其内存缓存，使用中的节点在引用释放后删除
+ */
+static void
+cache_node_invalidate(http_module_file_t *const module_file, file_cache_node_t *const node) {
+    file_mem_t *const mem = sky_hashmap_get(&module_file->mem_map, node->path_hash, &node->path);
+    if (mem) {
+        file_mem_remove(module_file, mem);
+    }
+    sky_hashmap_del(&module_file->cache_map, node->path_hash, node);
+    file_watch_unlink(node);
 
-static file_cache_node_t *
-rb_tree_get(
-        sky_rb_tree_t *const tree,
-        const sky_str_t *const path,
-        const sky_u32_t path_hash
+    if (node->ref_count) {
+        node->stale = true;
+        return;
+    }
+    if (sky_queue_linked(&node->link)) {
+        sky_queue_remove(&node->link);
+    }
+    cache_node_close(node);
+    sky_free(node);
+}
+
+static void
+cache_node_close(file_cache_node_t *const node) {
+    if (node->fd != -1) {
+        close(node->fd);
+    }
+    for (sky_u32_t i = 0; i < FILE_VARIANT_N; ++i) {
+        if (node->variants[i].fd != -1) {
+            close(node->variants[i].fd);
+        }
+    }
+}
+
+
+static sky_bool_t
+cache_node_equals(const void *const item, const void *const key) {
+    const file_cache_node_t *const node = item;
+
+    return sky_str_equals(&node->path, (const sky_str_t *) key);
+}
+
+/**
+ * 使用内存缓存响应，文件修改时间或大小变化时重新读取，发送时按需更新 Date
+ * @return 不适用或失败时返回false，由调用方继续发送文件
+ */
+static sky_bool_t
+file_mem_response(
+        http_module_file_t *const module_file,
+        sky_http_server_request_t *const r,
+        file_cache_node_t *const node
 ) {
-    sky_rb_node_t *node = tree->root;
-    file_cache_node_t *tmp;
-    sky_i32_t r;
-
-    while (node != &tree->sentinel) {
-        tmp = sky_type_convert(node, file_cache_node_t, node);
-        if (tmp->path_hash == path_hash) {
-            r = sky_str_cmp(&tmp->path, path);
-            if (!r) {
-                return tmp;
+    if (sky_http_response_compressible(r, (sky_usize_t) node->file_size)) {
+        return false;
+    }
+    file_mem_t *mem = sky_hashmap_get(&module_file->mem_map, node->path_hash, &node->path);
+    if (mem && (mem->modified_time != node->modified_time
+                || mem->file_size != node->file_size
+                || mem->type != r->headers_out.content_type.data)) {
+        file_mem_remove(module_file, mem);
+        mem = null;
+    }
+    if (mem) {
+        sky_queue_remove(&mem->link);
+        sky_queue_insert_prev(&module_file->mem_queue, &mem->link);
+    } else {
+        sky_str_t last_modified;
+        last_modified.data = sky_palloc(r->pool, 30);
+        last_modified.len = sky_date_to_rfc_str(node->modified_time, last_modified.data);
+
+        mem = file_mem_create(module_file, r, node, &last_modified);
+        if (!mem) {
+            return false;
+        }
+    }
+
+    sky_time_t now;
+    const sky_uchar_t *const date = sky_http_response_date(r, &now);
+    file_mem_buf_t *buf = mem->buf;
+    if (buf->date_sec != now) {
+        if (buf->ref_count) { // 仍在发送，不能原地修改
+            file_mem_buf_t *const copy = sky_malloc(sizeof(file_mem_buf_t) + buf->size);
+            if (sky_unlikely(!copy)) {
+                return false;
             }
-            node = r > 0 ? node->left : node->right;
-        } else {
-            node = tmp->path_hash > path_hash ? node->left : node->right;
+            sky_memcpy(copy, buf, sizeof(file_mem_buf_t) + buf->size);
+            copy->ref_count = 0;
+            buf->detached = true;
+            mem->buf = buf = copy;
         }
+        sky_memcpy(buf->data + buf->date_offset, date, 29);
+        buf->date_sec = now;
     }
+    ++buf->ref_count;
+    cache_node_file_unref(node);
 
-    return null;
+    sky_http_response_raw(r, buf->data, buf->size, file_mem_next, buf);
+
+    return true;
+}
+
+static file_mem_t *
+file_mem_create(
+        http_module_file_t *const module_file,
+        sky_http_server_request_t *const r,
+        const file_cache_node_t *const node,
+        const sky_str_t *const last_modified
+) {
+    sky_str_buf_t str_buf;
+    sky_str_buf_init2(&str_buf, r->pool, 256);
+    sky_str_buf_append_str(&str_buf, &r->version_name);
+    sky_str_buf_append_str_len(&str_buf, sky_str_line(" 200 OK\r\nConnection: keep-alive\r\nDate: "));
+    const sky_usize_t date_offset = sky_str_buf_size(&str_buf);
+    sky_str_buf_append_str_len(&str_buf, sky_str_line("                             \r\nContent-Type: "));
+    sky_str_buf_append_str(&str_buf, &r->headers_out.content_type);
+    sky_str_buf_append_str_len(&str_buf, sky_str_line("\r\nServer: sky\r\nContent-Length: "));
+    sky_str_buf_append_i64(&str_buf, node->file_size);
+    sky_str_buf_append_str_len(&str_buf, sky_str_line("\r\nLast-Modified: "));
+    sky_str_buf_append_str(&str_buf, last_modified);
+    sky_str_buf_append_str_len(&str_buf, sky_str_line("\r\n\r\n"));
+    if (sky_unlikely(sky_str_buf_fail(&str_buf))) {
+        sky_str_buf_destroy(&str_buf);
+        return null;
+    }
+    const sky_usize_t header_size = sky_str_buf_size(&str_buf);
+    const sky_usize_t size = header_size + (sky_usize_t) node->file_size;
+    const sky_usize_t cost = sizeof(file_mem_t) + node->path.len + sizeof(file_mem_buf_t) + size;
+    if (cost > module_file->mem_max) {
+        sky_str_buf_destroy(&str_buf);
+        return null;
+    }
+
+    file_mem_buf_t *const buf = sky_malloc(sizeof(file_mem_buf_t) + size);
+    if (sky_unlikely(!buf)) {
+        sky_str_buf_destroy(&str_buf);
+        return null;
+    }
+    sky_memcpy(buf->data, str_buf.start, header_size);
+    sky_str_buf_destroy(&str_buf);
+
+    sky_uchar_t *p = buf->data + header_size;
+    sky_i64_t offset = 0;
+    ssize_t n;
+    while (offset < node->file_size) {
+        n = pread(node->fd, p, (sky_usize_t) (node->file_size - offset), offset);
+        if (n <= 0) { // 读取期间文件被截断或出错
+            sky_free(buf);
+            return null;
+        }
+        p += n;
+        offset += n;
+    }
+    buf->date_sec = -1;
+    buf->ref_count = 0;
+    buf->size = (sky_u32_t) size;
+    buf->date_offset = (sky_u32_t) date_offset;
+    buf->detached = false;
+
+    file_mem_t *const mem = sky_malloc(sizeof(file_mem_t) + node->path.len);
+    if (sky_unlikely(!mem)) {
+        sky_free(buf);
+        return null;
+    }
+    mem->path.data = (sky_uchar_t *) (mem + 1);
+    mem->path.len = node->path.len;
+    sky_memcpy(mem->path.data, node->path.data, node->path.len);
+    mem->modified_time = node->modified_time;
+    mem->file_size = node->file_size;
+    mem->type = r->headers_out.content_type.data;
+    mem->buf = buf;
+    mem->cost = cost;
+    mem->path_hash = node->path_hash;
+
+    if (sky_unlikely(!sky_hashmap_put(&module_file->mem_map, mem->path_hash, mem))) {
+        sky_free(buf);
+        sky_free(mem);
+        return null;
+    }
+    sky_queue_t *item;
+    while ((module_file->mem_size + cost) > module_file->mem_max) {
+        item = sky_queue_next(&module_file->mem_queue);
+        file_mem_remove(module_file, sky_type_convert(item, file_mem_t, link));
+    }
+    module_file->mem_size += cost;
+    sky_queue_insert_prev(&module_file->mem_queue, &mem->link);
+
+    return mem;
 }
 
 static void
-rb_tree_insert(sky_rb_tree_t *const tree, file_cache_node_t *const node) {
-    if (sky_rb_tree_is_empty(tree)) {
-        sky_rb_tree_link(tree, &node->node, null);
-        return;
+file_mem_remove(http_module_file_t *const module_file, file_mem_t *const mem) {
+    sky_hashmap_del(&module_file->mem_map, mem->path_hash, mem);
+    sky_queue_remove(&mem->link);
+    module_file->mem_size -= mem->cost;
+
+    if (mem->buf->ref_count) {
+        mem->buf->detached = true;
+    } else {
+        sky_free(mem->buf);
     }
-    sky_rb_node_t **p, *temp = tree->root;
-    file_cache_node_t *other;
+    sky_free(mem);
+}
 
-    for (;;) {
-        other = sky_type_convert(temp, file_cache_node_t, node);
-        if (node->path_hash == other->path_hash) {
-            p = sky_str_cmp(&node->path, &other->path) < 0 ? &temp->left : &temp->right;
-        } else {
-            p = node->path_hash < other->path_hash ? &temp->left : &temp->right;
+static void
+file_mem_next(sky_http_server_request_t *const r, void *const data) {
+    file_mem_buf_t *const buf = data;
+    if (!(--buf->ref_count) && buf->detached) {
+        sky_free(buf);
+    }
+
+    sky_http_server_req_finish(r);
+}
+
+static sky_bool_t
+file_mem_equals(const void *const item, const void *const key) {
+    const file_mem_t *const mem = item;
+
+    return sky_str_equals(&mem->path, (const sky_str_t *) key);
+}
+
+#ifdef SKY_HAVE_INOTIFY
+
+static sky_bool_t
+file_watch_init(http_module_file_t *const module_file) {
+    const sky_i32_t fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (sky_unlikely(fd < 0)) {
+        return false;
+    }
+    sky_ev_init(&module_file->watch_ev, sky_event_selector(module_file->ev_loop), file_watch_cb, fd);
+    if (sky_unlikely(!sky_selector_register(&module_file->watch_ev, SKY_EV_READ))) {
+        close(fd);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * 监听节点所在目录，失败时节点仍按 cache_sec 过期
+ * @param path    文件完整路径
+ * @param dir_len 目录部分长度
+ */
+static void
+file_watch_add(file_cache_node_t *const node, sky_char_t *const path, const sky_usize_t dir_len) {
+    http_module_file_t *const module_file = node->module_file;
+
+    path[dir_len] = '\0';
+    const sky_i32_t wd = inotify_add_watch(sky_ev_get_fd(&module_file->watch_ev), path, FILE_WATCH_MASK);
+    path[dir_len] = '/';
+    if (wd < 0) {
+        return;
+    }
+    // 同一目录重复添加时返回相同的 wd
+    file_watch_t *watch = sky_hashmap_get(&module_file->watch_map, (sky_u64_t) wd, &wd);
+    if (!watch) {
+        watch = sky_malloc(sizeof(file_watch_t));
+        if (sky_unlikely(!watch)) {
+            inotify_rm_watch(sky_ev_get_fd(&module_file->watch_ev), wd);
+            return;
+        }
+        sky_queue_init(&watch->nodes);
+        watch->wd = wd;
+        if (sky_unlikely(!sky_hashmap_put(&module_file->watch_map, (sky_u64_t) wd, watch))) {
+            inotify_rm_watch(sky_ev_get_fd(&module_file->watch_ev), wd);
+            sky_free(watch);
+            return;
         }
+    }
+    node->watch = watch;
+    sky_queue_insert_prev(&watch->nodes, &node->watch_link);
+}
+
+static void
+file_watch_unlink(file_cache_node_t *const node) {
+    file_watch_t *const watch = node->watch;
+    if (!watch) {
+        return;
+    }
+    node->watch = null;
+    sky_queue_remove(&node->watch_link);
+    if (!sky_queue_empty(&watch->nodes)) {
+        return;
+    }
+    http_module_file_t *const module_file = node->module_file;
+    sky_hashmap_del(&module_file->watch_map, (sky_u64_t) watch->wd, watch);
+    inotify_rm_watch(sky_ev_get_fd(&module_file->watch_ev), watch->wd);
+    sky_free(watch);
+}
 
-        if (*p == &tree->sentinel) {
-            *p = &node->node;
-            sky_rb_tree_link(tree, &node->node, temp);
+static void
+file_watch_cb(sky_ev_t *const ev) {
+    http_module_file_t *const module_file = sky_type_convert(ev, http_module_file_t, watch_ev);
+    sky_uchar_t buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    file_watch_t *watch;
+    const sky_uchar_t *p, *end, *name;
+    sky_usize_t iter, name_len;
+    ssize_t n;
+
+    for (;;) {
+        n = read(sky_ev_get_fd(ev), buf, sizeof(buf));
+        if (n <= 0) {
+            sky_ev_clean_read(ev);
             return;
         }
-        temp = *p;
+        end = buf + n;
+        for (p = buf; p < end; p += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event *) p;
+
+            if (sky_unlikely(event->mask & IN_Q_OVERFLOW)) { // 事件丢失，全部失效
+                for (;;) {
+                    iter = 0;
+                    watch = sky_hashmap_next(&module_file->watch_map, &iter);
+                    if (!watch) {
+                        break;
+                    }
+                    file_watch_clean(module_file, watch);
+                }
+                continue;
+            }
+            watch = sky_hashmap_get(&module_file->watch_map, (sky_u64_t) event->wd, &event->wd);
+            if (!watch) {
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_UNMOUNT)) {
+                file_watch_clean(module_file, watch);
+                continue;
+            }
+            if (!event->len) {
+                continue;
+            }
+            name = (const sky_uchar_t *) event->name;
+            name_len = strlen(event->name);
+            file_watch_name_changed(module_file, watch, name, name_len);
+
+            // 预压缩文件变化时原文件同样失效，watch 可能已随最后一个节点释放
+            if (module_file->precompressed
+                && name_len > 3
+                && (sky_str_len_end_with(name, name_len, sky_str_line(".gz"))
+                    || sky_str_len_end_with(name, name_len, sky_str_line(".br")))) {
+                watch = sky_hashmap_get(&module_file->watch_map, (sky_u64_t) event->wd, &event->wd);
+                if (watch) {
+                    file_watch_name_changed(module_file, watch, name, name_len - 3);
+                }
+            }
+        }
     }
 }
 
+static void
+file_watch_name_changed(
+        http_module_file_t *const module_file,
+        file_watch_t *const watch,
+        const sky_uchar_t *const name,
+        const sky_usize_t name_len
+) {
+    sky_queue_t *item = sky_queue_next(&watch->nodes), *next;
+    file_cache_node_t *node;
+    sky_bool_t last;
+
+    do {
+        next = sky_queue_next(item);
+        last = next == &watch->nodes; // 最后一个节点移除时会释放 watch
+        node = sky_type_convert(item, file_cache_node_t, watch_link);
+        if (node->path.len - node->name_offset == name_len
+            && sky_str_len_unsafe_equals(node->path.data + node->name_offset, name, name_len)) {
+            cache_node_invalidate(module_file, node);
+        }
+        item = next;
+    } while (!last);
+}
+
+/**
+ * 目录本身被删除或移动，其下的节点全部失效
+ */
+static void
+file_watch_clean(http_module_file_t *const module_file, file_watch_t *const watch) {
+    sky_queue_t *item;
+    sky_bool_t last;
+
+    do {
+        item = sky_queue_next(&watch->nodes);
+        last = sky_queue_next(item) == &watch->nodes;
+        cache_node_invalidate(module_file, sky_type_convert(item, file_cache_node_t, watch_link));
+    } while (!last);
+}
+
+#else
+
+static sky_bool_t
+file_watch_init(http_module_file_t *const module_file) {
+    (void) module_file;
+
+    sky_log_warn("inotify not supported, file watch disabled");
+
+    return false;
+}
+
+static void
+file_watch_add(file_cache_node_t *const node, sky_char_t *const path, const sky_usize_t dir_len) {
+    (void) node;
+    (void) path;
+    (void) dir_len;
+}
+
+static void
+file_watch_unlink(file_cache_node_t *const node) {
+    (void) node;
+}
+
+#endif
+
+static sky_bool_t
+file_watch_equals(const void *const item, const void *const key) {
+    const file_watch_t *const watch = item;
+
+    return watch->wd == *(const sky_i32_t *) key;
+}
+
 
 static sky_bool_t
 http_header_range(http_file_t *const file, const sky_str_t *const value) {
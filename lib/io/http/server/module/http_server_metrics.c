@@ -0,0 +1,195 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+#include <io/http/http_server_metrics.h>
+#include <core/memory.h>
+#include <core/string_buf.h>
+
+static void http_metrics_run(sky_http_server_request_t *r, void *data);
+
+static void metrics_counter(sky_str_buf_t *buf, const char *name, const char *help, sky_u64_t value);
+
+static void metrics_gauge(sky_str_buf_t *buf, const char *name, const char *help, sky_u64_t value);
+
+static void metrics_summary(
+        sky_str_buf_t *buf,
+        const char *name,
+        const char *help,
+        const sky_histogram_t *h,
+        sky_bool_t us
+);
+
+static void metrics_head(sky_str_buf_t *buf, const char *name, const char *help, const char *type);
+
+static void metrics_name(sky_str_buf_t *buf, const char *name, const char *suffix);
+
+static void metrics_value(sky_str_buf_t *buf, sky_u64_t value, sky_bool_t us);
+
+
+sky_api sky_http_server_module_t *
+sky_http_server_metrics_create(const sky_http_server_metrics_conf_t *const conf) {
+    sky_http_server_module_t *const module = sky_malloc(
+            sizeof(sky_http_server_module_t) + conf->host.len + conf->prefix.len
+    );
+    if (sky_unlikely(!module)) {
+        return null;
+    }
+    sky_uchar_t *const data = (sky_uchar_t *) (module + 1);
+
+    module->host.data = data;
+    module->host.len = conf->host.len;
+    sky_memcpy(data, conf->host.data, conf->host.len);
+    module->prefix.data = data + conf->host.len;
+    module->prefix.len = conf->prefix.len;
+    sky_memcpy(module->prefix.data, conf->prefix.data, conf->prefix.len);
+    module->run = http_metrics_run;
+    module->module_data = null;
+
+    return module;
+}
+
+sky_api void
+sky_http_server_metrics_destroy(sky_http_server_module_t *const server_metrics) {
+    sky_free(server_metrics);
+}
+
+static void
+http_metrics_run(sky_http_server_request_t *const r, void *const data) {
+    (void) data;
+
+    sky_selector_metrics_t metrics;
+    const sky_u32_t loop_n = sky_event_loop_metrics_collect(&metrics);
+
+    sky_str_buf_t buf;
+    sky_str_buf_init2(&buf, r->pool, 4096);
+
+    metrics_gauge(&buf, "sky_event_loops", "Number of running event loops.", loop_n);
+    metrics_summary(
+            &buf,
+            "sky_event_loop_events_per_wait",
+            "Ready events returned by one selector wait.",
+            &metrics.event_hist,
+            false
+    );
+    metrics_counter(&buf, "sky_event_loop_timers_total", "Number of fired timers.", metrics.timer_n);
+    metrics_summary(
+            &buf,
+            "sky_event_loop_busy_seconds",
+            "Time spent running callbacks and timers per loop iteration.",
+            &metrics.busy_hist,
+            true
+    );
+    metrics_counter(&buf, "sky_tcp_accepted_total", "Number of accepted connections.", metrics.accept_n);
+    metrics_counter(&buf, "sky_tcp_connected_total", "Number of outgoing connections.", metrics.connect_n);
+    metrics_gauge(&buf, "sky_tcp_connections", "Number of open connections.", metrics.conn_active);
+    metrics_counter(&buf, "sky_tcp_read_bytes_total", "Bytes read from sockets.", metrics.read_bytes);
+    metrics_counter(&buf, "sky_tcp_written_bytes_total", "Bytes written to sockets.", metrics.write_bytes);
+    metrics_summary(
+            &buf,
+            "sky_http_request_duration_seconds",
+            "HTTP request latency from first byte read to response finished.",
+            &metrics.req_hist,
+            true
+    );
+
+    sky_str_t body;
+    sky_str_buf_build(&buf, &body);
+
+    sky_str_set(&r->headers_out.content_type, "text/plain; version=0.0.4");
+    sky_http_response_str(r, &body, null, null);
+}
+
+static void
+metrics_counter(sky_str_buf_t *const buf, const char *const name, const char *const help, const sky_u64_t value) {
+    metrics_head(buf, name, help, "counter");
+    metrics_name(buf, name, null);
+    sky_str_buf_append_uchar(buf, ' ');
+    sky_str_buf_append_u64(buf, value);
+    sky_str_buf_append_uchar(buf, '\n');
+}
+
+static void
+metrics_gauge(sky_str_buf_t *const buf, const char *const name, const char *const help, const sky_u64_t value) {
+    metrics_head(buf, name, help, "gauge");
+    metrics_name(buf, name, null);
+    sky_str_buf_append_uchar(buf, ' ');
+    sky_str_buf_append_i64(buf, (sky_i64_t) value); // 跨线程读取时可能短暂为负
+    sky_str_buf_append_uchar(buf, '\n');
+}
+
+/**
+ * 直方图在进程内合并后输出分位数，跨进程不可再聚合
+ */
+static void
+metrics_summary(
+        sky_str_buf_t *const buf,
+        const char *const name,
+        const char *const help,
+        const sky_histogram_t *const h,
+        const sky_bool_t us
+) {
+    static const struct {
+        sky_str_t label;
+        sky_f64_t percent;
+    } quantiles[] = {
+            {sky_string("0.5"),   50.0},
+            {sky_string("0.9"),   90.0},
+            {sky_string("0.99"),  99.0},
+            {sky_string("0.999"), 99.9},
+    };
+
+    metrics_head(buf, name, help, "summary");
+
+    for (sky_u32_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i) {
+        metrics_name(buf, name, "{quantile=\"");
+        sky_str_buf_append_str(buf, &quantiles[i].label);
+        sky_str_buf_append_str_len(buf, sky_str_line("\"} "));
+        metrics_value(buf, sky_histogram_percentile(h, quantiles[i].percent), us);
+        sky_str_buf_append_uchar(buf, '\n');
+    }
+    metrics_name(buf, name, "_sum ");
+    metrics_value(buf, sky_histogram_sum(h), us);
+    sky_str_buf_append_uchar(buf, '\n');
+    metrics_name(buf, name, "_count ");
+    sky_str_buf_append_u64(buf, sky_histogram_count(h));
+    sky_str_buf_append_uchar(buf, '\n');
+}
+
+static void
+metrics_head(sky_str_buf_t *const buf, const char *const name, const char *const help, const char *const type) {
+    sky_str_buf_append_str_len(buf, sky_str_line("# HELP "));
+    metrics_name(buf, name, " ");
+    sky_str_buf_append_str_len(buf, (const sky_uchar_t *) help, strlen(help));
+    sky_str_buf_append_str_len(buf, sky_str_line("\n# TYPE "));
+    metrics_name(buf, name, " ");
+    sky_str_buf_append_str_len(buf, (const sky_uchar_t *) type, strlen(type));
+    sky_str_buf_append_uchar(buf, '\n');
+}
+
+static sky_inline void
+metrics_name(sky_str_buf_t *const buf, const char *const name, const char *const suffix) {
+    sky_str_buf_append_str_len(buf, (const sky_uchar_t *) name, strlen(name));
+    if (suffix) {
+        sky_str_buf_append_str_len(buf, (const sky_uchar_t *) suffix, strlen(suffix));
+    }
+}
+
+/**
+ * 微秒以秒为单位输出，固定6位小数
+ */
+static void
+metrics_value(sky_str_buf_t *const buf, const sky_u64_t value, const sky_bool_t us) {
+    if (!us) {
+        sky_str_buf_append_u64(buf, value);
+        return;
+    }
+    sky_str_buf_append_u64(buf, value / 1000000);
+
+    sky_uchar_t *const p = sky_str_buf_put(buf, 7);
+    sky_u32_t frac = (sky_u32_t) (value % 1000000);
+    p[0] = '.';
+    for (sky_u32_t i = 6; i > 0; --i) {
+        p[i] = (sky_uchar_t) ('0' + frac % 10);
+        frac /= 10;
+    }
+}
@@ -250,7 +250,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
         sky_usize_t read_n;
@@ -357,7 +357,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
@@ -379,7 +379,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     read_again:
-    n = sky_tcp_read(tcp, buf->last, (sky_usize_t) (buf->end - buf->last));
+    n = http_conn_read(conn, buf->last, (sky_usize_t) (buf->end - buf->last));
     if (n > 0) {
         buf->last += n;
         sky_usize_t read_n;
@@ -525,7 +525,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         return;
     }
 
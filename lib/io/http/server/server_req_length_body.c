@@ -150,7 +150,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_read(tcp, buf->pos, sky_min(free_n, size));
+    n = http_conn_read(conn, buf->pos, sky_min(free_n, size));
 
     if (n > 0) {
         size -= (sky_usize_t) n;
@@ -168,7 +168,7 @@ http_body_read_none(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
 
         req->headers_in.content_length_n = size;
         return;
@@ -191,7 +191,7 @@ http_body_read_str(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_read(tcp, buf->last, size);
+    n = http_conn_read(conn, buf->last, size);
     if (n > 0) {
         buf->last += n;
         size -= (sky_usize_t) n;
@@ -214,7 +214,7 @@ http_body_read_str(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
         req->headers_in.content_length_n = size;
         return;
     }
@@ -237,7 +237,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
     sky_isize_t n;
 
     again:
-    n = sky_tcp_read(tcp, buf->pos, sky_min(free_n, size));
+    n = http_conn_read(conn, buf->pos, sky_min(free_n, size));
     if (n > 0) {
         size -= (sky_usize_t) n;
         conn->next_read_cb(req, buf->pos, (sky_usize_t) n, conn->cb_data);
@@ -255,7 +255,7 @@ http_body_read_cb(sky_tcp_t *const tcp) {
 
     if (sky_likely(!n)) {
         sky_tcp_try_register(tcp, SKY_EV_READ | SKY_EV_WRITE);
-        sky_event_timeout_set(conn->server->ev_loop, &conn->timer, conn->server->timeout);
+        sky_event_timeout_set_ms(conn->server->ev_loop, &conn->timer, conn->server->timeout);
 
         req->headers_in.content_length_n = size;
         return;
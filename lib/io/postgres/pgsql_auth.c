@@ -43,7 +43,7 @@ pgsql_auth(sky_pgsql_conn_t *const conn) {
 
     conn->offset = 0;
     sky_timer_set_cb(&conn->timer, pgsql_send_info_timeout);
-    sky_event_timeout_expired(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+    sky_event_timeout_expired_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
     sky_tcp_set_cb(&conn->tcp, pgsql_connect_info_send);
     pgsql_connect_info_send(&conn->tcp);
 }
@@ -68,7 +68,7 @@ pgsql_connect_info_send(sky_tcp_t *const tcp) {
             packet->status = START;
             conn->data = packet;
             sky_timer_set_cb(&conn->timer, pgsql_auth_timeout);
-            sky_event_timeout_expired(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+            sky_event_timeout_expired_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
             sky_tcp_set_cb(tcp, pgsql_auth_read);
             pgsql_auth_read(tcp);
             return;
@@ -278,7 +278,7 @@ pgsql_password(
 
     packet->buf.last += 41;
 
-    sky_event_timeout_expired(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+    sky_event_timeout_expired_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
     sky_tcp_set_cb(&conn->tcp, pgsql_password_send);
     pgsql_password_send(&conn->tcp);
 }
@@ -92,7 +92,7 @@ sky_pgsql_exec(
     const sky_pgsql_pool_t *const pg_pool = conn->pg_pool;
 
     sky_timer_set_cb(&conn->timer, pgsql_exec_timeout);
-    sky_event_timeout_set(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+    sky_event_timeout_set_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
     sky_tcp_set_cb(&conn->tcp, pgsql_exec_send);
     pgsql_exec_send(&conn->tcp);
 }
@@ -199,7 +199,7 @@ pgsql_exec_send(sky_tcp_t *const tcp) {
             packet->status = START;
             packet->size = 0;
 
-            sky_event_timeout_expired(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+            sky_event_timeout_expired_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
             sky_tcp_set_cb(tcp, pgsql_exec_read);
             pgsql_exec_read(tcp);
             return;
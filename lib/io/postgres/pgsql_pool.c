@@ -42,8 +42,8 @@ sky_pgsql_pool_create(sky_event_loop_t *const ev_loop, const sky_pgsql_conf_t *c
     pg_pool->ev_loop = ev_loop;
     pg_pool->conn_num = conn_num;
     pg_pool->free_conn_num = conn_num;
-    pg_pool->timeout = conf->timeout ?: 10;
-    pg_pool->keepalive = conf->keepalive ?: 120;
+    pg_pool->timeout = conf->timeout_ms ?: (conf->timeout ?: 10) * 1000;
+    pg_pool->keepalive = (conf->keepalive ?: 120) * 1000;
 
     ptr += sizeof(sky_pgsql_pool_t);
 
@@ -126,7 +126,7 @@ sky_pgsql_conn_release(sky_pgsql_conn_t *const conn) {
     if (sky_queue_empty(&pg_pool->tasks)) {
         sky_queue_insert_next(&pg_pool->free_conns, &conn->link);
         sky_timer_set_cb(&conn->timer, pgsql_conn_keepalive_timeout);
-        sky_event_timeout_set(pg_pool->ev_loop, &conn->timer, pg_pool->keepalive);
+        sky_event_timeout_set_ms(pg_pool->ev_loop, &conn->timer, pg_pool->keepalive);
 
         ++pg_pool->free_conn_num;
 
@@ -169,7 +169,7 @@ pgsql_connect_next(sky_pgsql_conn_t *const conn) {
     sky_tcp_option_no_delay(&conn->tcp);
 
     sky_timer_set_cb(&conn->timer, pgsql_connect_timeout);
-    sky_event_timeout_set(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
+    sky_event_timeout_set_ms(pg_pool->ev_loop, &conn->timer, pg_pool->timeout);
     sky_tcp_set_cb(&conn->tcp, pgsql_connection);
     pgsql_connection(&conn->tcp);
 }
@@ -232,7 +232,7 @@ pgsql_task_next(sky_timer_wheel_entry_t *const timer) {
     if (item == &pg_pool->tasks) {
         sky_queue_insert_next(&pg_pool->free_conns, &conn->link);
         sky_timer_set_cb(&conn->timer, pgsql_conn_keepalive_timeout);
-        sky_event_timeout_set(pg_pool->ev_loop, &conn->timer, pg_pool->keepalive);
+        sky_event_timeout_set_ms(pg_pool->ev_loop, &conn->timer, pg_pool->keepalive);
 
         ++pg_pool->free_conn_num;
 
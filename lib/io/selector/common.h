@@ -8,7 +8,11 @@
 #include <io/selector.h>
 
 
-#if defined(SKY_HAVE_EPOLL)
+#if defined(SKY_HAVE_IO_URING)
+
+#define SELECTOR_USE_IO_URING
+
+#elif defined(SKY_HAVE_EPOLL)
 
 #define SELECTOR_USE_EPOLL
 
@@ -33,6 +33,7 @@
 #endif
 
 struct sky_selector_s {
+    sky_selector_metrics_t metrics; // 必须为首个成员
     sky_i32_t fd;
     sky_u32_t ev_n;
     sky_i32_t max_event;
@@ -59,6 +60,7 @@ sky_selector_create() {
     max_event = sky_min(max_event, 1024);
 
     sky_selector_t *const s = sky_malloc(sizeof(sky_selector_t) );
+    sky_selector_metrics_init(&s->metrics);
     s->fd = fd;
     s->ev_n = 0;
     s->max_event = max_event;
@@ -110,6 +112,7 @@ sky_selector_select(sky_selector_t *const s, const sky_i32_t timeout) {
 
 sky_api void
 sky_selector_run(sky_selector_t *const s) {
+    sky_histogram_record(&s->metrics.event_hist, s->ev_n);
     if (sky_unlikely(!s->ev_n)) {
         return;
     }
@@ -0,0 +1,886 @@
+//
+// Created by beliefsky on 2023/11/8.
+//
+
+#include "common.h"
+
+#ifdef SELECTOR_USE_IO_URING
+
+#include <core/memory.h>
+#include <core/log.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define SKY_EVENT_MAX       1024
+#define SKY_RING_SQ_SIZE    SKY_U32(1024)
+#define SKY_RING_CQ_SIZE    SKY_U32(8192)
+#define SKY_EV_IN_INDEX     SKY_U32(0x80000000)
+#define SKY_EV_INDEX_MASK   SKY_U32(0x7FFF0000)
+#define SKY_EV_STATUS_MASK  SKY_U32(0xFFFF)
+#define SKY_SLOT_NONE       SKY_U32_MAX
+#define SKY_SLOT_SHIFT      SKY_U32(3)
+#define SKY_SLOT_MAX        (SKY_U32_MAX >> SKY_SLOT_SHIFT)
+#define SKY_RING_REQ_FLAG   SKY_U64(0x1)
+
+/*
+ * user_data: 提交请求为 req 地址 | 1；poll 为 gen << 32 | (slot + 1) << 1；poll 移除与请求取消为 0
+ */
+#define ring_poll_data(_gen, _slot) (((sky_u64_t) (_gen) << 32) | ((sky_u64_t) ((_slot) + 1) << 1))
+#define ring_poll_slot(_data)       ((((sky_u32_t) ((_data) & SKY_U32_MAX)) >> 1) - 1)
+
+#ifndef OPEN_MAX
+
+#include <sys/param.h>
+
+#ifndef OPEN_MAX
+#ifdef NOFILE
+#define OPEN_MAX NOFILE
+#else
+#define OPEN_MAX 65535
+#endif
+#endif
+#endif
+
+typedef struct {
+    sky_ev_t *ev;
+    sky_u32_t gen; // 每次重新挂载poll自增，过滤已取消请求的残留完成事件
+    sky_u32_t next;
+    sky_bool_t armed; // poll 已提交且尚未完成
+    sky_bool_t idle; // 位于 idle 列表，等待就绪位被清除后重新挂载
+} ev_slot_t;
+
+/**
+ * 使用 io_uring 单次 poll 实现就绪通知，完成后只为已清除就绪位的方向重新挂载，
+ * 仍就绪的事件放入 idle 列表，下一次等待前检查，语义与 epoll 边缘触发一致
+ * (多次触发的 poll 在部分内核上会丢失可写通知)；注册、修改、取消只写入提交队列，
+ * 随下一次等待一并提交，避免每个连接单独调用 epoll_ctl。提交队列满时暂存到 pend，
+ * 下一次等待前优先提交，保证 poll 的取消不会丢失。
+ * 收发请求(sky_selector_recv 等)与 poll 共用提交队列，完成时执行请求的回调。
+ */
+struct sky_selector_s {
+    sky_selector_metrics_t metrics; // 必须为首个成员
+    sky_i32_t fd;
+    sky_u32_t ev_n;
+
+    sky_u32_t *sq_k_head;
+    sky_u32_t *sq_k_tail;
+    sky_u32_t sq_mask;
+    sky_u32_t sq_entries;
+    sky_u32_t sq_tail;
+    sky_u32_t sq_submit;
+    struct io_uring_sqe *sqes;
+
+    sky_u32_t *cq_k_head;
+    sky_u32_t *cq_k_tail;
+    sky_u32_t cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring;
+    void *cq_ring;
+    sky_usize_t sq_ring_size;
+    sky_usize_t cq_ring_size;
+    sky_usize_t sqes_size;
+
+    ev_slot_t *slots;
+    sky_u32_t slot_n;
+    sky_u32_t slot_cap;
+    sky_u32_t slot_free;
+
+    struct io_uring_sqe *pend; // 提交队列满时暂存，按顺序提交
+    sky_u32_t pend_n;
+    sky_u32_t pend_cap;
+    sky_bool_t sqe_in_ring; // 最近一次 ring_get_sqe 是否取自提交队列
+
+    sky_u32_t *idle;
+    sky_u32_t idle_n;
+    sky_u32_t idle_cap;
+
+    sky_ev_t *evs[SKY_EVENT_MAX];
+};
+
+static sky_i32_t ring_setup(sky_u32_t entries, struct io_uring_params *p);
+
+static sky_i32_t ring_enter(sky_i32_t fd, sky_u32_t submit, sky_u32_t min_complete, sky_u32_t flags, void *arg);
+
+static sky_bool_t ring_sq_reserve(sky_selector_t *s);
+
+static struct io_uring_sqe *ring_get_sqe(sky_selector_t *s);
+
+static void ring_sqe_commit(sky_selector_t *s);
+
+static void ring_pend_flush(sky_selector_t *s);
+
+static sky_bool_t ring_poll_add(sky_selector_t *s, sky_u32_t slot, sky_u32_t flags);
+
+static sky_ev_t *ring_poll_done(sky_selector_t *s, const struct io_uring_cqe *cqe);
+
+static void ring_poll_remove(sky_selector_t *s, sky_u32_t slot);
+
+static void ring_poll_rearm(sky_selector_t *s, sky_u32_t slot);
+
+static void ring_idle_push(sky_selector_t *s, sky_u32_t slot);
+
+static void ring_idle_arm(sky_selector_t *s);
+
+static sky_u32_t slot_alloc(sky_selector_t *s, sky_ev_t *ev);
+
+static void slot_free(sky_selector_t *s, sky_u32_t slot);
+
+static sky_u32_t ev_poll_events(sky_u32_t flags);
+
+static void ring_destroy(sky_selector_t *s);
+
+static sky_i32_t setup_open_file_count_limits();
+
+sky_api sky_selector_t *
+sky_selector_create() {
+    struct sigaction sa;
+
+    sky_memzero(&sa, sizeof(struct sigaction));
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, null);
+
+    setup_open_file_count_limits();
+
+    struct io_uring_params p;
+    sky_memzero(&p, sizeof(struct io_uring_params));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = SKY_RING_CQ_SIZE;
+
+    const sky_i32_t fd = ring_setup(SKY_RING_SQ_SIZE, &p);
+    if (sky_unlikely(fd < 0)) {
+        sky_log_error("io_uring setup error: %d", errno);
+        return null;
+    }
+    if (sky_unlikely((p.features & (IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG))
+                     != (IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG))) {
+        sky_log_error("io_uring feature not support: %u", p.features);
+        close(fd);
+        return null;
+    }
+
+    sky_selector_t *const s = sky_malloc(sizeof(sky_selector_t));
+    sky_selector_metrics_init(&s->metrics);
+    s->fd = fd;
+    s->ev_n = 0;
+    s->sq_tail = 0;
+    s->sq_submit = 0;
+    s->slots = null;
+    s->slot_n = 0;
+    s->slot_cap = 0;
+    s->slot_free = SKY_SLOT_NONE;
+    s->pend = null;
+    s->pend_n = 0;
+    s->pend_cap = 0;
+    s->idle = null;
+    s->idle_n = 0;
+    s->idle_cap = 0;
+    s->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(sky_u32_t);
+    s->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    s->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+        s->sq_ring_size = sky_max(s->sq_ring_size, s->cq_ring_size);
+        s->cq_ring_size = s->sq_ring_size;
+    }
+
+    s->sq_ring = mmap(
+            null,
+            s->sq_ring_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd,
+            IORING_OFF_SQ_RING
+    );
+    if (sky_unlikely(s->sq_ring == MAP_FAILED)) {
+        close(fd);
+        sky_free(s);
+        return null;
+    }
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+        s->cq_ring = s->sq_ring;
+    } else {
+        s->cq_ring = mmap(
+                null,
+                s->cq_ring_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE,
+                fd,
+                IORING_OFF_CQ_RING
+        );
+        if (sky_unlikely(s->cq_ring == MAP_FAILED)) {
+            munmap(s->sq_ring, s->sq_ring_size);
+            close(fd);
+            sky_free(s);
+            return null;
+        }
+    }
+    s->sqes = mmap(
+            null,
+            s->sqes_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd,
+            IORING_OFF_SQES
+    );
+    if (sky_unlikely(s->sqes == MAP_FAILED)) {
+        s->sqes = null;
+        ring_destroy(s);
+        return null;
+    }
+
+    sky_uchar_t *const sq = s->sq_ring;
+    s->sq_k_head = (sky_u32_t *) (sq + p.sq_off.head);
+    s->sq_k_tail = (sky_u32_t *) (sq + p.sq_off.tail);
+    s->sq_mask = *(sky_u32_t *) (sq + p.sq_off.ring_mask);
+    s->sq_entries = *(sky_u32_t *) (sq + p.sq_off.ring_entries);
+
+    sky_u32_t *const array = (sky_u32_t *) (sq + p.sq_off.array);
+    for (sky_u32_t i = 0; i < s->sq_entries; ++i) {
+        array[i] = i;
+    }
+
+    sky_uchar_t *const cq = s->cq_ring;
+    s->cq_k_head = (sky_u32_t *) (cq + p.cq_off.head);
+    s->cq_k_tail = (sky_u32_t *) (cq + p.cq_off.tail);
+    s->cq_mask = *(sky_u32_t *) (cq + p.cq_off.ring_mask);
+    s->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+    return s;
+}
+
+sky_api sky_bool_t
+sky_selector_select(sky_selector_t *const s, const sky_i32_t timeout) {
+    if (sky_unlikely(s->ev_n > 0)) {
+        return true;
+    }
+    if (s->idle_n > 0) {
+        ring_idle_arm(s);
+    }
+    if (sky_unlikely(s->pend_n > 0)) {
+        ring_pend_flush(s);
+    }
+    sky_u32_t head = *s->cq_k_head;
+    sky_u32_t tail = __atomic_load_n(s->cq_k_tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail || s->sq_submit) {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg = {
+                .sigmask = 0,
+                .sigmask_sz = _NSIG / 8,
+                .ts = 0
+        };
+        if (head != tail || s->pend_n) { // 仍有暂存请求时不阻塞，尽快再次提交
+            ts.tv_sec = 0;
+            ts.tv_nsec = 0;
+            arg.ts = (sky_u64_t) (sky_usize_t) &ts;
+        } else if (timeout >= 0) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            arg.ts = (sky_u64_t) (sky_usize_t) &ts;
+        }
+
+        const sky_i32_t n = ring_enter(
+                s->fd,
+                s->sq_submit,
+                head == tail && !s->pend_n ? 1 : 0,
+                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                &arg
+        );
+        if (n >= 0) {
+            s->sq_submit -= sky_min((sky_u32_t) n, s->sq_submit);
+        } else {
+            switch (errno) {
+                case EBADF:
+                case EINVAL:
+                case EFAULT:
+                case EOPNOTSUPP:
+                    s->ev_n = 0;
+                    return false;
+                default:
+                    break;
+            }
+        }
+        tail = __atomic_load_n(s->cq_k_tail, __ATOMIC_ACQUIRE);
+    }
+
+    const struct io_uring_cqe *cqe;
+    sky_ev_req_t *req;
+    sky_ev_t *ev;
+    sky_u32_t i = 0;
+
+    for (; head != tail && i < SKY_EVENT_MAX; ++head) {
+        cqe = &s->cqes[head & s->cq_mask];
+        if ((cqe->user_data & SKY_RING_REQ_FLAG)) {
+            req = (sky_ev_req_t *) (sky_usize_t) (cqe->user_data & ~SKY_RING_REQ_FLAG);
+            ev = req->cb(req, cqe->res);
+        } else {
+            ev = ring_poll_done(s, cqe);
+        }
+        if (!ev || (ev->status & SKY_EV_IN_INDEX)) {
+            continue;
+        }
+        ev->status = (ev->status & SKY_EV_STATUS_MASK) | SKY_EV_IN_INDEX | (i << 16);
+        s->evs[i++] = ev;
+    }
+    __atomic_store_n(s->cq_k_head, head, __ATOMIC_RELEASE);
+    s->ev_n = i;
+
+    return true;
+}
+
+sky_api void
+sky_selector_run(sky_selector_t *const s) {
+    sky_histogram_record(&s->metrics.event_hist, s->ev_n);
+    if (sky_unlikely(!s->ev_n)) {
+        return;
+    }
+
+    sky_ev_t *ev, *const *ev_ref = s->evs;
+
+    for (sky_u32_t i = s->ev_n; i > 0; ++ev_ref, --i) {
+        ev = *ev_ref;
+        if (sky_unlikely(!ev)) {
+            continue;
+        }
+        ev->status &= ~(SKY_EV_IN_INDEX | SKY_EV_INDEX_MASK);
+        ev->cb(ev);
+    }
+
+    s->ev_n = 0;
+}
+
+sky_api void
+sky_selector_destroy(sky_selector_t *const s) {
+    ring_destroy(s);
+}
+
+sky_api sky_bool_t
+sky_selector_register(sky_ev_t *const ev, const sky_u32_t flags) {
+    if (sky_unlikely(sky_ev_reg(ev) || ev->fd < 0 || !(flags & (SKY_EV_READ | SKY_EV_WRITE)))) {
+        return false;
+    }
+    sky_selector_t *const s = ev->s;
+    const sky_u32_t slot = slot_alloc(s, ev);
+    if (sky_unlikely(slot == SKY_SLOT_NONE)) {
+        sky_log_error("ev reg error: %d", ev->fd);
+        return false;
+    }
+    if (sky_unlikely(!ring_poll_add(s, slot, flags))) {
+        slot_free(s, slot);
+        return false;
+    }
+
+    ev->flags = (flags & (SKY_EV_READ | SKY_EV_WRITE)) | (slot << SKY_SLOT_SHIFT);
+    ev->status &= ~(SKY_EV_NO_REG);
+    ev->status |= SKY_EV_NO_ERR;
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_update(sky_ev_t *const ev, const sky_u32_t flags) {
+    if (sky_unlikely(!sky_ev_reg(ev) || ev->fd < 0 || !(flags & (SKY_EV_READ | SKY_EV_WRITE)))) {
+        return false;
+    }
+    const sky_u32_t events = flags & (SKY_EV_READ | SKY_EV_WRITE);
+    const sky_u32_t slot = ev->flags >> SKY_SLOT_SHIFT;
+    sky_selector_t *const s = ev->s;
+    ev_slot_t *const item = &s->slots[slot];
+
+    if (!item->armed || (ev->flags & (SKY_EV_READ | SKY_EV_WRITE)) != events) {
+        if (item->armed) {
+            ring_poll_remove(s, slot);
+            ++item->gen;
+            item->armed = false;
+        }
+        if (sky_unlikely(!ring_poll_add(s, slot, events))) {
+            return false;
+        }
+        ev->flags = events | (slot << SKY_SLOT_SHIFT);
+    }
+    ev->status |= SKY_EV_NO_ERR;
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_cancel(sky_ev_t *const ev) {
+    sky_selector_t *const s = ev->s;
+
+    if ((ev->status & SKY_EV_IN_INDEX)) { // 提交请求触发的事件未注册，同样需要移除
+        const sky_u32_t index = (ev->status & SKY_EV_INDEX_MASK) >> 16;
+        s->evs[index] = null;
+        ev->status &= ~(SKY_EV_IN_INDEX | SKY_EV_INDEX_MASK);
+    }
+    if (sky_unlikely(!sky_ev_reg(ev))) {
+        return true;
+    }
+    const sky_u32_t slot = ev->flags >> SKY_SLOT_SHIFT;
+
+    if (s->slots[slot].armed) {
+        ring_poll_remove(s, slot);
+    }
+    slot_free(s, slot);
+
+    ev->flags = 0;
+    ev->status |= SKY_EV_NO_REG;
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_recv(
+        sky_selector_t *const s,
+        sky_ev_req_t *const req,
+        const sky_socket_t fd,
+        sky_uchar_t *const buf,
+        const sky_u32_t size
+) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = (sky_u64_t) (sky_usize_t) buf;
+    sqe->len = size;
+    sqe->user_data = (sky_u64_t) (sky_usize_t) req | SKY_RING_REQ_FLAG;
+
+    ring_sqe_commit(s);
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_send(
+        sky_selector_t *const s,
+        sky_ev_req_t *const req,
+        const sky_socket_t fd,
+        const sky_uchar_t *const buf,
+        const sky_u32_t size
+) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return false;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (sky_u64_t) (sky_usize_t) buf;
+    sqe->len = size;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (sky_u64_t) (sky_usize_t) req | SKY_RING_REQ_FLAG;
+
+    ring_sqe_commit(s);
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_poll(
+        sky_selector_t *const s,
+        sky_ev_req_t *const req,
+        const sky_socket_t fd,
+        const sky_u32_t flags
+) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+#if SKY_ENDIAN == SKY_BIG_ENDIAN
+    const sky_u32_t events = ev_poll_events(flags);
+    sqe->poll32_events = (events << 16) | (events >> 16);
+#else
+    sqe->poll32_events = ev_poll_events(flags);
+#endif
+    sqe->user_data = (sky_u64_t) (sky_usize_t) req | SKY_RING_REQ_FLAG;
+
+    ring_sqe_commit(s);
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_selector_req_cancel(sky_selector_t *const s, sky_ev_req_t *const req) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (sky_u64_t) (sky_usize_t) req | SKY_RING_REQ_FLAG;
+    sqe->user_data = 0;
+
+    ring_sqe_commit(s);
+
+    return true;
+}
+
+static sky_inline sky_i32_t
+ring_setup(const sky_u32_t entries, struct io_uring_params *const p) {
+    return (sky_i32_t) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static sky_inline sky_i32_t
+ring_enter(
+        const sky_i32_t fd,
+        const sky_u32_t submit,
+        const sky_u32_t min_complete,
+        const sky_u32_t flags,
+        void *const arg
+) {
+    return (sky_i32_t) syscall(
+            __NR_io_uring_enter,
+            fd,
+            submit,
+            min_complete,
+            flags,
+            arg,
+            sizeof(struct io_uring_getevents_arg)
+    );
+}
+
+static sky_bool_t
+ring_sq_reserve(sky_selector_t *const s) {
+    if (sky_likely((s->sq_tail - __atomic_load_n(s->sq_k_head, __ATOMIC_ACQUIRE)) < s->sq_entries)) {
+        return true;
+    }
+    const sky_i32_t n = (sky_i32_t) syscall(__NR_io_uring_enter, s->fd, s->sq_submit, 0, 0, null, 0);
+    if (n > 0) {
+        s->sq_submit -= sky_min((sky_u32_t) n, s->sq_submit);
+    }
+
+    return (s->sq_tail - __atomic_load_n(s->sq_k_head, __ATOMIC_ACQUIRE)) < s->sq_entries;
+}
+
+/**
+ * 获取待填充的提交项，提交队列满(或已有暂存项，保证顺序)时取自暂存列表
+ * @return 内存不足返回null
+ */
+static struct io_uring_sqe *
+ring_get_sqe(sky_selector_t *const s) {
+    struct io_uring_sqe *sqe;
+
+    if (sky_likely(!s->pend_n && ring_sq_reserve(s))) {
+        sqe = &s->sqes[s->sq_tail & s->sq_mask];
+        s->sqe_in_ring = true;
+    } else {
+        if (s->pend_n == s->pend_cap) {
+            const sky_u32_t cap = s->pend_cap ? (s->pend_cap << 1) : SKY_U32(64);
+            struct io_uring_sqe *const pend = sky_realloc(s->pend, sizeof(struct io_uring_sqe) * cap);
+            if (sky_unlikely(!pend)) {
+                return null;
+            }
+            s->pend = pend;
+            s->pend_cap = cap;
+        }
+        sqe = &s->pend[s->pend_n];
+        s->sqe_in_ring = false;
+    }
+    sky_memzero(sqe, sizeof(struct io_uring_sqe));
+
+    return sqe;
+}
+
+static sky_inline void
+ring_sqe_commit(sky_selector_t *const s) {
+    if (!s->sqe_in_ring) {
+        ++s->pend_n;
+        return;
+    }
+    ++s->sq_tail;
+    ++s->sq_submit;
+    __atomic_store_n(s->sq_k_tail, s->sq_tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * 将暂存的提交项移入提交队列，槽位已释放或重新挂载的 poll add 直接丢弃
+ */
+static void
+ring_pend_flush(sky_selector_t *const s) {
+    const struct io_uring_sqe *item = s->pend;
+    const ev_slot_t *slot_item;
+    sky_u32_t i = 0, slot;
+
+    for (; i < s->pend_n; ++i, ++item) {
+        if (item->opcode == IORING_OP_POLL_ADD && !(item->user_data & SKY_RING_REQ_FLAG)) {
+            slot = ring_poll_slot(item->user_data);
+            slot_item = &s->slots[slot];
+            if (!slot_item->ev || slot_item->gen != (sky_u32_t) (item->user_data >> 32)) {
+                continue;
+            }
+        }
+        if (!ring_sq_reserve(s)) {
+            break;
+        }
+        sky_memcpy(&s->sqes[s->sq_tail & s->sq_mask], item, sizeof(struct io_uring_sqe));
+        ++s->sq_tail;
+        ++s->sq_submit;
+        __atomic_store_n(s->sq_k_tail, s->sq_tail, __ATOMIC_RELEASE);
+    }
+
+    s->pend_n -= i;
+    if (s->pend_n) {
+        sky_memmove(s->pend, s->pend + i, sizeof(struct io_uring_sqe) * s->pend_n);
+    }
+}
+
+static sky_bool_t
+ring_poll_add(sky_selector_t *const s, const sky_u32_t slot, const sky_u32_t flags) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return false;
+    }
+    ev_slot_t *const item = &s->slots[slot];
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = item->ev->fd;
+#if SKY_ENDIAN == SKY_BIG_ENDIAN
+    const sky_u32_t events = ev_poll_events(flags);
+    sqe->poll32_events = (events << 16) | (events >> 16);
+#else
+    sqe->poll32_events = ev_poll_events(flags);
+#endif
+    sqe->user_data = ring_poll_data(item->gen, slot);
+
+    ring_sqe_commit(s);
+    item->armed = true;
+
+    return true;
+}
+
+static void
+ring_poll_remove(sky_selector_t *const s, const sky_u32_t slot) {
+    struct io_uring_sqe *const sqe = ring_get_sqe(s);
+    if (sky_unlikely(!sqe)) {
+        sky_log_error("io_uring sqe alloc error");
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = ring_poll_data(s->slots[slot].gen, slot);
+    sqe->user_data = 0;
+
+    ring_sqe_commit(s);
+}
+
+/**
+ * 处理 poll 的完成事件
+ * @return 需要执行回调的事件，已取消或无需处理时返回null
+ */
+static sky_ev_t *
+ring_poll_done(sky_selector_t *const s, const struct io_uring_cqe *const cqe) {
+    if (!cqe->user_data) { // poll 移除与请求取消的完成事件
+        return null;
+    }
+    const sky_u32_t slot = ring_poll_slot(cqe->user_data);
+    if (slot >= s->slot_n) {
+        return null;
+    }
+    ev_slot_t *const slot_item = &s->slots[slot];
+    sky_ev_t *const ev = slot_item->ev;
+    if (!ev || slot_item->gen != (sky_u32_t) (cqe->user_data >> 32)) { // 已取消的事件
+        return null;
+    }
+    slot_item->armed = false;
+
+    if (sky_unlikely(cqe->res < 0)) {
+        if (cqe->res == -ECANCELED) {
+            ring_idle_push(s, slot);
+            return null;
+        }
+        ev->status &= ~(SKY_EV_NO_ERR | SKY_EV_READ | SKY_EV_WRITE); // 出错后不再挂载，直到重新修改注册
+        return ev;
+    }
+    const sky_u32_t events = (sky_u32_t) cqe->res;
+    if (sky_unlikely((events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0)) {
+        ev->status &= ~(SKY_EV_NO_ERR | SKY_EV_READ | SKY_EV_WRITE);
+    } else {
+        ev->status |= ((sky_u32_t) ((events & (EPOLLIN | EPOLLPRI)) != 0) << 1)
+                      | ((sky_u32_t) ((events & EPOLLOUT) != 0) << 2);
+        ring_poll_rearm(s, slot);
+    }
+
+    return ev;
+}
+
+/**
+ * 单次 poll 完成后，为尚未就绪的方向重新挂载，全部就绪时等待回调清除就绪位
+ */
+static sky_inline void
+ring_poll_rearm(sky_selector_t *const s, const sky_u32_t slot) {
+    const sky_ev_t *const ev = s->slots[slot].ev;
+    const sky_u32_t events = ev->flags & ~ev->status & (SKY_EV_READ | SKY_EV_WRITE);
+
+    if (events) {
+        ring_poll_add(s, slot, events);
+    } else {
+        ring_idle_push(s, slot);
+    }
+}
+
+static void
+ring_idle_push(sky_selector_t *const s, const sky_u32_t slot) {
+    ev_slot_t *const item = &s->slots[slot];
+    if (item->idle) {
+        return;
+    }
+    if (s->idle_n == s->idle_cap) {
+        const sky_u32_t cap = s->idle_cap ? (s->idle_cap << 1) : SKY_U32(64);
+        sky_u32_t *const idle = sky_realloc(s->idle, sizeof(sky_u32_t) * cap);
+        if (sky_unlikely(!idle)) { // 无法等待就绪位清除，直接按注册的事件挂载
+            ring_poll_add(s, slot, item->ev->flags);
+            return;
+        }
+        s->idle = idle;
+        s->idle_cap = cap;
+    }
+    s->idle[s->idle_n++] = slot;
+    item->idle = true;
+}
+
+/**
+ * 检查 idle 列表，就绪位已被清除的事件重新挂载，槽位释放后再分配时 idle 标记保持不变，列表不会重复
+ */
+static void
+ring_idle_arm(sky_selector_t *const s) {
+    ev_slot_t *item;
+    sky_u32_t i = 0, n = 0, slot, events;
+
+    for (; i < s->idle_n; ++i) {
+        slot = s->idle[i];
+        item = &s->slots[slot];
+        if (item->ev && !item->armed && !sky_ev_error(item->ev)) {
+            events = item->ev->flags & ~item->ev->status & (SKY_EV_READ | SKY_EV_WRITE);
+            if (!events || !ring_poll_add(s, slot, events)) {
+                s->idle[n++] = slot;
+                continue;
+            }
+        }
+        item->idle = false;
+    }
+    s->idle_n = n;
+}
+
+static sky_u32_t
+slot_alloc(sky_selector_t *const s, sky_ev_t *const ev) {
+    sky_u32_t slot = s->slot_free;
+
+    if (slot != SKY_SLOT_NONE) {
+        s->slot_free = s->slots[slot].next;
+    } else {
+        if (sky_unlikely(s->slot_n == SKY_SLOT_MAX)) {
+            return SKY_SLOT_NONE;
+        }
+        if (s->slot_n == s->slot_cap) {
+            const sky_u32_t cap = s->slot_cap ? sky_min(s->slot_cap << 1, SKY_SLOT_MAX) : SKY_U32(64);
+            ev_slot_t *const slots = sky_realloc(s->slots, sizeof(ev_slot_t) * cap);
+            if (sky_unlikely(!slots)) {
+                return SKY_SLOT_NONE;
+            }
+            s->slots = slots;
+            s->slot_cap = cap;
+        }
+        slot = s->slot_n++;
+        s->slots[slot].gen = 0;
+        s->slots[slot].idle = false;
+    }
+    s->slots[slot].ev = ev;
+    s->slots[slot].next = SKY_SLOT_NONE;
+    s->slots[slot].armed = false;
+
+    return slot;
+}
+
+static sky_inline void
+slot_free(sky_selector_t *const s, const sky_u32_t slot) {
+    ev_slot_t *const item = &s->slots[slot];
+
+    item->ev = null;
+    ++item->gen;
+    item->next = s->slot_free;
+    s->slot_free = slot;
+}
+
+static sky_inline sky_u32_t
+ev_poll_events(const sky_u32_t flags) {
+    sky_u32_t events = EPOLLHUP | EPOLLERR;
+    if ((flags & SKY_EV_READ) != 0) {
+        events |= EPOLLIN | EPOLLPRI | EPOLLRDHUP;
+    }
+    if ((flags & SKY_EV_WRITE) != 0) {
+        events |= EPOLLOUT;
+    }
+
+    return events;
+}
+
+static void
+ring_destroy(sky_selector_t *const s) {
+    if (s->sqes) {
+        munmap(s->sqes, s->sqes_size);
+    }
+    if (s->cq_ring != s->sq_ring) {
+        munmap(s->cq_ring, s->cq_ring_size);
+    }
+    munmap(s->sq_ring, s->sq_ring_size);
+    close(s->fd);
+    s->fd = -1;
+
+    if (s->slots) {
+        sky_free(s->slots);
+    }
+    if (s->pend) {
+        sky_free(s->pend);
+    }
+    if (s->idle) {
+        sky_free(s->idle);
+    }
+    sky_free(s);
+}
+
+static sky_i32_t
+setup_open_file_count_limits() {
+    struct rlimit r;
+
+    if (getrlimit(RLIMIT_NOFILE, &r) < 0) {
+        sky_log_error("Could not obtain maximum number of file descriptors. Assuming %d", OPEN_MAX);
+        return OPEN_MAX;
+    }
+
+    if (r.rlim_max != r.rlim_cur) {
+        const rlim_t current = r.rlim_cur;
+
+        if (r.rlim_max == RLIM_INFINITY) {
+            r.rlim_cur = OPEN_MAX;
+        } else if (r.rlim_cur < r.rlim_max) {
+            r.rlim_cur = r.rlim_max;
+        } else {
+            /* Shouldn't happen, so just return the current value. */
+            return (sky_i32_t) r.rlim_cur;
+        }
+
+        if (setrlimit(RLIMIT_NOFILE, &r) < 0) {
+            sky_log_error("Could not raise maximum number of file descriptors to %lu. Leaving at %lu", r.rlim_max,
+                          current);
+            r.rlim_cur = current;
+        }
+    }
+    return (sky_i32_t) r.rlim_cur;
+}
+
+#endif
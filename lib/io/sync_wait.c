@@ -14,6 +14,16 @@ struct sky_sync_wait_s {
 
 static sky_usize_t coro_process(sky_coro_t *coro, void *data);
 
+static void offload_done(sky_event_loop_t *loop, void *data);
+
+typedef struct {
+    sky_sync_wait_t *wait;
+    sky_thread_pool_pt fn;
+    void *arg;
+} offload_task_t;
+
+static void offload_work(void *data);
+
 
 sky_api sky_bool_t
 sky_sync_wait_create(const sky_sync_wait_pt cb, void *const data) {
@@ -86,6 +96,30 @@ sky_sync_wait_yield(sky_sync_wait_t *const wait) {
     return wait->att_data;
 }
 
+sky_api sky_bool_t
+sky_sync_wait_offload(
+        sky_sync_wait_t *const wait,
+        sky_thread_pool_t *const pool,
+        sky_event_loop_t *const loop,
+        const sky_thread_pool_pt fn,
+        void *const arg
+) {
+    offload_task_t task = { // 协程让出期间栈上数据一直有效
+            .wait = wait,
+            .fn = fn,
+            .arg = arg
+    };
+
+    sky_sync_wait_yield_before(wait);
+    if (sky_unlikely(!sky_thread_pool_submit(pool, offload_work, &task, loop, offload_done))) {
+        wait->wait = false;
+        return false;
+    }
+    sky_sync_wait_yield(wait);
+
+    return true;
+}
+
 static sky_usize_t
 coro_process(sky_coro_t *const coro, void *const data) {
     (void) coro;
@@ -95,4 +129,20 @@ coro_process(sky_coro_t *const coro, void *const data) {
     wait->call(wait, wait->data);
 
     return SKY_CORO_FINISHED;
-}
\ No newline at end of file
+}
+
+static void
+offload_work(void *const data) {
+    const offload_task_t *const task = data;
+
+    task->fn(task->arg);
+}
+
+static void
+offload_done(sky_event_loop_t *const loop, void *const data) {
+    (void) loop;
+
+    const offload_task_t *const task = data;
+
+    sky_sync_wait_resume(task->wait, null);
+}
@@ -30,11 +30,88 @@ static sky_bool_t set_socket_nonblock(sky_socket_t fd);
 
 #endif
 
+static sky_isize_t tcp_sendfile(
+        sky_tcp_t *tcp,
+        sky_fs_t *fs,
+        sky_i64_t *offset,
+        sky_usize_t size,
+        const sky_uchar_t *head,
+        sky_usize_t head_size
+);
+
+#define tcp_metrics(_tcp) sky_selector_metrics((_tcp)->ev.s)
+
+#ifdef SKY_HAVE_IO_URING
+
+#include <core/memory.h>
+
+#define TCP_RING_IN_SIZE    SKY_U32(4096)
+#define TCP_RING_OUT_SIZE   SKY_U32(16384)
+
+#define TCP_RING_IN         SKY_U32(0x01) // 接收未完成
+#define TCP_RING_OUT        SKY_U32(0x02) // 发送未完成
+#define TCP_RING_POLL       SKY_U32(0x04) // 等待可写，用于直接 sendfile
+#define TCP_RING_WAIT       SKY_U32(0x08) // 写入未被全部接受，发送完成后需要回调
+#define TCP_RING_ERR        SKY_U32(0x10)
+#define TCP_RING_BUSY       (TCP_RING_IN | TCP_RING_OUT | TCP_RING_POLL)
+
+/**
+ * 提交模式的收发上下文，接收到 in_buf 后拷贝给调用方；写入拷贝到 out_buf 后提交发送，
+ * out_buf[out_sent, out_len) 为待发送数据。文件在发送缓冲清空后直接 sendfile，不可写时提交 poll 等待，等待期间不接受写入
+ */
+struct sky_tcp_ring_s {
+    sky_ev_req_t in_req;
+    sky_ev_req_t out_req;
+    sky_ev_req_t poll_req;
+    sky_tcp_t *tcp; // 关闭后为null，未完成的请求结束后释放
+    sky_selector_t *s;
+    sky_socket_t fd;
+    sky_u32_t flags;
+    sky_u32_t in_pos;
+    sky_u32_t in_len;
+    sky_u32_t out_sent;
+    sky_u32_t out_len;
+    sky_uchar_t in_buf[TCP_RING_IN_SIZE];
+    sky_uchar_t out_buf[TCP_RING_OUT_SIZE];
+};
+
+static sky_isize_t tcp_ring_read(sky_tcp_t *tcp, sky_io_vec_t *vec, sky_u32_t num);
+
+static sky_isize_t tcp_ring_write(sky_tcp_t *tcp, const sky_io_vec_t *vec, sky_u32_t num);
+
+static sky_isize_t tcp_ring_sendfile(
+        sky_tcp_t *tcp,
+        sky_fs_t *fs,
+        sky_i64_t *offset,
+        sky_usize_t size,
+        const sky_uchar_t *head,
+        sky_usize_t head_size
+);
+
+static sky_u32_t tcp_ring_out_space(sky_tcp_ring_t *ring);
+
+static sky_bool_t tcp_ring_send(sky_tcp_ring_t *ring);
+
+static sky_ev_t *tcp_ring_in_cb(sky_ev_req_t *req, sky_i32_t result);
+
+static sky_ev_t *tcp_ring_out_cb(sky_ev_req_t *req, sky_i32_t result);
+
+static sky_ev_t *tcp_ring_poll_cb(sky_ev_req_t *req, sky_i32_t result);
+
+static sky_ev_t *tcp_ring_out_done(sky_tcp_ring_t *ring);
+
+static void tcp_ring_close(sky_tcp_ring_t *ring);
+
+#endif
+
 
 sky_api void
 sky_tcp_init(sky_tcp_t *const tcp, sky_selector_t *const s) {
     sky_ev_init(&tcp->ev, s, null, SKY_SOCKET_FD_NONE);
     tcp->status = SKY_U32(0);
+#ifdef SKY_HAVE_IO_URING
+    tcp->ring = null;
+#endif
 }
 
 sky_api sky_bool_t
@@ -95,6 +172,7 @@ sky_tcp_accept(sky_tcp_t *const server, sky_tcp_t *const client) {
             case EPROTO:
             case EINTR:
             case EMFILE: //文件数大多时，保证不中断
+                sky_ev_clean_read(&server->ev);
                 return 0;
             default:
                 sky_ev_set_error(&server->ev);
@@ -111,6 +189,7 @@ sky_tcp_accept(sky_tcp_t *const server, sky_tcp_t *const client) {
             case EPROTO:
             case EINTR:
             case EMFILE: //文件数大多时，保证不中断
+                sky_ev_clean_read(&server->ev);
                 return 0;
             default:
                 sky_ev_set_error(&server->ev);
@@ -128,6 +207,10 @@ sky_tcp_accept(sky_tcp_t *const server, sky_tcp_t *const client) {
     sky_ev_rebind(&client->ev, fd);
     client->status |= SKY_TCP_STATUS_OPEN | SKY_TCP_STATUS_CONNECT;
 
+    sky_selector_metrics_t *const metrics = tcp_metrics(client);
+    sky_metrics_add(metrics->accept_n, 1);
+    sky_metrics_add(metrics->conn_active, 1);
+
     return 1;
 }
 
@@ -143,10 +226,15 @@ sky_tcp_connect(sky_tcp_t *const tcp, const sky_inet_address_t *const address) {
         return 0;
     }
 
+    if (sky_unlikely(sky_tcp_is_connect(tcp))) {
+        return 1;
+    }
+
     if (connect(fd, (const struct sockaddr *) address, sky_inet_address_size(address)) < 0) {
         switch (errno) {
             case EALREADY:
             case EINPROGRESS:
+                sky_ev_clean_write(&tcp->ev);
                 return 0;
             case EISCONN:
                 break;
@@ -158,6 +246,10 @@ sky_tcp_connect(sky_tcp_t *const tcp, const sky_inet_address_t *const address) {
 
     tcp->status |= SKY_TCP_STATUS_CONNECT;
 
+    sky_selector_metrics_t *const metrics = tcp_metrics(tcp);
+    sky_metrics_add(metrics->connect_n, 1);
+    sky_metrics_add(metrics->conn_active, 1);
+
     return 1;
 }
 
@@ -168,8 +260,19 @@ sky_tcp_close(sky_tcp_t *const tcp) {
     if (!sky_tcp_is_open(tcp)) {
         return;
     }
+    if (sky_tcp_is_connect(tcp)) {
+        sky_metrics_add(tcp_metrics(tcp)->conn_active, -1);
+    }
     tcp->ev.fd = SKY_SOCKET_FD_NONE;
     tcp->status = SKY_U32(0);
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) { // 未发送完的数据继续发送，完成后关闭句柄
+        tcp_ring_close(tcp->ring);
+        tcp->ring = null;
+        sky_tcp_register_cancel(tcp);
+        return;
+    }
+#endif
     shutdown(fd, SHUT_RDWR);
     close(fd);
     sky_tcp_register_cancel(tcp);
@@ -180,6 +283,15 @@ sky_tcp_read(sky_tcp_t *const tcp, sky_uchar_t *const data, const sky_usize_t si
     if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
         return -1;
     }
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        sky_io_vec_t vec = {
+                .buf = data,
+                .size = size
+        };
+        return tcp_ring_read(tcp, &vec, 1);
+    }
+#endif
 
     if (sky_unlikely(!size || !sky_ev_readable(&tcp->ev))) {
         return 0;
@@ -190,9 +302,10 @@ sky_tcp_read(sky_tcp_t *const tcp, sky_uchar_t *const data, const sky_usize_t si
         if ((sky_usize_t) n < size) {
             sky_ev_clean_read(&tcp->ev);
         }
+        sky_metrics_add(tcp_metrics(tcp)->read_bytes, n);
         return n;
     }
-    if (sky_likely(errno == EAGAIN)) {
+    if (sky_likely(n < 0 && errno == EAGAIN)) { // 返回0为对端关闭，此时errno无意义
         sky_ev_clean_read(&tcp->ev);
         return 0;
     }
@@ -206,6 +319,11 @@ sky_tcp_read_vec(sky_tcp_t *const tcp, sky_io_vec_t *const vec, const sky_u32_t
     if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
         return -1;
     }
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        return tcp_ring_read(tcp, vec, num);
+    }
+#endif
 
     if (sky_unlikely(!num || !sky_ev_readable(&tcp->ev))) {
         return 0;
@@ -238,9 +356,10 @@ sky_tcp_read_vec(sky_tcp_t *const tcp, sky_io_vec_t *const vec, const sky_u32_t
         if ((sky_usize_t) n < size) {
             sky_ev_clean_read(&tcp->ev);
         }
+        sky_metrics_add(tcp_metrics(tcp)->read_bytes, n);
         return n;
     }
-    if (sky_likely(errno == EAGAIN)) {
+    if (sky_likely(n < 0 && errno == EAGAIN)) { // 返回0为对端关闭，此时errno无意义
         sky_ev_clean_read(&tcp->ev);
         return 0;
     }
@@ -254,6 +373,15 @@ sky_tcp_write(sky_tcp_t *const tcp, const sky_uchar_t *const data, const sky_usi
     if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
         return -1;
     }
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        const sky_io_vec_t vec = {
+                .buf = (sky_uchar_t *) data,
+                .size = size
+        };
+        return tcp_ring_write(tcp, &vec, 1);
+    }
+#endif
 
     if (sky_unlikely(!size || !sky_ev_writable(&tcp->ev))) {
         return 0;
@@ -264,6 +392,7 @@ sky_tcp_write(sky_tcp_t *const tcp, const sky_uchar_t *const data, const sky_usi
         if ((sky_usize_t) n < size) {
             sky_ev_clean_write(&tcp->ev);
         }
+        sky_metrics_add(tcp_metrics(tcp)->write_bytes, n);
         return n;
     }
     if (sky_likely(errno == EAGAIN)) {
@@ -280,6 +409,11 @@ sky_tcp_write_vec(sky_tcp_t *tcp, const sky_io_vec_t *vec, sky_u32_t num) {
     if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
         return -1;
     }
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        return tcp_ring_write(tcp, vec, num);
+    }
+#endif
     if (sky_unlikely(!num || !sky_ev_writable(&tcp->ev))) {
         return 0;
     }
@@ -311,6 +445,7 @@ sky_tcp_write_vec(sky_tcp_t *tcp, const sky_io_vec_t *vec, sky_u32_t num) {
         if ((sky_usize_t) n < size) {
             sky_ev_clean_write(&tcp->ev);
         }
+        sky_metrics_add(tcp_metrics(tcp)->write_bytes, n);
         return n;
     }
     if (sky_likely(errno == EAGAIN)) {
@@ -330,6 +465,28 @@ sky_tcp_sendfile(
         const sky_usize_t size,
         const sky_uchar_t *const head,
         const sky_usize_t head_size
+) {
+#ifdef SKY_HAVE_IO_URING
+    if (tcp->ring) {
+        return tcp_ring_sendfile(tcp, fs, offset, size, head, head_size);
+    }
+#endif
+    const sky_isize_t n = tcp_sendfile(tcp, fs, offset, size, head, head_size);
+    if (n > 0) {
+        sky_metrics_add(tcp_metrics(tcp)->write_bytes, n);
+    }
+
+    return n;
+}
+
+static sky_isize_t
+tcp_sendfile(
+        sky_tcp_t *const tcp,
+        sky_fs_t *const fs,
+        sky_i64_t *const offset,
+        const sky_usize_t size,
+        const sky_uchar_t *const head,
+        const sky_usize_t head_size
 ) {
     if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
         return -1;
@@ -548,6 +705,38 @@ sky_tcp_sendfile(
 #endif
 }
 
+sky_api sky_bool_t
+sky_tcp_ring_enable(sky_tcp_t *const tcp) {
+#ifdef SKY_HAVE_IO_URING
+    if (sky_unlikely(!sky_tcp_is_connect(tcp) || tcp->ring)) {
+        return tcp->ring != null;
+    }
+    sky_tcp_ring_t *const ring = sky_malloc(sizeof(sky_tcp_ring_t));
+    if (sky_unlikely(!ring)) {
+        return false;
+    }
+    ring->in_req.cb = tcp_ring_in_cb;
+    ring->out_req.cb = tcp_ring_out_cb;
+    ring->poll_req.cb = tcp_ring_poll_cb;
+    ring->tcp = tcp;
+    ring->s = tcp->ev.s;
+    ring->fd = sky_ev_get_fd(&tcp->ev);
+    ring->flags = 0;
+    ring->in_pos = 0;
+    ring->in_len = 0;
+    ring->out_sent = 0;
+    ring->out_len = 0;
+
+    sky_tcp_register_cancel(tcp);
+    tcp->ring = ring;
+
+    return true;
+#else
+    (void) tcp;
+    return false;
+#endif
+}
+
 sky_api sky_bool_t
 sky_tcp_option_reuse_addr(const sky_tcp_t *const tcp) {
     const sky_socket_t fd = sky_ev_get_fd(&tcp->ev);
@@ -626,6 +815,243 @@ sky_tcp_option_no_push(const sky_tcp_t *const tcp, const sky_bool_t open) {
 }
 
 
+#ifdef SKY_HAVE_IO_URING
+
+/**
+ * 从接收缓冲拷贝，缓冲为空时提交接收并返回0，接收完成后触发回调
+ */
+static sky_isize_t
+tcp_ring_read(sky_tcp_t *const tcp, sky_io_vec_t *const vec, const sky_u32_t num) {
+    sky_tcp_ring_t *const ring = tcp->ring;
+
+    if (ring->in_pos == ring->in_len) {
+        if (!(ring->flags & TCP_RING_IN)) {
+            if (sky_unlikely(!sky_selector_recv(ring->s, &ring->in_req, ring->fd, ring->in_buf, TCP_RING_IN_SIZE))) {
+                sky_ev_set_error(&tcp->ev);
+                return -1;
+            }
+            ring->flags |= TCP_RING_IN;
+        }
+        return 0;
+    }
+    sky_usize_t n = 0, size;
+
+    for (sky_u32_t i = 0; i < num && ring->in_pos < ring->in_len; ++i) {
+        size = sky_min(vec[i].size, (sky_usize_t) (ring->in_len - ring->in_pos));
+        sky_memcpy(vec[i].buf, ring->in_buf + ring->in_pos, size);
+        ring->in_pos += (sky_u32_t) size;
+        n += size;
+    }
+    if (n) {
+        sky_metrics_add(tcp_metrics(tcp)->read_bytes, n);
+    }
+
+    return (sky_isize_t) n;
+}
+
+/**
+ * 拷贝到发送缓冲并提交发送，缓冲已满时返回0，发送完成后触发回调
+ */
+static sky_isize_t
+tcp_ring_write(sky_tcp_t *const tcp, const sky_io_vec_t *const vec, const sky_u32_t num) {
+    sky_tcp_ring_t *const ring = tcp->ring;
+    sky_u32_t space = tcp_ring_out_space(ring), size;
+    sky_usize_t n = 0;
+
+    for (sky_u32_t i = 0; i < num; ++i) {
+        size = (sky_u32_t) sky_min(vec[i].size, (sky_usize_t) space);
+        sky_memcpy(ring->out_buf + ring->out_len, vec[i].buf, size);
+        ring->out_len += size;
+        space -= size;
+        n += size;
+
+        if (size < vec[i].size) {
+            ring->flags |= TCP_RING_WAIT;
+            break;
+        }
+    }
+    if (sky_unlikely(!tcp_ring_send(ring))) {
+        sky_ev_set_error(&tcp->ev);
+        return -1;
+    }
+
+    return (sky_isize_t) n;
+}
+
+/**
+ * 发送缓冲清空后与就绪模式相同直接 sendfile，保留零拷贝；未全部发送时提交 poll，可写后触发回调
+ */
+static sky_isize_t
+tcp_ring_sendfile(
+        sky_tcp_t *const tcp,
+        sky_fs_t *const fs,
+        sky_i64_t *const offset,
+        const sky_usize_t size,
+        const sky_uchar_t *const head,
+        const sky_usize_t head_size
+) {
+    if (sky_unlikely(sky_ev_error(&tcp->ev) || !sky_tcp_is_connect(tcp))) {
+        return -1;
+    }
+    sky_tcp_ring_t *const ring = tcp->ring;
+
+    if ((ring->flags & (TCP_RING_OUT | TCP_RING_POLL)) || ring->out_sent != ring->out_len) {
+        ring->flags |= TCP_RING_WAIT; // 先发送缓冲中的数据，保证顺序
+        return 0;
+    }
+    tcp->ev.status |= SKY_EV_WRITE;
+
+    const sky_isize_t n = tcp_sendfile(tcp, fs, offset, size, head, head_size);
+    if (n > 0) {
+        sky_metrics_add(tcp_metrics(tcp)->write_bytes, n);
+    }
+    if (n >= 0 && !sky_ev_writable(&tcp->ev)) {
+        if (sky_unlikely(!sky_selector_poll(ring->s, &ring->poll_req, ring->fd, SKY_EV_WRITE))) {
+            sky_ev_set_error(&tcp->ev);
+            return -1;
+        }
+        ring->flags |= TCP_RING_POLL | TCP_RING_WAIT;
+    }
+
+    return n;
+}
+
+/**
+ * 发送缓冲剩余空间，没有未完成的请求时将待发送数据移至缓冲头部；等待 sendfile 可写期间不接受写入
+ */
+static sky_u32_t
+tcp_ring_out_space(sky_tcp_ring_t *const ring) {
+    if ((ring->flags & TCP_RING_POLL)) {
+        return 0;
+    }
+    if (ring->out_sent && !(ring->flags & TCP_RING_OUT)) {
+        ring->out_len -= ring->out_sent;
+        if (ring->out_len) {
+            sky_memmove(ring->out_buf, ring->out_buf + ring->out_sent, ring->out_len);
+        }
+        ring->out_sent = 0;
+    }
+
+    return TCP_RING_OUT_SIZE - ring->out_len;
+}
+
+static sky_bool_t
+tcp_ring_send(sky_tcp_ring_t *const ring) {
+    if ((ring->flags & (TCP_RING_OUT | TCP_RING_ERR)) || ring->out_sent == ring->out_len) {
+        return !(ring->flags & TCP_RING_ERR);
+    }
+    if (sky_unlikely(!sky_selector_send(
+            ring->s,
+            &ring->out_req,
+            ring->fd,
+            ring->out_buf + ring->out_sent,
+            ring->out_len - ring->out_sent
+    ))) {
+        ring->flags |= TCP_RING_ERR;
+        return false;
+    }
+    ring->flags |= TCP_RING_OUT;
+
+    return true;
+}
+
+static sky_ev_t *
+tcp_ring_in_cb(sky_ev_req_t *const req, const sky_i32_t result) {
+    sky_tcp_ring_t *const ring = sky_type_convert(req, sky_tcp_ring_t, in_req);
+
+    ring->flags &= ~TCP_RING_IN;
+    if (!ring->tcp) {
+        return tcp_ring_out_done(ring);
+    }
+    if (sky_likely(result > 0)) {
+        ring->in_pos = 0;
+        ring->in_len = (sky_u32_t) result;
+    } else if (result != -EAGAIN && result != -EINTR) { // 返回0为对端关闭
+        sky_ev_set_error(&ring->tcp->ev);
+    }
+
+    return &ring->tcp->ev;
+}
+
+static sky_ev_t *
+tcp_ring_out_cb(sky_ev_req_t *const req, const sky_i32_t result) {
+    sky_tcp_ring_t *const ring = sky_type_convert(req, sky_tcp_ring_t, out_req);
+
+    ring->flags &= ~TCP_RING_OUT;
+    if (sky_likely(result > 0)) {
+        ring->out_sent += (sky_u32_t) result;
+        sky_metrics_add(sky_selector_metrics(ring->s)->write_bytes, result);
+        if (ring->out_sent == ring->out_len) {
+            ring->out_sent = 0;
+            ring->out_len = 0;
+        } else {
+            tcp_ring_send(ring);
+        }
+    } else if (result == -EAGAIN || result == -EINTR) {
+        tcp_ring_send(ring);
+    } else {
+        ring->flags |= TCP_RING_ERR;
+    }
+
+    return tcp_ring_out_done(ring);
+}
+
+static sky_ev_t *
+tcp_ring_poll_cb(sky_ev_req_t *const req, const sky_i32_t result) {
+    sky_tcp_ring_t *const ring = sky_type_convert(req, sky_tcp_ring_t, poll_req);
+
+    ring->flags &= ~TCP_RING_POLL;
+    if (sky_unlikely(result < 0 && result != -ECANCELED)) {
+        ring->flags |= TCP_RING_ERR;
+    } // 出错或挂断时由下一次 sendfile 返回错误
+
+    return tcp_ring_out_done(ring);
+}
+
+/**
+ * 发送与等待可写完成后的处理，已关闭时在没有未完成的请求后关闭句柄并释放
+ */
+static sky_ev_t *
+tcp_ring_out_done(sky_tcp_ring_t *const ring) {
+    sky_tcp_t *const tcp = ring->tcp;
+
+    if (!tcp) {
+        if (!(ring->flags & TCP_RING_BUSY)) {
+            shutdown(ring->fd, SHUT_RDWR);
+            close(ring->fd);
+            sky_free(ring);
+        }
+        return null;
+    }
+    if (sky_unlikely((ring->flags & TCP_RING_ERR))) {
+        sky_ev_set_error(&tcp->ev);
+        return &tcp->ev;
+    }
+    if ((ring->flags & TCP_RING_WAIT)) {
+        ring->flags &= ~TCP_RING_WAIT;
+        return &tcp->ev;
+    }
+
+    return null;
+}
+
+static void
+tcp_ring_close(sky_tcp_ring_t *const ring) {
+    ring->tcp = null;
+    if ((ring->flags & (TCP_RING_IN | TCP_RING_POLL))) {
+        if ((ring->flags & TCP_RING_IN)) {
+            sky_selector_req_cancel(ring->s, &ring->in_req);
+        }
+        if ((ring->flags & TCP_RING_POLL)) {
+            sky_selector_req_cancel(ring->s, &ring->poll_req);
+        }
+        return;
+    }
+    tcp_ring_out_done(ring);
+}
+
+#endif
+
 #ifndef SKY_HAVE_ACCEPT4
 
 static sky_bool_t
@@ -0,0 +1,146 @@
+//
+// Created by beliefsky on 2023/11/5.
+//
+#include <io/thread_pool.h>
+#include <core/memory.h>
+#include <core/log.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    sky_thread_pool_pt work;
+    void *data;
+    sky_event_loop_t *loop;
+    sky_event_loop_post_pt done;
+} thread_pool_task_t;
+
+struct sky_thread_pool_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t *threads;
+    thread_pool_task_t *tasks;
+    sky_u32_t head;
+    sky_u32_t size;
+    sky_u32_t queue_size;
+    sky_u32_t thread_n;
+    sky_bool_t closed;
+};
+
+static void *thread_pool_run(void *data);
+
+sky_api sky_thread_pool_t *
+sky_thread_pool_create(sky_u32_t thread_n, sky_u32_t queue_size) {
+    if (!thread_n) {
+        const sky_i64_t cpu_n = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_n = cpu_n > 0 ? (sky_u32_t) cpu_n : 1;
+    }
+    if (!queue_size) {
+        queue_size = 1024;
+    }
+
+    sky_thread_pool_t *const pool = sky_malloc(
+            sizeof(sky_thread_pool_t)
+            + sizeof(pthread_t) * thread_n
+            + sizeof(thread_pool_task_t) * queue_size
+    );
+    if (sky_unlikely(!pool)) {
+        return null;
+    }
+    pthread_mutex_init(&pool->lock, null);
+    pthread_cond_init(&pool->cond, null);
+    pool->threads = (pthread_t *) (pool + 1);
+    pool->tasks = (thread_pool_task_t *) (pool->threads + thread_n);
+    pool->head = 0;
+    pool->size = 0;
+    pool->queue_size = queue_size;
+    pool->thread_n = 0;
+    pool->closed = false;
+
+    for (sky_u32_t i = 0; i < thread_n; ++i) {
+        if (sky_unlikely(pthread_create(pool->threads + i, null, thread_pool_run, pool) != 0)) {
+            sky_log_error("thread pool create error: %u", i);
+            break;
+        }
+        ++pool->thread_n;
+    }
+    if (sky_unlikely(!pool->thread_n)) {
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->lock);
+        sky_free(pool);
+        return null;
+    }
+
+    return pool;
+}
+
+sky_api sky_bool_t
+sky_thread_pool_submit(
+        sky_thread_pool_t *const pool,
+        const sky_thread_pool_pt work,
+        void *const data,
+        sky_event_loop_t *const loop,
+        const sky_event_loop_post_pt done
+) {
+    pthread_mutex_lock(&pool->lock);
+    if (sky_unlikely(pool->closed || pool->size == pool->queue_size)) {
+        pthread_mutex_unlock(&pool->lock);
+        return false;
+    }
+    thread_pool_task_t *const task = pool->tasks + ((pool->head + pool->size) % pool->queue_size);
+    task->work = work;
+    task->data = data;
+    task->loop = loop;
+    task->done = done;
+    ++pool->size;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    return true;
+}
+
+sky_api void
+sky_thread_pool_destroy(sky_thread_pool_t *const pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->closed = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (sky_u32_t i = 0; i < pool->thread_n; ++i) {
+        pthread_join(pool->threads[i], null);
+    }
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    sky_free(pool);
+}
+
+static void *
+thread_pool_run(void *const data) {
+    sky_thread_pool_t *const pool = data;
+    thread_pool_task_t task;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->size && !pool->closed) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if (!pool->size) { // 已关闭且任务已执行完
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        task = pool->tasks[pool->head];
+        pool->head = (pool->head + 1) % pool->queue_size;
+        --pool->size;
+        pthread_mutex_unlock(&pool->lock);
+
+        task.work(task.data);
+
+        if (task.loop && task.done) {
+            while (sky_unlikely(!sky_event_loop_post(task.loop, task.done, task.data))) {
+                sky_log_error("thread pool post done error");
+                usleep(1000);
+            }
+        }
+    }
+
+    return null;
+}
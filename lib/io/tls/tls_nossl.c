@@ -61,6 +61,34 @@ sky_tls_write(sky_tls_t *const tls, const sky_uchar_t *const data, const sky_usi
     return -1;
 }
 
+sky_api sky_isize_t
+sky_tls_write_vec(sky_tls_t *const tls, const sky_io_vec_t *const vec, const sky_u32_t num) {
+    (void) tls;
+    (void) vec;
+    (void) num;
+
+    return -1;
+}
+
+sky_api sky_isize_t
+sky_tls_sendfile(
+        sky_tls_t *const tls,
+        sky_fs_t *const fs,
+        sky_i64_t *const offset,
+        const sky_usize_t size,
+        const sky_uchar_t *const head,
+        const sky_usize_t head_size
+) {
+    (void) tls;
+    (void) fs;
+    (void) offset;
+    (void) size;
+    (void) head;
+    (void) head_size;
+
+    return -1;
+}
+
 sky_api sky_i8_t
 sky_tls_shutdown(sky_tls_t *const tls) {
     (void) tls;
@@ -79,5 +107,40 @@ sky_tls_set_sni_hostname(sky_tls_t *const tls, const sky_str_t *const hostname)
     (void) hostname;
 }
 
+sky_api sky_bool_t
+sky_tls_get_alpn(const sky_tls_t *const tls, sky_str_t *const out) {
+    (void) tls;
+    sky_str_null(out);
+
+    return false;
+}
+
+sky_api sky_bool_t
+sky_tls_session_reused(const sky_tls_t *const tls) {
+    (void) tls;
+
+    return false;
+}
+
+sky_api sky_bool_t
+sky_tls_set_session(sky_tls_t *const tls, sky_tls_session_t *const session) {
+    (void) tls;
+    (void) session;
+
+    return false;
+}
+
+sky_api void
+sky_tls_session_free(sky_tls_session_t *const session) {
+    (void) session;
+}
+
+sky_api sky_bool_t
+sky_tls_ktls_send(const sky_tls_t *const tls) {
+    (void) tls;
+
+    return false;
+}
+
 #endif
 
@@ -7,6 +7,31 @@
 
 #include "openssl/ssl.h"
 #include "openssl/err.h"
+#include <core/memory.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define TLS_RECORD_SIZE 16384
+
+static sky_bool_t tls_alpn_init(sky_tls_ctx_t *ctx, SSL_CTX *ssl_ctx, const sky_tls_ctx_conf_t *conf);
+
+static sky_i32_t tls_alpn_select(
+        SSL *ssl,
+        const sky_uchar_t **out,
+        sky_uchar_t *out_len,
+        const sky_uchar_t *in,
+        sky_u32_t in_len,
+        void *arg
+);
+
+static void tls_session_init(sky_tls_ctx_t *ctx, SSL_CTX *ssl_ctx, const sky_tls_ctx_conf_t *conf);
+
+static sky_i32_t tls_session_new(SSL *ssl, SSL_SESSION *session);
+
+/**
+ * 合并小块写入与文件加密发送共用，避免占用调用方(可能是协程)的栈
+ */
+static sky_thread sky_uchar_t tls_write_buf[TLS_RECORD_SIZE];
 
 sky_api sky_bool_t
 sky_tls_ctx_init(sky_tls_ctx_t *const ctx, const sky_tls_ctx_conf_t *const conf) {
@@ -24,6 +49,10 @@ sky_tls_ctx_init(sky_tls_ctx_t *const ctx, const sky_tls_ctx_conf_t *const conf)
 
     sky_i32_t verify_mode = SSL_VERIFY_NONE;
 
+    ctx->alpn = null;
+    ctx->alpn_len = 0;
+    ctx->session_cb = null;
+
     SSL_CTX *ssl_ctx;
     if (!conf) {
         ssl_ctx = SSL_CTX_new(SSLv23_method());
@@ -82,6 +111,10 @@ sky_tls_ctx_init(sky_tls_ctx_t *const ctx, const sky_tls_ctx_conf_t *const conf)
                 goto error;
             }
         }
+        if (conf->alpn_n && !tls_alpn_init(ctx, ssl_ctx, conf)) {
+            goto error;
+        }
+        tls_session_init(ctx, ssl_ctx, conf);
     }
 
     sky_isize_t mode = SSL_CTX_get_mode(ssl_ctx);
@@ -102,6 +135,11 @@ sky_tls_ctx_init(sky_tls_ctx_t *const ctx, const sky_tls_ctx_conf_t *const conf)
 
     error:
     SSL_CTX_free(ssl_ctx);
+    if (ctx->alpn) {
+        sky_free(ctx->alpn);
+        ctx->alpn = null;
+        ctx->alpn_len = 0;
+    }
 
     return false;
 }
@@ -110,6 +148,11 @@ sky_api void
 sky_tls_ctx_destroy(sky_tls_ctx_t *const ctx) {
     SSL_CTX_free(ctx->ctx);
     ctx->ctx = null;
+    if (ctx->alpn) {
+        sky_free(ctx->alpn);
+        ctx->alpn = null;
+        ctx->alpn_len = 0;
+    }
 }
 
 sky_api sky_bool_t
@@ -120,6 +163,7 @@ sky_tls_init(sky_tls_ctx_t *const ctx, sky_tls_t *const tls, sky_tcp_t *const tc
         return false;
     }
     SSL_set_fd(ssl, sky_tcp_fd(tcp));
+    SSL_set_app_data(ssl, tls);
     tls->ssl = ssl;
     tls->tcp = tcp;
 
@@ -191,18 +235,27 @@ sky_tls_read(sky_tls_t *const tls, sky_uchar_t *const data, const sky_usize_t si
     sky_usize_t read_n;
     const sky_i32_t n = SSL_read_ex(tls->ssl, data, size, &read_n);
     if (n > 0) {
+        sky_metrics_add(sky_selector_metrics(tls->tcp->ev.s)->read_bytes, read_n);
         return (sky_isize_t) read_n;
     }
 #else
     const sky_i32_t max_read = sky_unlikely(size > SKY_I32_MAX) ? SKY_I32_MAX : (sky_i32_t) size;
     const sky_i32_t n = SSL_read(tls->ssl, data, max_read);
     if (n > 0) {
+        sky_metrics_add(sky_selector_metrics(tls->tcp->ev.s)->read_bytes, n);
         return n;
     }
 #endif
-    if (SSL_get_error(tls->ssl, n) == SSL_ERROR_WANT_READ) {
-        sky_ev_clean_read(sky_tcp_ev(tls->tcp));
-        return 0;
+    switch (SSL_get_error(tls->ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+            sky_ev_clean_read(sky_tcp_ev(tls->tcp));
+            return 0;
+        case SSL_ERROR_ZERO_RETURN:
+            // 对端正常关闭，回复 close_notify，未发送关闭通知的会话释放时会从缓存中移除
+            SSL_shutdown(tls->ssl);
+            break;
+        default:
+            break;
     }
     sky_ev_set_error(sky_tcp_ev(tls->tcp));
 
@@ -221,12 +274,14 @@ sky_tls_write(sky_tls_t *const tls, const sky_uchar_t *const data, const sky_usi
     sky_usize_t write_n;
     const sky_i32_t n = SSL_write_ex(tls->ssl, data, size, &write_n);
     if (n > 0) {
+        sky_metrics_add(sky_selector_metrics(tls->tcp->ev.s)->write_bytes, write_n);
         return (sky_isize_t) write_n;
     }
 #else
     const sky_i32_t max_write = sky_unlikely(size > SKY_I32_MAX) ? SKY_I32_MAX : (sky_i32_t) size;
     const sky_i32_t n = SSL_write(tls->ssl, data, max_write);
     if (n > 0) {
+        sky_metrics_add(sky_selector_metrics(tls->tcp->ev.s)->write_bytes, n);
         return n;
     }
 #endif
@@ -239,6 +294,92 @@ sky_tls_write(sky_tls_t *const tls, const sky_uchar_t *const data, const sky_usi
     return -1;
 }
 
+sky_api sky_isize_t
+sky_tls_write_vec(sky_tls_t *const tls, const sky_io_vec_t *vec, sky_u32_t num) {
+    sky_usize_t size = 0;
+    for (sky_u32_t i = 0; i < num; ++i) {
+        size += vec[i].size;
+    }
+    if (num > 1 && size <= TLS_RECORD_SIZE) { // 合并为一个记录，减少记录头与系统调用
+        sky_uchar_t *p = tls_write_buf;
+        for (sky_u32_t i = 0; i < num; ++i) {
+            sky_memcpy(p, vec[i].buf, vec[i].size);
+            p += vec[i].size;
+        }
+        return sky_tls_write(tls, tls_write_buf, size);
+    }
+
+    sky_isize_t total = 0, n;
+    for (; num > 0; ++vec, --num) {
+        if (!vec->size) {
+            continue;
+        }
+        n = sky_tls_write(tls, vec->buf, vec->size);
+        if (n <= 0) {
+            return total ?: n;
+        }
+        total += n;
+        if ((sky_usize_t) n < vec->size) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+sky_api sky_isize_t
+sky_tls_sendfile(
+        sky_tls_t *const tls,
+        sky_fs_t *const fs,
+        sky_i64_t *const offset,
+        const sky_usize_t size,
+        const sky_uchar_t *const head,
+        const sky_usize_t head_size
+) {
+    sky_isize_t head_n = 0;
+    if (head_size) {
+        head_n = sky_tls_write(tls, head, head_size);
+        if (head_n <= 0 || (sky_usize_t) head_n < head_size || !size) {
+            return head_n;
+        }
+    }
+    if (sky_unlikely(!size)) {
+        return 0;
+    }
+#ifdef SSL_OP_ENABLE_KTLS
+    if (BIO_get_ktls_send(SSL_get_wbio(tls->ssl))) { // 内核加密，文件内容不经过用户态
+        const ossl_ssize_t n = SSL_sendfile(tls->ssl, fs->fd, (off_t) *offset, size, 0);
+        if (n > 0) {
+            *offset += n;
+            sky_metrics_add(sky_selector_metrics(tls->tcp->ev.s)->write_bytes, (sky_u64_t) n);
+            return head_n + n;
+        }
+        if (SSL_get_error(tls->ssl, (sky_i32_t) n) == SSL_ERROR_WANT_WRITE) {
+            sky_ev_clean_write(sky_tcp_ev(tls->tcp));
+            return head_n;
+        }
+        sky_ev_set_error(sky_tcp_ev(tls->tcp));
+        return head_n ?: -1;
+    }
+#endif
+    // 未写完时下次调用会从同一偏移读出相同内容重试，满足 SSL_write 重试要求
+    const sky_isize_t read_n = pread(fs->fd, tls_write_buf, sky_min(size, TLS_RECORD_SIZE), *offset);
+    if (sky_unlikely(read_n <= 0)) {
+        if (read_n < 0 && errno == EINTR) {
+            return head_n;
+        }
+        sky_ev_set_error(sky_tcp_ev(tls->tcp));
+        return -1;
+    }
+    const sky_isize_t n = sky_tls_write(tls, tls_write_buf, (sky_usize_t) read_n);
+    if (n > 0) {
+        *offset += n;
+        return head_n + n;
+    }
+
+    return head_n ?: n;
+}
+
 sky_api sky_i8_t
 sky_tls_shutdown(sky_tls_t *const tls) {
     if (sky_unlikely(!tls->ssl || sky_ev_error(sky_tcp_ev(tls->tcp)) || !sky_tcp_is_connect(tls->tcp))) {
@@ -275,6 +416,10 @@ sky_tls_destroy(sky_tls_t *const tls) {
     if (sky_unlikely(!tls->ssl)) {
         return;
     }
+    if (SSL_is_init_finished(tls->ssl)) {
+        // 未发送 close_notify 的连接释放时 OpenSSL 会将会话标记为不可复用，协议错误已由 OpenSSL 自行作废会话
+        SSL_set_shutdown(tls->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    }
     SSL_free(tls->ssl);
     tls->ssl = null;
 }
@@ -286,7 +431,142 @@ sky_tls_set_sni_hostname(sky_tls_t *const tls, const sky_str_t *const hostname)
 #endif
 }
 
+sky_api sky_bool_t
+sky_tls_get_alpn(const sky_tls_t *const tls, sky_str_t *const out) {
+    const sky_uchar_t *data;
+    sky_u32_t len;
+
+    SSL_get0_alpn_selected(tls->ssl, &data, &len);
+    if (!len) {
+        sky_str_null(out);
+        return false;
+    }
+    out->data = (sky_uchar_t *) data;
+    out->len = len;
+
+    return true;
+}
+
+sky_api sky_bool_t
+sky_tls_session_reused(const sky_tls_t *const tls) {
+    return SSL_session_reused(tls->ssl) == 1;
+}
+
+sky_api sky_bool_t
+sky_tls_set_session(sky_tls_t *const tls, sky_tls_session_t *const session) {
+    return SSL_set_session(tls->ssl, (SSL_SESSION *) session) == 1;
+}
+
+sky_api void
+sky_tls_session_free(sky_tls_session_t *const session) {
+    SSL_SESSION_free((SSL_SESSION *) session);
+}
+
+sky_api sky_bool_t
+sky_tls_ktls_send(const sky_tls_t *const tls) {
+    return tls->ssl && BIO_get_ktls_send(SSL_get_wbio(tls->ssl));
+}
+
+static sky_bool_t
+tls_alpn_init(sky_tls_ctx_t *const ctx, SSL_CTX *const ssl_ctx, const sky_tls_ctx_conf_t *const conf) {
+    sky_usize_t size = 0;
+    for (sky_u32_t i = 0; i < conf->alpn_n; ++i) {
+        if (sky_unlikely(!conf->alpn[i].len || conf->alpn[i].len > 255)) {
+            return false;
+        }
+        size += conf->alpn[i].len + 1;
+    }
+    sky_uchar_t *p = sky_malloc(size);
+    if (sky_unlikely(!p)) {
+        return false;
+    }
+    ctx->alpn = p;
+    ctx->alpn_len = (sky_u32_t) size;
+
+    for (sky_u32_t i = 0; i < conf->alpn_n; ++i) {
+        *(p++) = (sky_uchar_t) conf->alpn[i].len;
+        sky_memcpy(p, conf->alpn[i].data, conf->alpn[i].len);
+        p += conf->alpn[i].len;
+    }
+    if (conf->is_server) {
+        SSL_CTX_set_alpn_select_cb(ssl_ctx, tls_alpn_select, ctx);
+        return true;
+    }
+
+    return SSL_CTX_set_alpn_protos(ssl_ctx, ctx->alpn, ctx->alpn_len) == 0;
+}
+
+/**
+ * 按服务端顺序选择第一个客户端也支持的协议，无交集时不协商 ALPN 继续握手
+ */
+static sky_i32_t
+tls_alpn_select(
+        SSL *const ssl,
+        const sky_uchar_t **const out,
+        sky_uchar_t *const out_len,
+        const sky_uchar_t *const in,
+        const sky_u32_t in_len,
+        void *const arg
+) {
+    (void) ssl;
+    const sky_tls_ctx_t *const ctx = arg;
+
+    if (SSL_select_next_proto(
+            (sky_uchar_t **) out,
+            out_len,
+            ctx->alpn,
+            ctx->alpn_len,
+            in,
+            in_len
+    ) != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    return SSL_TLSEXT_ERR_OK;
+}
+
+static void
+tls_session_init(sky_tls_ctx_t *const ctx, SSL_CTX *const ssl_ctx, const sky_tls_ctx_conf_t *const conf) {
+    SSL_CTX_set_timeout(ssl_ctx, conf->session_timeout ?: 300);
+    if (conf->no_session_ticket) {
+        SSL_CTX_set_options(ssl_ctx, SSL_OP_NO_TICKET);
+    }
+#ifdef SSL_OP_ENABLE_KTLS
+    if (!conf->no_ktls) { // 内核或加密套件不支持时 OpenSSL 自动回退到用户态加密
+        SSL_CTX_set_options(ssl_ctx, SSL_OP_ENABLE_KTLS);
+    }
 #endif
+    if (!conf->is_server) {
+        if (conf->session_cb) {
+            ctx->session_cb = conf->session_cb;
+            SSL_CTX_set_app_data(ssl_ctx, ctx);
+            SSL_CTX_set_session_cache_mode(ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(ssl_ctx, tls_session_new);
+        }
+        return;
+    }
+    static const sky_uchar_t session_id_ctx[] = "sky";
+
+    SSL_CTX_set_session_id_context(ssl_ctx, session_id_ctx, sizeof(session_id_ctx) - 1);
+    SSL_CTX_set_session_cache_mode(ssl_ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ssl_ctx, conf->session_cache_size ?: 20480);
+}
 
+static sky_i32_t
+tls_session_new(SSL *const ssl, SSL_SESSION *const session) {
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (!SSL_SESSION_is_resumable(session)) {
+        return 0;
+    }
+#endif
+    const sky_tls_ctx_t *const ctx = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+    sky_tls_t *const tls = SSL_get_app_data(ssl);
+    if (sky_unlikely(!tls)) {
+        return 0;
+    }
+    ctx->session_cb(tls, (sky_tls_session_t *) session);
 
+    return 1;
+}
 
+#endif
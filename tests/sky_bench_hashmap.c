@@ -0,0 +1,203 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+#include <core/hashmap.h>
+#include <core/rbtree.h>
+#include <core/crc32.h>
+#include <core/memory.h>
+#include <core/string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_GET_N 2000000
+
+typedef struct {
+    sky_rb_node_t node;
+    sky_str_t path;
+    sky_u32_t path_hash;
+} bench_item_t;
+
+static void bench_run(sky_u32_t n);
+
+static bench_item_t *rb_tree_get(sky_rb_tree_t *tree, const sky_str_t *path, sky_u32_t path_hash);
+
+static void rb_tree_insert(sky_rb_tree_t *tree, bench_item_t *item);
+
+static sky_bool_t bench_item_equals(const void *item, const void *key);
+
+static sky_u64_t bench_rand(sky_u64_t *seed);
+
+static sky_u64_t bench_clock_ns();
+
+/**
+ * sky_hashmap_t 与 sky_rb_tree_t(按 crc32c 与路径排序)的随机命中查找对比
+ * 用法: sky_bench_hashmap [数量]，默认依次测试 1000、10000、100000
+ */
+int
+main(const int argc, char **const argv) {
+    if (argc > 1) {
+        const sky_u32_t n = (sky_u32_t) strtoul(argv[1], null, 10);
+        if (!n) {
+            return 1;
+        }
+        bench_run(n);
+        return 0;
+    }
+    bench_run(1000);
+    bench_run(10000);
+    bench_run(100000);
+
+    return 0;
+}
+
+static void
+bench_run(const sky_u32_t n) {
+    bench_item_t *const items = sky_malloc(sizeof(bench_item_t) * n);
+    sky_u32_t *const order = sky_malloc(sizeof(sky_u32_t) * n);
+    sky_uchar_t *const paths = sky_malloc((sky_usize_t) n * 32);
+    sky_u64_t seed = 0x9E3779B97F4A7C15;
+
+    for (sky_u32_t i = 0; i < n; ++i) {
+        bench_item_t *const item = items + i;
+        item->path.data = paths + (sky_usize_t) i * 32;
+        item->path.len = (sky_usize_t) snprintf(
+                (char *) item->path.data,
+                32,
+                "/static/%u/%08llx.js",
+                i,
+                (unsigned long long) (bench_rand(&seed) & SKY_U64(0xFFFFFFFF))
+        );
+        sky_u32_t hash = sky_crc32_init();
+        hash = sky_crc32c_update(hash, item->path.data, item->path.len);
+        item->path_hash = sky_crc32_final(hash);
+        order[i] = i;
+    }
+    for (sky_u32_t i = n - 1; i > 0; --i) { // 打乱查找顺序
+        const sky_u32_t j = (sky_u32_t) (bench_rand(&seed) % (i + 1));
+        const sky_u32_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    sky_rb_tree_t tree;
+    sky_rb_tree_init(&tree);
+    sky_hashmap_t map;
+    sky_hashmap_init(&map, bench_item_equals);
+    for (sky_u32_t i = 0; i < n; ++i) {
+        rb_tree_insert(&tree, items + i);
+        sky_hashmap_put(&map, items[i].path_hash, items + i);
+    }
+
+    sky_u32_t miss = 0;
+    sky_u64_t start = bench_clock_ns();
+    for (sky_u32_t i = 0, j = 0; i < BENCH_GET_N; ++i) {
+        const bench_item_t *const item = items + order[j];
+        if (sky_unlikely(rb_tree_get(&tree, &item->path, item->path_hash) != item)) {
+            ++miss;
+        }
+        if (++j == n) {
+            j = 0;
+        }
+    }
+    const sky_u64_t rb_ns = bench_clock_ns() - start;
+
+    start = bench_clock_ns();
+    for (sky_u32_t i = 0, j = 0; i < BENCH_GET_N; ++i) {
+        const bench_item_t *const item = items + order[j];
+        if (sky_unlikely(sky_hashmap_get(&map, item->path_hash, &item->path) != item)) {
+            ++miss;
+        }
+        if (++j == n) {
+            j = 0;
+        }
+    }
+    const sky_u64_t map_ns = bench_clock_ns() - start;
+
+    printf(
+            "n: %u, rbtree: %.1f ns, hashmap: %.1f ns, miss: %u\n",
+            n,
+            (double) rb_ns / BENCH_GET_N,
+            (double) map_ns / BENCH_GET_N,
+            miss
+    );
+
+    sky_hashmap_destroy(&map);
+    sky_free(paths);
+    sky_free(order);
+    sky_free(items);
+}
+
+static bench_item_t *
+rb_tree_get(sky_rb_tree_t *const tree, const sky_str_t *const path, const sky_u32_t path_hash) {
+    sky_rb_node_t *node = tree->root;
+    bench_item_t *tmp;
+    sky_i32_t r;
+
+    while (node != &tree->sentinel) {
+        tmp = sky_type_convert(node, bench_item_t, node);
+        if (tmp->path_hash == path_hash) {
+            r = sky_str_cmp(&tmp->path, path);
+            if (!r) {
+                return tmp;
+            }
+            node = r > 0 ? node->left : node->right;
+        } else {
+            node = tmp->path_hash > path_hash ? node->left : node->right;
+        }
+    }
+
+    return null;
+}
+
+static void
+rb_tree_insert(sky_rb_tree_t *const tree, bench_item_t *const item) {
+    if (sky_rb_tree_is_empty(tree)) {
+        sky_rb_tree_link(tree, &item->node, null);
+        return;
+    }
+    sky_rb_node_t **p, *temp = tree->root;
+    bench_item_t *other;
+
+    for (;;) {
+        other = sky_type_convert(temp, bench_item_t, node);
+        if (item->path_hash == other->path_hash) {
+            p = sky_str_cmp(&item->path, &other->path) < 0 ? &temp->left : &temp->right;
+        } else {
+            p = item->path_hash < other->path_hash ? &temp->left : &temp->right;
+        }
+
+        if (*p == &tree->sentinel) {
+            *p = &item->node;
+            sky_rb_tree_link(tree, &item->node, temp);
+            return;
+        }
+        temp = *p;
+    }
+}
+
+static sky_bool_t
+bench_item_equals(const void *const item, const void *const key) {
+    const bench_item_t *const tmp = item;
+
+    return sky_str_equals(&tmp->path, (const sky_str_t *) key);
+}
+
+static sky_inline sky_u64_t
+bench_rand(sky_u64_t *const seed) {
+    sky_u64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+
+    return x;
+}
+
+static sky_inline sky_u64_t
+bench_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (sky_u64_t) ts.tv_sec * 1000000000 + (sky_u64_t) ts.tv_nsec;
+}
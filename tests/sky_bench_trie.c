@@ -0,0 +1,351 @@
+//
+// Created by beliefsky on 2023/11/6.
+//
+#include <core/trie.h>
+#include <core/memory.h>
+#include <core/string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ROUTE_N   10000
+#define BENCH_FIND_N    2000000
+
+typedef struct old_trie_node_s old_trie_node_t;
+
+/**
+ * 改为自适应基数树前的节点布局，每个节点固定256个子节点指针，作为对比基线
+ */
+struct old_trie_node_s {
+    old_trie_node_t *next[256];
+    sky_uchar_t *key;
+    sky_usize_t key_n;
+    void *value;
+};
+
+typedef struct {
+    sky_u64_t put_ns;
+    sky_u64_t find_ns;
+    sky_usize_t memory;
+    sky_u32_t miss;
+} bench_result_t;
+
+static void bench_old_trie(const sky_str_t *routes, const sky_u32_t *order, sky_u32_t route_n, bench_result_t *result);
+
+static void bench_trie(const sky_str_t *routes, const sky_u32_t *order, sky_u32_t route_n, bench_result_t *result);
+
+static void bench_print(const char *name, sky_u32_t route_n, const bench_result_t *result);
+
+static void old_trie_put(sky_pool_t *pool, old_trie_node_t *root, const sky_str_t *key, void *value);
+
+static void *old_trie_find(const old_trie_node_t *root, const sky_str_t *key);
+
+static sky_usize_t str_cmp_index(const sky_uchar_t *one, const sky_uchar_t *two, sky_usize_t min_len);
+
+static sky_u64_t bench_rand(sky_u64_t *seed);
+
+static void bench_route(sky_pool_t *pool, sky_str_t *route, sky_u64_t *seed);
+
+static sky_usize_t bench_pool_size(const sky_pool_t *pool);
+
+static sky_u64_t bench_clock_ns();
+
+/**
+ * 路由查找延迟与内存占用，路由为 /seg/seg/hex/seg 形式的随机路径，同时输出旧的256路节点布局作为对比
+ * 用法: sky_bench_trie [路由数量]
+ */
+int
+main(const int argc, char **const argv) {
+    const sky_u32_t route_n = argc > 1 ? (sky_u32_t) strtoul(argv[1], null, 10) : BENCH_ROUTE_N;
+    if (!route_n) {
+        return 1;
+    }
+    sky_pool_t *const key_pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
+    sky_str_t *const routes = sky_malloc(sizeof(sky_str_t) * route_n);
+    sky_u32_t *const order = sky_malloc(sizeof(sky_u32_t) * route_n);
+    sky_u64_t seed = 0x9E3779B97F4A7C15;
+
+    for (sky_u32_t i = 0; i < route_n; ++i) {
+        bench_route(key_pool, routes + i, &seed);
+        order[i] = i;
+    }
+    for (sky_u32_t i = route_n - 1; i > 0; --i) { // 打乱查找顺序
+        const sky_u32_t j = (sky_u32_t) (bench_rand(&seed) % (i + 1));
+        const sky_u32_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    bench_result_t old_result, result;
+    bench_old_trie(routes, order, route_n, &old_result);
+    bench_trie(routes, order, route_n, &result);
+    bench_print("256-way", route_n, &old_result);
+    bench_print("art", route_n, &result);
+
+    sky_pool_destroy(key_pool);
+    sky_free(order);
+    sky_free(routes);
+
+    return (old_result.miss || result.miss) ? 1 : 0;
+}
+
+static void
+bench_old_trie(
+        const sky_str_t *const routes,
+        const sky_u32_t *const order,
+        const sky_u32_t route_n,
+        bench_result_t *const result
+) {
+    sky_pool_t *const pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
+    old_trie_node_t *const root = sky_pcalloc(pool, sizeof(old_trie_node_t));
+
+    sky_u64_t start = bench_clock_ns();
+    for (sky_u32_t i = 0; i < route_n; ++i) {
+        old_trie_put(pool, root, routes + i, (void *) (routes + i));
+    }
+    result->put_ns = bench_clock_ns() - start;
+
+    result->miss = 0;
+    start = bench_clock_ns();
+    for (sky_u32_t i = 0, j = 0; i < BENCH_FIND_N; ++i) {
+        const sky_str_t *const route = routes + order[j];
+        if (sky_unlikely(old_trie_find(root, route) != route)) {
+            ++result->miss;
+        }
+        if (++j == route_n) {
+            j = 0;
+        }
+    }
+    result->find_ns = bench_clock_ns() - start;
+    result->memory = bench_pool_size(pool);
+
+    sky_pool_destroy(pool);
+}
+
+static void
+bench_trie(
+        const sky_str_t *const routes,
+        const sky_u32_t *const order,
+        const sky_u32_t route_n,
+        bench_result_t *const result
+) {
+    sky_pool_t *const pool = sky_pool_create(SKY_POOL_DEFAULT_SIZE);
+    sky_trie_t *const trie = sky_trie_create(pool);
+
+    sky_u64_t start = bench_clock_ns();
+    for (sky_u32_t i = 0; i < route_n; ++i) {
+        sky_trie_put(trie, routes + i, (void *) (routes + i));
+    }
+    result->put_ns = bench_clock_ns() - start;
+
+    result->miss = 0;
+    start = bench_clock_ns();
+    for (sky_u32_t i = 0, j = 0; i < BENCH_FIND_N; ++i) {
+        const sky_str_t *const route = routes + order[j];
+        if (sky_unlikely(sky_trie_find(trie, route) != route)) {
+            ++result->miss;
+        }
+        if (++j == route_n) {
+            j = 0;
+        }
+    }
+    result->find_ns = bench_clock_ns() - start;
+    result->memory = bench_pool_size(pool);
+
+    sky_pool_destroy(pool);
+}
+
+static void
+bench_print(const char *const name, const sky_u32_t route_n, const bench_result_t *const result) {
+    printf(
+            "%-8s routes: %u, memory: %zu bytes (%.1f per route), put: %.1f ns, find: %.1f ns, miss: %u\n",
+            name,
+            route_n,
+            result->memory,
+            (double) result->memory / route_n,
+            (double) result->put_ns / route_n,
+            (double) result->find_ns / BENCH_FIND_N,
+            result->miss
+    );
+}
+
+static void
+old_trie_put(sky_pool_t *const pool, old_trie_node_t *const root, const sky_str_t *const key, void *const value) {
+    old_trie_node_t **k_node, *pre_node, *tmp;
+    sky_uchar_t *tmp_key;
+    sky_usize_t len, index;
+
+    pre_node = root;
+    if (!key || !key->len) {
+        pre_node->value = value;
+        return;
+    }
+    tmp_key = key->data;
+
+    for (;;) {
+        k_node = &pre_node->next[*tmp_key++];
+        tmp = *k_node;
+
+        if (!tmp) {
+            *k_node = tmp = sky_pcalloc(pool, sizeof(old_trie_node_t));
+            tmp->key_n = key->len - (sky_usize_t) (tmp_key - key->data);
+            tmp->key = tmp_key;
+            tmp->value = value;
+
+            return;
+        }
+        len = key->len - (sky_usize_t) (tmp_key - key->data);
+        if (len == tmp->key_n) {
+            if (!len) {
+                tmp->value = value;
+                return;
+            }
+            index = str_cmp_index(tmp->key, tmp_key, len);
+            if (index == len) {
+                tmp->value = value;
+                return;
+            }
+        } else if (len < tmp->key_n) {
+            index = str_cmp_index(tmp->key, tmp_key, len);
+            if (index == len) {
+                *k_node = pre_node = sky_pcalloc(pool, sizeof(old_trie_node_t));
+                pre_node->key_n = len;
+                pre_node->key = tmp_key;
+                pre_node->value = value;
+
+                tmp->key_n -= len + 1;
+                tmp->key += len;
+                pre_node->next[*tmp->key++] = tmp;
+                return;
+            }
+        } else {
+            index = str_cmp_index(tmp->key, tmp_key, tmp->key_n);
+            if (index == tmp->key_n) {
+                tmp_key += index;
+                pre_node = tmp;
+                continue;
+            }
+        }
+        *k_node = pre_node = sky_pcalloc(pool, sizeof(old_trie_node_t));
+        pre_node->key_n = index;
+        pre_node->key = tmp_key;
+
+        tmp->key_n -= index + 1;
+        tmp->key += index;
+        pre_node->next[*tmp->key++] = tmp;
+
+        tmp = sky_pcalloc(pool, sizeof(old_trie_node_t));
+        tmp->key_n = len - index - 1;
+        tmp->key = tmp_key + index;
+        tmp->value = value;
+        pre_node->next[*tmp->key++] = tmp;
+        return;
+    }
+}
+
+static void *
+old_trie_find(const old_trie_node_t *const root, const sky_str_t *const key) {
+    const old_trie_node_t *node, *prev_node;
+    const sky_uchar_t *tmp_key;
+    sky_usize_t len;
+
+    node = root;
+    if (!key || !key->len) {
+        return node->value;
+    }
+    tmp_key = key->data;
+    prev_node = node;
+    for (;;) {
+        node = node->next[*tmp_key++];
+        if (!node) {
+            break;
+        }
+        len = key->len - (sky_usize_t) (tmp_key - key->data);
+
+        if (len == node->key_n) {
+            if (!len || sky_str_len_unsafe_equals(tmp_key, node->key, len)) {
+                if (node->value) {
+                    prev_node = node;
+                }
+            }
+            break;
+        }
+        if (len < node->key_n || !sky_str_len_unsafe_starts_with(tmp_key, node->key, node->key_n)) {
+            break;
+        }
+        tmp_key += node->key_n;
+
+        if (node->value) {
+            prev_node = node;
+        }
+    }
+
+    return prev_node->value;
+}
+
+static sky_inline sky_usize_t
+str_cmp_index(const sky_uchar_t *one, const sky_uchar_t *two, sky_usize_t min_len) {
+    sky_usize_t i;
+
+    i = min_len;
+    while (i && *one++ == *two++) {
+        --i;
+    }
+
+    return min_len - i;
+}
+
+static sky_inline sky_u64_t
+bench_rand(sky_u64_t *const seed) {
+    sky_u64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+
+    return x;
+}
+
+static void
+bench_route(sky_pool_t *const pool, sky_str_t *const route, sky_u64_t *const seed) {
+    static const char *const segments[] = {
+            "api", "v1", "v2", "user", "users", "order", "orders", "item", "items", "admin",
+            "static", "account", "product", "cart", "search", "config", "report", "file"
+    };
+    static const sky_usize_t segment_n = sizeof(segments) / sizeof(segments[0]);
+
+    char tmp[128];
+    const int n = snprintf(
+            tmp,
+            sizeof(tmp),
+            "/%s/%s/%08llx/%s",
+            segments[bench_rand(seed) % segment_n],
+            segments[bench_rand(seed) % segment_n],
+            (unsigned long long) (bench_rand(seed) & SKY_U64(0xFFFFFFFF)),
+            segments[bench_rand(seed) % segment_n]
+    );
+    route->len = (sky_usize_t) n;
+    route->data = sky_pnalloc(pool, route->len);
+    sky_memcpy(route->data, tmp, route->len);
+}
+
+/**
+ * 内存池已申请的块大小之和，trie 节点均小于单块上限，不含大块分配
+ */
+static sky_usize_t
+bench_pool_size(const sky_pool_t *pool) {
+    sky_usize_t size = 0;
+    for (; pool; pool = pool->d.next) {
+        size += (sky_usize_t) (pool->d.end - (const sky_uchar_t *) pool);
+    }
+
+    return size;
+}
+
+static sky_inline sky_u64_t
+bench_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (sky_u64_t) ts.tv_sec * 1000000000 + (sky_u64_t) ts.tv_nsec;
+}
@@ -1,10 +1,12 @@
 //
 // Created by edz on 2021/11/12.
 //
-#include <io/event_loop.h>
+#include <io/event_loop_group.h>
 #include <core/log.h>
 #include <io/http/http_server_file.h>
 
+static void create_server(sky_event_loop_t *loop, sky_u32_t index, void *data);
+
 static sky_bool_t http_index_router(sky_http_server_request_t *req, void *data);
 
 int
@@ -12,7 +14,32 @@ main() {
     setvbuf(stdout, null, _IOLBF, 0);
     setvbuf(stderr, null, _IOLBF, 0);
 
-    sky_event_loop_t *loop = sky_event_loop_create();
+    const sky_str_t alpn[] = {sky_string("http/1.1")};
+    const sky_tls_ctx_conf_t tls_conf = {
+            .crt_file = sky_string("conf/localhost.crt"),
+            .key_file = sky_string("conf/localhost.key"),
+            .alpn = alpn,
+            .alpn_n = 1,
+            .is_server = true
+    };
+    sky_tls_ctx_t tls_ctx;
+    const sky_bool_t tls_ok = sky_tls_ctx_init(&tls_ctx, &tls_conf);
+
+    sky_event_loop_group_t *const group = sky_event_loop_group_create(0);
+
+    sky_event_loop_group_run(group, create_server, tls_ok ? &tls_ctx : null);
+    sky_event_loop_group_destroy(group);
+
+    if (tls_ok) {
+        sky_tls_ctx_destroy(&tls_ctx);
+    }
+
+    return 0;
+}
+
+static void
+create_server(sky_event_loop_t *const loop, const sky_u32_t index, void *const data) {
+    (void) index;
 
     sky_http_server_t *server = sky_http_server_create(loop, null);
 
@@ -31,13 +58,13 @@ main() {
     sky_inet_address_ipv4(&address, 0, 8080);
     sky_http_server_bind(server, &address);
 
+    if (data) {
+        sky_inet_address_ipv4(&address, 0, 8443);
+        sky_http_server_bind_tls(server, &address, data);
+    }
+
     const sky_uchar_t local_ipv6[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
     sky_inet_address_ipv6(&address, local_ipv6, 0, 8080);
-
-    sky_event_loop_run(loop);
-    sky_event_loop_destroy(loop);
-
-    return 0;
 }
 
 